@@ -38,6 +38,7 @@ src/unix/core.c
 src/unix/dl.c
 src/unix/fs.c
 src/unix/getaddrinfo.c
+src/unix/instrument.c
 src/unix/internal.h
 src/unix/loop.c
 src/unix/pipe.c
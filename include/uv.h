@@ -228,11 +228,52 @@ typedef struct uv_cpu_info_s uv_cpu_info_t;
 typedef struct uv_interface_address_s uv_interface_address_t;
 typedef struct uv_dirent_s uv_dirent_t;
 typedef struct uv_passwd_s uv_passwd_t;
+typedef struct uv_rate_limit_s uv_rate_limit_t;
 
 typedef enum {
-  UV_LOOP_BLOCK_SIGNAL
+  UV_LOOP_BLOCK_SIGNAL,
+  UV_LOOP_MEMORY_STATS,
+  UV_LOOP_HANDLE_STATS,
+  UV_LOOP_TRACE,
+  UV_LOOP_RECORD,
+  UV_LOOP_COMPLETION_QUEUE,
+  UV_LOOP_COARSE_CLOCK,
+  UV_LOOP_POLL_BUDGET,
+  UV_LOOP_IO_BUDGET
 } uv_loop_option;
 
+typedef struct {
+  unsigned int reads_per_event;  /* Reads per readable handle and poll. */
+  unsigned int events_per_poll;  /* Events fetched per poll, at most 1024. */
+  unsigned int polls;            /* Polls per iteration, if batches are full. */
+  uint64_t bytes;                /* Bytes read and written per iteration. */
+} uv_io_budget_t;
+
+typedef enum {
+  UV_PRIORITY_LOW = -1,
+  UV_PRIORITY_NORMAL = 0,
+  UV_PRIORITY_HIGH = 1
+} uv_priority;
+
+typedef enum {
+  /* Per-loop categories. */
+  UV_MEM_WATCHERS = 0,
+  UV_MEM_WRITE_QUEUE,
+  UV_MEM_UDP_SEND_QUEUE,
+  /* Process-wide categories. */
+  UV_MEM_FS_BUFS,
+  UV_MEM_FS_PATHS,
+  UV_MEM_SCANDIR,
+  UV_MEM_CATEGORY_MAX
+} uv_mem_category;
+
+typedef struct {
+  uint64_t bytes;        /* Bytes currently allocated. */
+  uint64_t peak_bytes;   /* High-water mark of bytes. */
+  uint64_t count;        /* Allocations currently live. */
+  uint64_t total_count;  /* Allocations since accounting was enabled. */
+} uv_mem_stats_t;
+
 typedef enum {
   UV_RUN_DEFAULT = 0,
   UV_RUN_ONCE,
@@ -271,10 +312,91 @@ UV_EXTERN void uv_loop_delete(uv_loop_t*);
 UV_EXTERN size_t uv_loop_size(void);
 UV_EXTERN int uv_loop_alive(const uv_loop_t* loop);
 UV_EXTERN int uv_loop_configure(uv_loop_t* loop, uv_loop_option option, ...);
+UV_EXTERN int uv_loop_mem_stats(const uv_loop_t* loop,
+                                uv_mem_category category,
+                                uv_mem_stats_t* stats);
+
+typedef struct {
+  uint64_t elapsed;            /* Nanoseconds the loop has been busy. */
+  uv_handle_type handle_type;  /* UV_UNKNOWN_HANDLE if no handle callback. */
+  uv_req_type req_type;        /* UV_UNKNOWN_REQ if no request callback. */
+  void* object;                /* The running handle or request, or NULL. */
+  void (*cb)(void);            /* Its callback, or NULL. */
+} uv_stall_info_t;
+
+typedef void (*uv_stall_cb)(uv_loop_t* loop, const uv_stall_info_t* info);
+
+UV_EXTERN int uv_loop_watchdog_start(uv_loop_t* loop,
+                                     uint64_t threshold,
+                                     int signum,
+                                     uv_stall_cb cb);
+UV_EXTERN int uv_loop_watchdog_stop(uv_loop_t* loop);
+
+UV_EXTERN int uv_loop_trace_dump(uv_loop_t* loop, /*FILE*/void* stream);
+
+/* Files written by UV_LOOP_RECORD: UV_RECORD_MAGIC, then uv_record_t records
+ * in host byte order.
+ */
+#define UV_RECORD_MAGIC "uvrec01\n"
+
+typedef enum {
+  UV_RECORD_ITERATION = 1,  /* value: duration. */
+  UV_RECORD_POLL,           /* value: duration, fd: number of events. */
+  UV_RECORD_IO,             /* fd, value: UV_READABLE etc. */
+  UV_RECORD_READ,           /* fd, type: handle type, value: bytes. */
+  UV_RECORD_WRITE,          /* fd, type: handle type, value: bytes. */
+  UV_RECORD_HANDLE_CB,      /* fd or -1, type: handle type, value: duration. */
+  UV_RECORD_REQ_CB          /* type: request type, value: duration. */
+} uv_record_kind;
+
+typedef struct {
+  uint64_t time;   /* Nanoseconds since recording started. */
+  uint64_t value;
+  int32_t fd;
+  uint16_t kind;
+  uint16_t type;
+} uv_record_t;
+
+typedef enum {
+  UV_COMPLETION_READ = 1,    /* object: stream, base: buffer, result: nread. */
+  UV_COMPLETION_WRITE,       /* object: uv_write_t, result: status. */
+  UV_COMPLETION_CONNECT,     /* object: uv_connect_t, result: status. */
+  UV_COMPLETION_SHUTDOWN,    /* object: uv_shutdown_t, result: status. */
+  UV_COMPLETION_CONNECTION,  /* object: server stream, result: status. */
+  UV_COMPLETION_FS,          /* object: uv_fs_t, result: req->result. */
+  UV_COMPLETION_TIMER        /* object: uv_timer_t. */
+} uv_completion_kind;
+
+typedef struct {
+  void* object;  /* The handle or request. */
+  char* base;    /* UV_COMPLETION_READ: the buffer from the alloc callback. */
+  int64_t result;
+  uv_completion_kind kind;
+} uv_completion_t;
+
+UV_EXTERN int uv_loop_drain(uv_loop_t* loop,
+                            uv_completion_t* completions,
+                            unsigned int n);
 
 UV_EXTERN int uv_run(uv_loop_t*, uv_run_mode mode);
+UV_EXTERN int uv_run_budget(uv_loop_t* loop, uint64_t budget);
+UV_EXTERN int uv_loop_prepare(uv_loop_t* loop);
+UV_EXTERN int uv_loop_dispatch(uv_loop_t* loop);
 UV_EXTERN void uv_stop(uv_loop_t*);
 
+typedef enum {
+  UV_DEFER_NEXT_ITERATION,  /* At the start of the next loop iteration. */
+  UV_DEFER_AFTER_TIMERS,    /* After the timers have run. */
+  UV_DEFER_AFTER_POLL       /* After the poll for i/o, before check handles. */
+} uv_defer_phase;
+
+typedef void (*uv_defer_cb)(uv_loop_t* loop, void* arg);
+
+UV_EXTERN int uv_defer(uv_loop_t* loop,
+                       uv_defer_phase phase,
+                       uv_defer_cb cb,
+                       void* arg);
+
 UV_EXTERN void uv_ref(uv_handle_t*);
 UV_EXTERN void uv_unref(uv_handle_t*);
 UV_EXTERN int uv_has_ref(const uv_handle_t*);
@@ -295,6 +417,7 @@ typedef void (*uv_write_cb)(uv_write_t* req, int status);
 typedef void (*uv_connect_cb)(uv_connect_t* req, int status);
 typedef void (*uv_shutdown_cb)(uv_shutdown_t* req, int status);
 typedef void (*uv_connection_cb)(uv_stream_t* server, int status);
+typedef void (*uv_idle_timeout_cb)(uv_stream_t* stream);
 typedef void (*uv_close_cb)(uv_handle_t* handle);
 typedef void (*uv_poll_cb)(uv_poll_t* handle, int status, int events);
 typedef void (*uv_timer_cb)(uv_timer_t* handle);
@@ -421,6 +544,19 @@ UV_EXTERN int uv_is_active(const uv_handle_t* handle);
 
 UV_EXTERN void uv_walk(uv_loop_t* loop, uv_walk_cb walk_cb, void* arg);
 
+typedef struct {
+  uint64_t time;           /* Nanoseconds spent in the handle's callbacks. */
+  uint64_t calls;          /* Number of callback invocations. */
+  uint64_t bytes_read;
+  uint64_t bytes_written;
+} uv_handle_stats_t;
+
+UV_EXTERN int uv_handle_get_stats(const uv_handle_t* handle,
+                                  uv_handle_stats_t* stats);
+UV_EXTERN int uv_walk_by_cost(uv_loop_t* loop,
+                              uv_walk_cb walk_cb,
+                              void* arg);
+
 /* Helpers for ad hoc debugging, no API/ABI stability guaranteed. */
 UV_EXTERN void uv_print_all_handles(uv_loop_t* loop, /*FILE*/void* stream);
 UV_EXTERN void uv_print_active_handles(uv_loop_t* loop, /*FILE*/void* stream);
@@ -432,6 +568,11 @@ UV_EXTERN int uv_recv_buffer_size(uv_handle_t* handle, int* value);
 
 UV_EXTERN int uv_fileno(const uv_handle_t* handle, uv_os_fd_t* fd);
 
+UV_EXTERN int uv_handle_set_priority(uv_handle_t* handle, uv_priority priority);
+UV_EXTERN uv_priority uv_handle_get_priority(const uv_handle_t* handle);
+UV_EXTERN int uv_handle_set_read_budget(uv_handle_t* handle,
+                                        unsigned int reads);
+
 UV_EXTERN uv_buf_t uv_buf_init(char* base, unsigned int len);
 
 UV_EXTERN int uv_pipe(uv_os_fd_t fds[2], int read_flags, int write_flags);
@@ -560,6 +701,40 @@ UV_EXTERN int uv_is_writable(const uv_stream_t* handle);
 
 UV_EXTERN int uv_stream_set_blocking(uv_stream_t* handle, int blocking);
 
+enum uv_idle_timeout_flags {
+  UV_IDLE_TIMEOUT_READ = 1,
+  UV_IDLE_TIMEOUT_WRITE = 2
+};
+
+UV_EXTERN int uv_stream_set_idle_timeout(uv_stream_t* handle,
+                                         unsigned int flags,
+                                         uint64_t timeout,
+                                         uv_idle_timeout_cb cb);
+
+/*
+ * uv_rate_limit_t is a token bucket that can be shared by several handles.
+ */
+struct uv_rate_limit_s {
+  void* data;
+  /* read-only */
+  uv_loop_t* loop;
+  uint64_t rate;
+  uint64_t burst;
+  /* private */
+  UV_RATE_LIMIT_PRIVATE_FIELDS
+};
+
+UV_EXTERN int uv_rate_limit_init(uv_loop_t* loop,
+                                 uv_rate_limit_t* limit,
+                                 uint64_t rate,
+                                 uint64_t burst);
+UV_EXTERN int uv_rate_limit_set(uv_rate_limit_t* limit,
+                                uint64_t rate,
+                                uint64_t burst);
+UV_EXTERN int uv_stream_set_rate_limit(uv_stream_t* handle,
+                                       uv_rate_limit_t* read_limit,
+                                       uv_rate_limit_t* write_limit);
+
 UV_EXTERN int uv_is_closing(const uv_handle_t* handle);
 
 
@@ -699,6 +874,9 @@ UV_EXTERN int uv_udp_recv_start(uv_udp_t* handle,
                                 uv_alloc_cb alloc_cb,
                                 uv_udp_recv_cb recv_cb);
 UV_EXTERN int uv_udp_recv_stop(uv_udp_t* handle);
+UV_EXTERN int uv_udp_set_rate_limit(uv_udp_t* handle,
+                                    uv_rate_limit_t* recv_limit,
+                                    uv_rate_limit_t* send_limit);
 
 
 /*
@@ -1573,6 +1751,7 @@ struct uv_loop_s {
 #undef UV_WORK_PRIVATE_FIELDS
 #undef UV_FS_EVENT_PRIVATE_FIELDS
 #undef UV_SIGNAL_PRIVATE_FIELDS
+#undef UV_RATE_LIMIT_PRIVATE_FIELDS
 #undef UV_LOOP_PRIVATE_FIELDS
 #undef UV_LOOP_PRIVATE_PLATFORM_FIELDS
 
@@ -0,0 +1,868 @@
+/* Copyright libuv project contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Header-only C++20 binding: coroutines for streams, TCP, pipes, UDP,
+ * timers, file system requests and the threadpool, and RAII for handles.
+ *
+ * Awaiters embed their request, so a co_await doesn't allocate anything
+ * beyond the coroutine frame it lives in.  Handles are allocated once by
+ * init() and closed by their destructor.  Errors are UV_E* codes, exactly
+ * like the C API; no exceptions are thrown.
+ *
+ * A coroutine must not be destroyed while it's suspended on libuv, and the
+ * loop must not run with UV_LOOP_COMPLETION_QUEUE.  The binding owns the
+ * `data` field of every handle and request it creates.
+ */
+
+#ifndef UV_CORO_HPP
+#define UV_CORO_HPP
+
+#if __cplusplus < 202002L && (!defined(_MSVC_LANG) || _MSVC_LANG < 202002L)
+# error "uv/coro.hpp requires C++20"
+#endif
+
+#include "uv.h"
+
+#include <coroutine>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace uv {
+
+template <typename T = void>
+class task;
+
+namespace detail {
+
+struct promise_base {
+  std::coroutine_handle<> continuation;
+  bool started = false;
+  bool detached = false;
+
+  struct final_awaiter {
+    bool await_ready() const noexcept { return false; }
+
+    template <typename P>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<P> h) const noexcept {
+      promise_base& p = h.promise();
+      if (p.continuation)
+        return p.continuation;
+      if (p.detached)
+        h.destroy();
+      return std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  final_awaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() const noexcept { std::terminate(); }
+};
+
+template <typename T>
+struct promise : promise_base {
+  std::optional<T> value;
+
+  task<T> get_return_object() noexcept;
+
+  template <typename U>
+  void return_value(U&& v) {
+    value.emplace(std::forward<U>(v));
+  }
+};
+
+template <>
+struct promise<void> : promise_base {
+  task<void> get_return_object() noexcept;
+  void return_void() const noexcept {}
+};
+
+/* Something a coroutine waits for on a handle.  `result` is set before the
+ * coroutine is resumed: UV_ECANCELED when the handle was closed under it.
+ */
+struct waiter {
+  std::coroutine_handle<> coro;
+  ssize_t result = 0;
+};
+
+/* Heap storage of a handle.  `handle` comes first so that the box and the
+ * handle share an address.
+ */
+template <typename H>
+struct handle_box {
+  H handle;
+  waiter* waiting = nullptr;
+  unsigned int pending = 0;  /* Connections not accepted yet. */
+  int status = 0;            /* Error reported to the connection callback. */
+};
+
+template <typename H>
+handle_box<H>* box_of(void* handle) noexcept {
+  return static_cast<handle_box<H>*>(static_cast<uv_handle_t*>(handle)->data);
+}
+
+template <typename H>
+void wake(handle_box<H>* box, ssize_t result) noexcept {
+  waiter* w;
+
+  w = box->waiting;
+  box->waiting = nullptr;
+  w->result = result;
+  w->coro.resume();
+}
+
+/* Awaiter that embeds a request completing with a status code. */
+template <typename Req>
+class req_awaiter {
+ public:
+  req_awaiter() noexcept = default;
+  req_awaiter(const req_awaiter&) = delete;
+  req_awaiter& operator=(const req_awaiter&) = delete;
+
+  bool await_ready() const noexcept { return false; }
+  int await_resume() const noexcept { return result_; }
+
+ protected:
+  /* Finish await_suspend(): suspend unless starting the request failed. */
+  bool started(std::coroutine_handle<> h, int err) noexcept {
+    result_ = err;
+    coro_ = h;
+    return err == 0;
+  }
+
+  static void on_status(Req* req, int status) {
+    req_awaiter* self;
+
+    self = static_cast<req_awaiter*>(req->data);
+    self->result_ = status;
+    self->coro_.resume();
+  }
+
+  Req req_;
+  std::coroutine_handle<> coro_;
+  int result_ = 0;
+};
+
+}  // namespace detail
+
+
+/* A lazily started coroutine returning T.  co_await it from another task,
+ * or start it from plain code with start() or detach().
+ */
+template <typename T>
+class task {
+ public:
+  using promise_type = detail::promise<T>;
+
+  task() noexcept = default;
+  explicit task(std::coroutine_handle<promise_type> h) noexcept : h_(h) {}
+  task(task&& other) noexcept : h_(std::exchange(other.h_, {})) {}
+  task(const task&) = delete;
+
+  task& operator=(task&& other) noexcept {
+    if (this != &other) {
+      if (h_)
+        h_.destroy();
+      h_ = std::exchange(other.h_, {});
+    }
+    return *this;
+  }
+
+  ~task() {
+    if (h_)
+      h_.destroy();
+  }
+
+  bool done() const noexcept { return !h_ || h_.done(); }
+
+  /* Run until the first suspension point.  The task object must outlive
+   * the coroutine; check done() and result() after running the loop.
+   */
+  void start() {
+    h_.promise().started = true;
+    h_.resume();
+  }
+
+  /* Like start(), but the coroutine frees itself when it finishes. */
+  void detach() && {
+    std::coroutine_handle<promise_type> h;
+
+    h = std::exchange(h_, {});
+    h.promise().started = true;
+    h.promise().detached = true;
+    h.resume();
+  }
+
+  /* The value of a finished task. */
+  T result() {
+    if constexpr (!std::is_void_v<T>)
+      return std::move(*h_.promise().value);
+  }
+
+  /* Run the task, or wait for it if it was started already. */
+  auto operator co_await() && noexcept {
+    struct awaiter {
+      std::coroutine_handle<promise_type> h;
+
+      bool await_ready() const noexcept { return h.done(); }
+
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<> caller) const noexcept {
+        h.promise().continuation = caller;
+        if (h.promise().started)
+          return std::noop_coroutine();
+        h.promise().started = true;
+        return h;
+      }
+
+      T await_resume() const {
+        if constexpr (!std::is_void_v<T>)
+          return std::move(*h.promise().value);
+      }
+    };
+
+    return awaiter{h_};
+  }
+
+ private:
+  std::coroutine_handle<promise_type> h_;
+};
+
+template <typename T>
+task<T> detail::promise<T>::get_return_object() noexcept {
+  return task<T>(std::coroutine_handle<promise<T>>::from_promise(*this));
+}
+
+inline task<void> detail::promise<void>::get_return_object() noexcept {
+  return task<void>(std::coroutine_handle<promise<void>>::from_promise(*this));
+}
+
+
+/* Owner of a libuv handle.  Empty until init() succeeds; the destructor
+ * closes the handle, the memory is released by its close callback.  A
+ * coroutine still waiting on the handle resumes with UV_ECANCELED.
+ */
+template <typename H>
+class handle {
+ public:
+  handle() noexcept = default;
+  handle(handle&& other) noexcept : box_(std::exchange(other.box_, nullptr)) {}
+  handle(const handle&) = delete;
+
+  handle& operator=(handle&& other) noexcept {
+    if (this != &other) {
+      close();
+      box_ = std::exchange(other.box_, nullptr);
+    }
+    return *this;
+  }
+
+  ~handle() { close(); }
+
+  H* get() const noexcept { return box_ ? &box_->handle : nullptr; }
+  uv_loop_t* loop() const noexcept { return box_->handle.loop; }
+  explicit operator bool() const noexcept { return box_ != nullptr; }
+
+  void ref() noexcept { uv_ref(raw()); }
+  void unref() noexcept { uv_unref(raw()); }
+
+  void close() noexcept {
+    if (box_ != nullptr)
+      uv_close(raw(), &on_close);
+    box_ = nullptr;
+  }
+
+ protected:
+  template <typename Init, typename... Args>
+  int init_with(Init init, uv_loop_t* loop, Args... args) noexcept {
+    detail::handle_box<H>* box;
+    int err;
+
+    close();
+    box = new (std::nothrow) detail::handle_box<H>();
+    if (box == nullptr)
+      return UV_ENOMEM;
+
+    err = init(loop, &box->handle, args...);
+    if (err) {
+      delete box;
+      return err;
+    }
+
+    box->handle.data = box;
+    box_ = box;
+    return 0;
+  }
+
+  uv_handle_t* raw() const noexcept {
+    return reinterpret_cast<uv_handle_t*>(&box_->handle);
+  }
+
+  detail::handle_box<H>* box_ = nullptr;
+
+ private:
+  static void on_close(uv_handle_t* h) {
+    detail::handle_box<H>* box;
+    detail::waiter* w;
+
+    box = detail::box_of<H>(h);
+    w = box->waiting;
+    delete box;
+
+    if (w != nullptr) {
+      w->result = UV_ECANCELED;
+      w->coro.resume();
+    }
+  }
+};
+
+
+class timer : public handle<uv_timer_t> {
+ public:
+  int init(uv_loop_t* loop) noexcept { return init_with(uv_timer_init, loop); }
+
+  class sleep_awaiter : public detail::waiter {
+   public:
+    sleep_awaiter(detail::handle_box<uv_timer_t>* box, uint64_t timeout)
+        noexcept : box_(box), timeout_(timeout) {}
+    sleep_awaiter(const sleep_awaiter&) = delete;
+
+    bool await_ready() const noexcept { return false; }
+    int await_resume() const noexcept { return (int) result; }
+
+    bool await_suspend(std::coroutine_handle<> h) noexcept {
+      coro = h;
+      box_->waiting = this;
+      result = uv_timer_start(&box_->handle, &on_timer, timeout_, 0);
+      if (result == 0)
+        return true;
+      box_->waiting = nullptr;
+      return false;
+    }
+
+   private:
+    static void on_timer(uv_timer_t* t) {
+      detail::wake(detail::box_of<uv_timer_t>(t), 0);
+    }
+
+    detail::handle_box<uv_timer_t>* box_;
+    uint64_t timeout_;
+  };
+
+  /* Resume after `timeout` milliseconds with 0. */
+  sleep_awaiter sleep(uint64_t timeout) noexcept {
+    return sleep_awaiter(box_, timeout);
+  }
+};
+
+
+/* Operations common to all stream handles.  Only one coroutine at a time
+ * may wait in read() or accept(); any number of writes can be in flight.
+ */
+template <typename H>
+class stream : public handle<H> {
+ public:
+  uv_stream_t* get_stream() const noexcept {
+    return reinterpret_cast<uv_stream_t*>(this->get());
+  }
+
+  class read_awaiter : public detail::waiter {
+   public:
+    read_awaiter(detail::handle_box<H>* box, uv_buf_t buf) noexcept
+        : box_(box), buf_(buf) {}
+    read_awaiter(const read_awaiter&) = delete;
+
+    bool await_ready() const noexcept { return false; }
+    ssize_t await_resume() const noexcept { return result; }
+
+    bool await_suspend(std::coroutine_handle<> h) noexcept {
+      coro = h;
+      box_->waiting = this;
+      result = uv_read_start(reinterpret_cast<uv_stream_t*>(&box_->handle),
+                             &on_alloc,
+                             &on_read);
+      if (result == 0)
+        return true;
+      box_->waiting = nullptr;
+      return false;
+    }
+
+   private:
+    static void on_alloc(uv_handle_t* h, size_t, uv_buf_t* buf) {
+      *buf = static_cast<read_awaiter*>(detail::box_of<H>(h)->waiting)->buf_;
+    }
+
+    static void on_read(uv_stream_t* s, ssize_t nread, const uv_buf_t*) {
+      if (nread == 0)
+        return;  /* EAGAIN, keep waiting. */
+      uv_read_stop(s);
+      detail::wake(detail::box_of<H>(s), nread);
+    }
+
+    detail::handle_box<H>* box_;
+    uv_buf_t buf_;
+  };
+
+  class write_awaiter : public detail::req_awaiter<uv_write_t> {
+   public:
+    write_awaiter(uv_stream_t* s, const uv_buf_t* bufs, unsigned int nbufs)
+        noexcept : stream_(s), bufs_(bufs), nbufs_(nbufs) {}
+    write_awaiter(uv_stream_t* s, uv_buf_t buf) noexcept
+        : stream_(s), bufs_(nullptr), nbufs_(1), buf_(buf) {}
+
+    bool await_suspend(std::coroutine_handle<> h) noexcept {
+      req_.data = this;
+      return started(h, uv_write(&req_,
+                                 stream_,
+                                 bufs_ != nullptr ? bufs_ : &buf_,
+                                 nbufs_,
+                                 &on_status));
+    }
+
+   private:
+    uv_stream_t* stream_;
+    const uv_buf_t* bufs_;
+    unsigned int nbufs_;
+    uv_buf_t buf_;
+  };
+
+  class shutdown_awaiter : public detail::req_awaiter<uv_shutdown_t> {
+   public:
+    explicit shutdown_awaiter(uv_stream_t* s) noexcept : stream_(s) {}
+
+    bool await_suspend(std::coroutine_handle<> h) noexcept {
+      req_.data = this;
+      return started(h, uv_shutdown(&req_, stream_, &on_status));
+    }
+
+   private:
+    uv_stream_t* stream_;
+  };
+
+  template <typename Client>
+  class accept_awaiter : public detail::waiter {
+   public:
+    accept_awaiter(detail::handle_box<H>* box, Client* client) noexcept
+        : box_(box), client_(client) {}
+    accept_awaiter(const accept_awaiter&) = delete;
+
+    bool await_ready() const noexcept {
+      return box_->pending > 0 || box_->status < 0;
+    }
+
+    void await_suspend(std::coroutine_handle<> h) noexcept {
+      coro = h;
+      box_->waiting = this;
+    }
+
+    int await_resume() noexcept {
+      int err;
+
+      if (result < 0)
+        return (int) result;  /* The server was closed. */
+
+      if (box_->status < 0) {
+        err = box_->status;
+        box_->status = 0;
+        return err;
+      }
+
+      box_->pending--;
+      return uv_accept(reinterpret_cast<uv_stream_t*>(&box_->handle),
+                       client_->get_stream());
+    }
+
+   private:
+    detail::handle_box<H>* box_;
+    Client* client_;
+  };
+
+  /* Resume with the number of bytes read into `buf`, UV_EOF or an error. */
+  read_awaiter read(uv_buf_t buf) noexcept {
+    return read_awaiter(this->box_, buf);
+  }
+
+  /* The buffers must stay valid until the write resumes. */
+  write_awaiter write(const uv_buf_t* bufs, unsigned int nbufs) noexcept {
+    return write_awaiter(get_stream(), bufs, nbufs);
+  }
+
+  write_awaiter write(uv_buf_t buf) noexcept {
+    return write_awaiter(get_stream(), buf);
+  }
+
+  shutdown_awaiter shutdown() noexcept {
+    return shutdown_awaiter(get_stream());
+  }
+
+  /* Start listening; connections are taken with accept(). */
+  int listen(int backlog) noexcept {
+    return uv_listen(get_stream(), backlog, &on_connection);
+  }
+
+  /* Resume with the result of uv_accept() once a connection is pending.
+   * `client` must have been initialized.
+   */
+  template <typename Client>
+  accept_awaiter<Client> accept(Client& client) noexcept {
+    return accept_awaiter<Client>(this->box_, &client);
+  }
+
+ private:
+  static void on_connection(uv_stream_t* s, int status) {
+    detail::handle_box<H>* box;
+
+    box = detail::box_of<H>(s);
+    if (status < 0)
+      box->status = status;
+    else
+      box->pending++;
+
+    if (box->waiting != nullptr)
+      detail::wake(box, 0);
+  }
+};
+
+
+class connect_awaiter : public detail::req_awaiter<uv_connect_t> {
+ public:
+  connect_awaiter(uv_tcp_t* tcp, const struct sockaddr* addr) noexcept
+      : tcp_(tcp), pipe_(nullptr), addr_(addr), name_(nullptr) {}
+  connect_awaiter(uv_pipe_t* pipe, const char* name) noexcept
+      : tcp_(nullptr), pipe_(pipe), addr_(nullptr), name_(name) {}
+
+  bool await_suspend(std::coroutine_handle<> h) noexcept {
+    req_.data = this;
+    if (tcp_ != nullptr)
+      return started(h, uv_tcp_connect(&req_, tcp_, addr_, &on_status));
+    uv_pipe_connect(&req_, pipe_, name_, &on_status);
+    return started(h, 0);
+  }
+
+ private:
+  uv_tcp_t* tcp_;
+  uv_pipe_t* pipe_;
+  const struct sockaddr* addr_;
+  const char* name_;
+};
+
+
+class tcp : public stream<uv_tcp_t> {
+ public:
+  int init(uv_loop_t* loop) noexcept { return init_with(uv_tcp_init, loop); }
+
+  int bind(const struct sockaddr* addr, unsigned int flags = 0) noexcept {
+    return uv_tcp_bind(get(), addr, flags);
+  }
+
+  int nodelay(bool enable) noexcept { return uv_tcp_nodelay(get(), enable); }
+
+  /* `addr` must stay valid until the connect resumes. */
+  connect_awaiter connect(const struct sockaddr* addr) noexcept {
+    return connect_awaiter(get(), addr);
+  }
+};
+
+
+class pipe : public stream<uv_pipe_t> {
+ public:
+  int init(uv_loop_t* loop, bool ipc = false) noexcept {
+    return init_with(uv_pipe_init, loop, (int) ipc);
+  }
+
+  int open(uv_os_fd_t fd) noexcept { return uv_pipe_open(get(), fd); }
+  int bind(const char* name) noexcept { return uv_pipe_bind(get(), name); }
+
+  connect_awaiter connect(const char* name) noexcept {
+    return connect_awaiter(get(), name);
+  }
+};
+
+
+struct udp_datagram {
+  ssize_t nread;  /* Bytes received or an error code. */
+  struct sockaddr_storage addr;
+  unsigned int flags;
+};
+
+class udp : public handle<uv_udp_t> {
+ public:
+  int init(uv_loop_t* loop) noexcept { return init_with(uv_udp_init, loop); }
+
+  int bind(const struct sockaddr* addr, unsigned int flags = 0) noexcept {
+    return uv_udp_bind(get(), addr, flags);
+  }
+
+  class send_awaiter : public detail::req_awaiter<uv_udp_send_t> {
+   public:
+    send_awaiter(uv_udp_t* udp, uv_buf_t buf, const struct sockaddr* addr)
+        noexcept : udp_(udp), buf_(buf), addr_(addr) {}
+
+    bool await_suspend(std::coroutine_handle<> h) noexcept {
+      req_.data = this;
+      return started(h, uv_udp_send(&req_, udp_, &buf_, 1, addr_, &on_status));
+    }
+
+   private:
+    uv_udp_t* udp_;
+    uv_buf_t buf_;
+    const struct sockaddr* addr_;
+  };
+
+  class recv_awaiter : public detail::waiter {
+   public:
+    recv_awaiter(detail::handle_box<uv_udp_t>* box, uv_buf_t buf) noexcept
+        : box_(box), buf_(buf) {}
+    recv_awaiter(const recv_awaiter&) = delete;
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> h) noexcept {
+      coro = h;
+      box_->waiting = this;
+      result = uv_udp_recv_start(&box_->handle, &on_alloc, &on_recv);
+      if (result == 0)
+        return true;
+      box_->waiting = nullptr;
+      return false;
+    }
+
+    udp_datagram await_resume() const noexcept {
+      udp_datagram d = datagram_;
+      d.nread = result;
+      return d;
+    }
+
+   private:
+    static void on_alloc(uv_handle_t* h, size_t, uv_buf_t* buf) {
+      *buf = static_cast<recv_awaiter*>(
+          detail::box_of<uv_udp_t>(h)->waiting)->buf_;
+    }
+
+    static void on_recv(uv_udp_t* h,
+                        ssize_t nread,
+                        const uv_buf_t*,
+                        const struct sockaddr* addr,
+                        unsigned int flags) {
+      detail::handle_box<uv_udp_t>* box;
+      recv_awaiter* self;
+
+      if (nread == 0 && addr == nullptr)
+        return;  /* Nothing to read, keep waiting. */
+
+      box = detail::box_of<uv_udp_t>(h);
+      self = static_cast<recv_awaiter*>(box->waiting);
+      if (addr != nullptr) {
+        std::memcpy(&self->datagram_.addr,
+                    addr,
+                    addr->sa_family == AF_INET6 ? sizeof(struct sockaddr_in6)
+                                                : sizeof(struct sockaddr_in));
+      }
+      self->datagram_.flags = flags;
+      uv_udp_recv_stop(h);
+      detail::wake(box, nread);
+    }
+
+    detail::handle_box<uv_udp_t>* box_;
+    uv_buf_t buf_;
+    udp_datagram datagram_ = {};
+  };
+
+  /* `addr` must stay valid until the send resumes. */
+  send_awaiter send(uv_buf_t buf, const struct sockaddr* addr) noexcept {
+    return send_awaiter(get(), buf, addr);
+  }
+
+  /* Resume with the next datagram, received into `buf`. */
+  recv_awaiter recv(uv_buf_t buf) noexcept {
+    return recv_awaiter(box_, buf);
+  }
+};
+
+
+namespace detail {
+
+struct fs_result {
+  static ssize_t get(const uv_fs_t* req) noexcept { return req->result; }
+};
+
+}  // namespace detail
+
+struct fs_stat_result {
+  int status;
+  uv_stat_t stat;
+
+  static fs_stat_result get(const uv_fs_t* req) noexcept {
+    return fs_stat_result{(int) req->result, req->statbuf};
+  }
+};
+
+/* Awaiter for a uv_fs_*() function, which is a template argument so that
+ * each operation gets its own callback trampoline.  The request is cleaned
+ * up when the awaiter goes away, after the coroutine has seen the result.
+ */
+template <auto Fn, typename Result, typename... Args>
+class fs_awaiter {
+ public:
+  explicit fs_awaiter(uv_loop_t* loop, Args... args) noexcept
+      : loop_(loop), args_(args...) {}
+  fs_awaiter(const fs_awaiter&) = delete;
+  ~fs_awaiter() { uv_fs_req_cleanup(&req_); }
+
+  bool await_ready() const noexcept { return false; }
+  auto await_resume() const noexcept { return Result::get(&req_); }
+
+  bool await_suspend(std::coroutine_handle<> h) noexcept {
+    int err;
+
+    coro_ = h;
+    req_.data = this;
+    err = std::apply([this](Args... args) {
+      return Fn(loop_, &req_, args..., &on_done);
+    }, args_);
+
+    if (err < 0) {
+      req_.result = err;
+      return false;
+    }
+
+    return true;
+  }
+
+ private:
+  static void on_done(uv_fs_t* req) {
+    static_cast<fs_awaiter*>(req->data)->coro_.resume();
+  }
+
+  uv_loop_t* loop_;
+  std::tuple<Args...> args_;
+  uv_fs_t req_ = {};
+  std::coroutine_handle<> coro_;
+};
+
+/* Each resumes with the request's result: a file descriptor, a byte count,
+ * 0 or an error code.  Paths and buffers must stay valid until then.
+ */
+inline auto fs_open(uv_loop_t* loop, const char* path, int flags, int mode) {
+  return fs_awaiter<uv_fs_open, detail::fs_result, const char*, int, int>(
+      loop, path, flags, mode);
+}
+
+inline auto fs_close(uv_loop_t* loop, uv_os_fd_t file) {
+  return fs_awaiter<uv_fs_close, detail::fs_result, uv_os_fd_t>(loop, file);
+}
+
+inline auto fs_read(uv_loop_t* loop,
+                    uv_os_fd_t file,
+                    const uv_buf_t* bufs,
+                    unsigned int nbufs,
+                    int64_t offset) {
+  return fs_awaiter<uv_fs_read,
+                    detail::fs_result,
+                    uv_os_fd_t,
+                    const uv_buf_t*,
+                    unsigned int,
+                    int64_t>(loop, file, bufs, nbufs, offset);
+}
+
+inline auto fs_write(uv_loop_t* loop,
+                     uv_os_fd_t file,
+                     const uv_buf_t* bufs,
+                     unsigned int nbufs,
+                     int64_t offset) {
+  return fs_awaiter<uv_fs_write,
+                    detail::fs_result,
+                    uv_os_fd_t,
+                    const uv_buf_t*,
+                    unsigned int,
+                    int64_t>(loop, file, bufs, nbufs, offset);
+}
+
+inline auto fs_unlink(uv_loop_t* loop, const char* path) {
+  return fs_awaiter<uv_fs_unlink, detail::fs_result, const char*>(loop, path);
+}
+
+/* Resumes with an fs_stat_result. */
+inline auto fs_stat(uv_loop_t* loop, const char* path) {
+  return fs_awaiter<uv_fs_stat, fs_stat_result, const char*>(loop, path);
+}
+
+inline auto fs_fstat(uv_loop_t* loop, uv_os_fd_t file) {
+  return fs_awaiter<uv_fs_fstat, fs_stat_result, uv_os_fd_t>(loop, file);
+}
+
+
+/* Run `fn` on the threadpool and resume with the after-work status, which
+ * is UV_ECANCELED if the work was cancelled before it ran.
+ */
+template <typename F>
+class work_awaiter {
+ public:
+  template <typename G>
+  work_awaiter(uv_loop_t* loop, G&& fn)
+      : loop_(loop), fn_(std::forward<G>(fn)) {}
+  work_awaiter(const work_awaiter&) = delete;
+
+  bool await_ready() const noexcept { return false; }
+  int await_resume() const noexcept { return result_; }
+
+  bool await_suspend(std::coroutine_handle<> h) noexcept {
+    coro_ = h;
+    req_.data = this;
+    result_ = uv_queue_work(loop_, &req_, &on_work, &on_after_work);
+    return result_ == 0;
+  }
+
+ private:
+  static void on_work(uv_work_t* req) {
+    static_cast<work_awaiter*>(req->data)->fn_();
+  }
+
+  static void on_after_work(uv_work_t* req, int status) {
+    work_awaiter* self;
+
+    self = static_cast<work_awaiter*>(req->data);
+    self->result_ = status;
+    self->coro_.resume();
+  }
+
+  uv_loop_t* loop_;
+  F fn_;
+  uv_work_t req_;
+  std::coroutine_handle<> coro_;
+  int result_ = 0;
+};
+
+template <typename F>
+work_awaiter<std::decay_t<F>> queue_work(uv_loop_t* loop, F&& fn) {
+  return work_awaiter<std::decay_t<F>>(loop, std::forward<F>(fn));
+}
+
+}  // namespace uv
+
+#endif  /* UV_CORO_HPP */
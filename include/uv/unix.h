@@ -81,7 +81,9 @@
 #endif
 
 struct uv__io_s;
+struct uv__throttle_s;
 struct uv_loop_s;
+struct uv_rate_limit_s;
 
 typedef void (*uv__io_cb)(struct uv_loop_s* loop,
                           struct uv__io_s* w,
@@ -95,9 +97,34 @@ struct uv__io_s {
   unsigned int pevents; /* Pending event mask i.e. mask at next tick. */
   unsigned int events;  /* Current event mask. */
   int fd;
+  int priority; /* uv_priority, only the epoll backend looks at it. */
   UV_IO_PRIVATE_PLATFORM_FIELDS
 };
 
+typedef void (*uv__throttle_cb)(struct uv__throttle_s* t);
+typedef struct uv__throttle_s uv__throttle_t;
+
+/* One direction of a rate limited handle.  Queued on its limiter while the
+ * handle waits for tokens; cb restarts the I/O once they are there.
+ */
+struct uv__throttle_s {
+  uv__throttle_cb cb;
+  struct uv_rate_limit_s* limit;
+  void* queue[2];
+};
+
+/* Dense array of the active prepare, check or idle handles of a loop, see
+ * src/loop-watcher.c.  Stopped handles leave a hole that is compacted away
+ * when the array is not being walked.
+ */
+typedef struct {
+  void* entries;
+  unsigned int count;
+  unsigned int size;
+  unsigned int holes;
+  int running;
+} uv__watcher_list_t;
+
 #ifndef UV_PLATFORM_SEM_T
 # define UV_PLATFORM_SEM_T sem_t
 #endif
@@ -193,22 +220,26 @@ typedef struct {
   int backend_fd;                                                             \
   void* pending_queue[2];                                                     \
   void* watcher_queue[2];                                                     \
-  uv__io_t** watchers;                                                        \
+  void** watchers;                                                            \
   unsigned int nwatchers;                                                     \
   unsigned int nfds;                                                          \
+  void* poll_events;                                                          \
+  unsigned int poll_nevents;                                                  \
   void* wq[2];                                                                \
   uv_mutex_t wq_mutex;                                                        \
   uv_async_t wq_async;                                                        \
   uv_rwlock_t cloexec_lock;                                                   \
   uv_handle_t* closing_handles;                                               \
   void* process_handles[2];                                                   \
-  void* prepare_handles[2];                                                   \
-  void* check_handles[2];                                                     \
-  void* idle_handles[2];                                                      \
+  uv__watcher_list_t prepare_handles;                                         \
+  uv__watcher_list_t check_handles;                                           \
+  uv__watcher_list_t idle_handles;                                            \
   void* async_handles[2];                                                     \
   void (*async_unused)(void);  /* TODO(bnoordhuis) Remove in libuv v2. */     \
   uv__io_t async_io_watcher;                                                  \
   int async_wfd;                                                              \
+  int async_pending;                                                          \
+  int async_awake;                                                            \
   struct {                                                                    \
     void* min;                                                                \
     unsigned int nelts;                                                       \
@@ -219,6 +250,18 @@ typedef struct {
   uv__io_t signal_io_watcher;                                                 \
   uv_signal_t child_watcher;                                                  \
   int emfile_fd;                                                              \
+  void* mem_stats;                                                            \
+  void* instrument;                                                           \
+  uint64_t run_deadline;                                                      \
+  void* completions;                                                          \
+  void* idle_wheel;                                                           \
+  void* rate_limits;                                                          \
+  void* defer_queues;                                                         \
+  unsigned int defer_count;                                                   \
+  unsigned int poll_budget;                                                   \
+  unsigned int priority_watchers;                                             \
+  uv_io_budget_t io_budget;                                                   \
+  uint64_t io_bytes;                                                          \
   UV_PLATFORM_LOOP_FIELDS                                                     \
 
 #define UV_REQ_TYPE_PRIVATE /* empty */
@@ -252,6 +295,7 @@ typedef struct {
 #define UV_HANDLE_PRIVATE_FIELDS                                              \
   uv_handle_t* next_closing;                                                  \
   unsigned int flags;                                                         \
+  void* stats;                                                                \
 
 #define UV_STREAM_PRIVATE_FIELDS                                              \
   uv_connect_t *connect_req;                                                  \
@@ -263,6 +307,14 @@ typedef struct {
   int delayed_error;                                                          \
   int accepted_fd;                                                            \
   void* queued_fds;                                                           \
+  uv_idle_timeout_cb idle_cb;                                                 \
+  uint64_t idle_timeout;                                                      \
+  uint64_t idle_last;                                                         \
+  void* idle_queue[2];                                                        \
+  unsigned int idle_flags;                                                    \
+  uv__throttle_t read_throttle;                                               \
+  uv__throttle_t write_throttle;                                              \
+  unsigned int read_budget;                                                   \
   UV_STREAM_PRIVATE_PLATFORM_FIELDS                                           \
 
 #define UV_TCP_PRIVATE_FIELDS /* empty */
@@ -273,6 +325,9 @@ typedef struct {
   uv__io_t io_watcher;                                                        \
   void* write_queue[2];                                                       \
   void* write_completed_queue[2];                                             \
+  uv__throttle_t recv_throttle;                                               \
+  uv__throttle_t send_throttle;                                               \
+  unsigned int read_budget;                                                   \
 
 #define UV_PIPE_PRIVATE_FIELDS                                                \
   const char* pipe_fname; /* strdup'ed */
@@ -282,15 +337,15 @@ typedef struct {
 
 #define UV_PREPARE_PRIVATE_FIELDS                                             \
   uv_prepare_cb prepare_cb;                                                   \
-  void* queue[2];                                                             \
+  unsigned int index;                                                         \
 
 #define UV_CHECK_PRIVATE_FIELDS                                               \
   uv_check_cb check_cb;                                                       \
-  void* queue[2];                                                             \
+  unsigned int index;                                                         \
 
 #define UV_IDLE_PRIVATE_FIELDS                                                \
   uv_idle_cb idle_cb;                                                         \
-  void* queue[2];                                                             \
+  unsigned int index;                                                         \
 
 #define UV_ASYNC_PRIVATE_FIELDS                                               \
   uv_async_cb async_cb;                                                       \
@@ -364,4 +419,11 @@ typedef struct {
   uv_fs_event_cb cb;                                                          \
   UV_PLATFORM_FS_EVENT_FIELDS                                                 \
 
+#define UV_RATE_LIMIT_PRIVATE_FIELDS                                          \
+  int64_t tokens; /* In units of 1/1000 byte. */                              \
+  uint64_t refill_time;                                                       \
+  uint64_t wake_time;                                                         \
+  void* throttled[2];                                                         \
+  void* loop_queue[2];                                                        \
+
 #endif /* UV_UNIX_H */
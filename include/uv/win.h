@@ -179,6 +179,18 @@ typedef struct {
   char* errmsg;
 } uv_lib_t;
 
+/* Dense array of the active prepare, check or idle handles of a loop, see
+ * src/loop-watcher.c.  Stopped handles leave a hole that is compacted away
+ * when the array is not being walked.
+ */
+typedef struct {
+  void* entries;
+  unsigned int count;
+  unsigned int size;
+  unsigned int holes;
+  int running;
+} uv__watcher_list_t;
+
 #define UV_LOOP_PRIVATE_FIELDS                                                \
     /* The loop's I/O completion port */                                      \
   HANDLE iocp;                                                                \
@@ -197,9 +209,9 @@ typedef struct {
   } timer_heap;                                                               \
   uint64_t timer_counter;                                                     \
   /* Lists of active loop (prepare / check / idle) watchers */                \
-  void* prepare_handles[2];                                                   \
-  void* check_handles[2];                                                     \
-  void* idle_handles[2];                                                      \
+  uv__watcher_list_t prepare_handles;                                         \
+  uv__watcher_list_t check_handles;                                           \
+  uv__watcher_list_t idle_handles;                                            \
   /* This handle holds the peer sockets for the fast variant of uv_poll_t */  \
   SOCKET poll_peer_sockets[UV_MSAFD_PROVIDER_COUNT];                          \
   /* Threadpool */                                                            \
@@ -403,15 +415,15 @@ typedef struct {
   LONG volatile async_sent;
 
 #define UV_PREPARE_PRIVATE_FIELDS                                             \
-  void* queue[2];                                                             \
+  unsigned int index;                                                         \
   uv_prepare_cb prepare_cb;
 
 #define UV_CHECK_PRIVATE_FIELDS                                               \
-  void* queue[2];                                                             \
+  unsigned int index;                                                         \
   uv_check_cb check_cb;
 
 #define UV_IDLE_PRIVATE_FIELDS                                                \
-  void* queue[2];                                                             \
+  unsigned int index;                                                         \
   uv_idle_cb idle_cb;
 
 #define UV_HANDLE_PRIVATE_FIELDS                                              \
@@ -496,6 +508,8 @@ typedef struct {
   struct uv_req_s signal_req;                                                 \
   unsigned long pending_signum;
 
+#define UV_RATE_LIMIT_PRIVATE_FIELDS /* empty */
+
 #ifndef F_OK
 #define F_OK 0
 #endif
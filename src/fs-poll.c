@@ -224,6 +224,12 @@ static void timer_close_cb(uv_handle_t* handle) {
 }
 
 
+/* The stat requests drive the handle, they can't wait for uv_loop_drain(). */
+int uv__fs_poll_owns(const uv_fs_t* req) {
+  return req->cb == poll_cb;
+}
+
+
 static int statbuf_eq(const uv_stat_t* a, const uv_stat_t* b) {
   return a->st_ctim.tv_nsec == b->st_ctim.tv_nsec
       && a->st_mtim.tv_nsec == b->st_mtim.tv_nsec
@@ -19,10 +19,77 @@
  * IN THE SOFTWARE.
  */
 
+
 #include "uv.h"
 #include "uv-common.h"
 
+#include <string.h>
+
+/* Prepare, check and idle handles live in a dense per-loop array of
+ * { callback, handle } pairs so that running them is a linear walk that
+ * never touches a handle until its callback is due.  Every handle knows its
+ * slot, which makes starting (append) and stopping O(1).  A handle stopped
+ * while the array is walked only leaves a hole; holes are compacted away
+ * before the next walk, or when the array fills up outside of a walk.
+ *
+ * The array is walked back to front so that, as before, the most recently
+ * started handle runs first.  Handles started from a callback land past the
+ * point where the walk began and first run on the next loop iteration.
+ */
+
+#define UV__WATCHER_LIST_MIN 16
+
+static int uv__watcher_list_grow(uv__watcher_list_t* list, size_t entry_size) {
+  unsigned int size;
+  void* entries;
+
+  size = list->size == 0 ? UV__WATCHER_LIST_MIN : list->size * 2;
+  entries = uv__realloc(list->entries, size * entry_size);
+  if (entries == NULL)
+    return UV_ENOMEM;
+
+  list->entries = entries;
+  list->size = size;
+  return 0;
+}
+
+
+void uv__loop_watchers_init(uv_loop_t* loop) {
+  memset(&loop->prepare_handles, 0, sizeof(loop->prepare_handles));
+  memset(&loop->check_handles, 0, sizeof(loop->check_handles));
+  memset(&loop->idle_handles, 0, sizeof(loop->idle_handles));
+}
+
+
+void uv__loop_watchers_close(uv_loop_t* loop) {
+  uv__free(loop->prepare_handles.entries);
+  uv__free(loop->check_handles.entries);
+  uv__free(loop->idle_handles.entries);
+  uv__loop_watchers_init(loop);
+}
+
+
 #define UV_LOOP_WATCHER_DEFINE(name, type)                                    \
+  struct uv__##name##_entry {                                                 \
+    uv_##name##_cb cb;                                                        \
+    uv_##name##_t* handle;                                                    \
+  };                                                                          \
+                                                                              \
+  static void uv__##name##_compact(uv__watcher_list_t* list) {                \
+    struct uv__##name##_entry* entries;                                       \
+    unsigned int i;                                                           \
+    unsigned int n;                                                           \
+    entries = list->entries;                                                  \
+    for (i = 0, n = 0; i < list->count; i++) {                                \
+      if (entries[i].handle == NULL)                                          \
+        continue;                                                             \
+      entries[i].handle->index = n;                                           \
+      entries[n++] = entries[i];                                              \
+    }                                                                         \
+    list->count = n;                                                          \
+    list->holes = 0;                                                          \
+  }                                                                           \
+                                                                              \
   int uv_##name##_init(uv_loop_t* loop, uv_##name##_t* handle) {              \
     uv__handle_init(loop, (uv_handle_t*)handle, UV_##type);                   \
     handle->name##_cb = NULL;                                                 \
@@ -30,33 +97,63 @@
   }                                                                           \
                                                                               \
   int uv_##name##_start(uv_##name##_t* handle, uv_##name##_cb cb) {           \
+    uv__watcher_list_t* list;                                                 \
+    struct uv__##name##_entry* e;                                             \
     if (uv__is_active(handle)) return 0;                                      \
     if (cb == NULL) return UV_EINVAL;                                         \
-    QUEUE_INSERT_HEAD(&handle->loop->name##_handles, &handle->queue);         \
+    list = &handle->loop->name##_handles;                                     \
+    if (list->count == list->size) {                                          \
+      if (list->holes > 0 && !list->running)                                  \
+        uv__##name##_compact(list);                                           \
+      else if (uv__watcher_list_grow(list, sizeof(*e)))                       \
+        return UV_ENOMEM;                                                     \
+    }                                                                         \
+    e = (struct uv__##name##_entry*) list->entries + list->count;             \
+    e->cb = cb;                                                               \
+    e->handle = handle;                                                       \
+    handle->index = list->count++;                                            \
     handle->name##_cb = cb;                                                   \
     uv__handle_start(handle);                                                 \
     return 0;                                                                 \
   }                                                                           \
                                                                               \
   int uv_##name##_stop(uv_##name##_t* handle) {                               \
+    uv__watcher_list_t* list;                                                 \
+    struct uv__##name##_entry* e;                                             \
     if (!uv__is_active(handle)) return 0;                                     \
-    QUEUE_REMOVE(&handle->queue);                                             \
+    list = &handle->loop->name##_handles;                                     \
+    e = (struct uv__##name##_entry*) list->entries + handle->index;           \
+    if (handle->index + 1 == list->count && !list->running) {                 \
+      list->count--;                                                          \
+    } else {                                                                  \
+      e->handle = NULL;                                                       \
+      list->holes++;                                                          \
+    }                                                                         \
     uv__handle_stop(handle);                                                  \
     return 0;                                                                 \
   }                                                                           \
                                                                               \
   void uv__run_##name(uv_loop_t* loop) {                                      \
+    uv__watcher_list_t* list;                                                 \
+    struct uv__##name##_entry* e;                                             \
+    struct uv__cb_frame frame;                                                \
     uv_##name##_t* h;                                                         \
-    QUEUE queue;                                                              \
-    QUEUE* q;                                                                 \
-    QUEUE_MOVE(&loop->name##_handles, &queue);                                \
-    while (!QUEUE_EMPTY(&queue)) {                                            \
-      q = QUEUE_HEAD(&queue);                                                 \
-      h = QUEUE_DATA(q, uv_##name##_t, queue);                                \
-      QUEUE_REMOVE(q);                                                        \
-      QUEUE_INSERT_TAIL(&loop->name##_handles, q);                            \
-      h->name##_cb(h);                                                        \
+    unsigned int i;                                                           \
+    list = &loop->name##_handles;                                             \
+    if (list->holes > 0)                                                      \
+      uv__##name##_compact(list);                                             \
+    list->running = 1;                                                        \
+    for (i = list->count; i-- > 0;) {                                         \
+      /* Reload, a callback that starts a handle may move the array. */       \
+      e = (struct uv__##name##_entry*) list->entries + i;                     \
+      h = e->handle;                                                          \
+      if (h == NULL)                                                          \
+        continue;                                                             \
+      UV__CB_ENTER(loop, &frame, h);                                          \
+      e->cb(h);                                                               \
+      UV__CB_LEAVE(loop, &frame);                                             \
     }                                                                         \
+    list->running = 0;                                                        \
   }                                                                           \
                                                                               \
   void uv__##name##_close(uv_##name##_t* handle) {                            \
@@ -80,7 +80,9 @@ static void worker(void* arg) {
       break;
 
     w = QUEUE_DATA(q, struct uv__work, wq);
+    UV__PROBE2(work__start, w->loop, w);
     w->work(w);
+    UV__PROBE2(work__end, w->loop, w);
 
     uv_mutex_lock(&w->loop->wq_mutex);
     w->work = NULL;  /* Signal uv_cancel() that the work req is done
@@ -221,6 +223,7 @@ void uv__work_done(uv_async_t* handle) {
 
     w = container_of(q, struct uv__work, wq);
     err = (w->work == uv__cancelled) ? UV_ECANCELED : 0;
+    UV__PROBE2(work__done, loop, w);
     w->done(w, err);
   }
 }
@@ -234,6 +237,7 @@ static void uv__queue_work(struct uv__work* w) {
 
 
 static void uv__queue_done(struct uv__work* w, int err) {
+  struct uv__cb_frame frame;
   uv_work_t* req;
 
   req = container_of(w, uv_work_t, work_req);
@@ -242,7 +246,9 @@ static void uv__queue_done(struct uv__work* w, int err) {
   if (req->after_work_cb == NULL)
     return;
 
+  UV__REQ_CB_ENTER(req->loop, &frame, req, req->after_work_cb);
   req->after_work_cb(req, err);
+  UV__CB_LEAVE(req->loop, &frame);
 }
 
 
@@ -146,6 +146,7 @@ int uv__next_timeout(const uv_loop_t* loop) {
 
 
 void uv__run_timers(uv_loop_t* loop) {
+  struct uv__cb_frame frame;
   struct heap_node* heap_node;
   uv_timer_t* handle;
 
@@ -160,7 +161,13 @@ void uv__run_timers(uv_loop_t* loop) {
 
     uv_timer_stop(handle);
     uv_timer_again(handle);
+
+    if (UV__COMPLETION_QUEUED(loop, UV_COMPLETION_TIMER, handle, NULL, 0))
+      continue;
+
+    UV__CB_ENTER(loop, &frame, handle);
     handle->timer_cb(handle);
+    UV__CB_LEAVE(loop, &frame);
   }
 }
 
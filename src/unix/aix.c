@@ -197,13 +197,15 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
 
   assert(timeout >= -1);
   base = loop->time;
-  count = 48; /* Benchmarks suggest this gives the best throughput. */
+  count = loop->io_budget.polls;
 
   for (;;) {
+    UV__POLL_ENTER(loop, timeout);
     nfds = pollset_poll(loop->backend_fd,
                         events,
                         ARRAY_SIZE(events),
                         timeout);
+    SAVE_ERRNO(UV__POLL_LEAVE(loop, nfds));
 
     /* Update loop->time unconditionally. It's tempting to skip the update when
      * timeout == 0 (i.e. non-blocking poll) but there is no guarantee that the
@@ -234,9 +236,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     have_signals = 0;
     nevents = 0;
 
-    assert(loop->watchers != NULL);
-    loop->watchers[loop->nwatchers] = (void*) events;
-    loop->watchers[loop->nwatchers + 1] = (void*) (uintptr_t) nfds;
+    loop->poll_events = events;
+    loop->poll_nevents = nfds;
 
     for (i = 0; i < nfds; i++) {
       pe = events + i;
@@ -250,7 +251,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
       assert(pc.fd >= 0);
       assert((unsigned) pc.fd < loop->nwatchers);
 
-      w = loop->watchers[pc.fd];
+      w = uv__io_watcher(loop, pc.fd);
 
       if (w == NULL) {
         /* File descriptor that we've stopped watching, disarm it.
@@ -262,6 +263,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
         continue;
       }
 
+      UV__IO_EVENT(loop, w->fd, pe->revents);
+
       /* Run signal watchers last.  This also affects child process watchers
        * because those are implemented in terms of signal watchers.
        */
@@ -276,13 +279,16 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     if (have_signals != 0)
       loop->signal_io_watcher.cb(loop, &loop->signal_io_watcher, POLLIN);
 
-    loop->watchers[loop->nwatchers] = NULL;
-    loop->watchers[loop->nwatchers + 1] = NULL;
+    loop->poll_events = NULL;
+    loop->poll_nevents = 0;
 
     if (have_signals != 0)
       return;  /* Event loop should cycle now so don't poll again. */
 
     if (nevents != 0) {
+      if (uv__io_budget_spent(loop))
+        return;
+
       if (nfds == ARRAY_SIZE(events) && --count != 0) {
         /* Poll for more events but don't block this time. */
         timeout = 0;
@@ -1217,10 +1223,8 @@ void uv__platform_invalidate_fd(uv_loop_t* loop, int fd) {
   uintptr_t nfds;
   struct poll_ctl pc;
 
-  assert(loop->watchers != NULL);
-
-  events = (struct pollfd*) loop->watchers[loop->nwatchers];
-  nfds = (uintptr_t) loop->watchers[loop->nwatchers + 1];
+  events = (struct pollfd*) loop->poll_events;
+  nfds = loop->poll_nevents;
 
   if (events != NULL)
     /* Invalidate events with same file descriptor */
@@ -33,6 +33,7 @@
 #include <string.h>
 #include <unistd.h>
 
+static void uv__async_dispatch(uv_loop_t* loop);
 static void uv__async_send(uv_loop_t* loop);
 static int uv__async_start(uv_loop_t* loop);
 static int uv__async_eventfd(void);
@@ -61,13 +62,57 @@ int uv_async_send(uv_async_t* handle) {
   if (ACCESS_ONCE(int, handle->pending) != 0)
     return 0;
 
-  if (cmpxchgi(&handle->pending, 0, 1) == 0)
-    uv__async_send(handle->loop);
+  if (cmpxchgi(&handle->pending, 0, 1) != 0)
+    return 0;
+
+  /* Only the first send since the loop last looked needs to wake it up, and
+   * only when it may be blocked in the poll phase.  An awake loop checks
+   * loop->async_pending before it blocks, see uv__async_sleep().  The
+   * cmpxchg is a full barrier, which orders the store to async_pending
+   * before the load of async_awake.
+   */
+  if (cmpxchgi(&handle->loop->async_pending, 0, 1) == 0)
+    if (ACCESS_ONCE(int, handle->loop->async_awake) == 0)
+      uv__async_send(handle->loop);
 
   return 0;
 }
 
 
+/* Called by the loop thread before it blocks.  Returns nonzero if sends are
+ * pending that skipped the wakeup, in which case the caller must not block.
+ */
+int uv__async_sleep(uv_loop_t* loop) {
+  /* Full barrier: the store to async_awake must be visible before we look
+   * at async_pending, or a concurrent send and this check could both miss.
+   */
+  if (cmpxchgi(&loop->async_awake, 1, 0) == 0)
+    return 0;  /* Wasn't awake, every send since has woken us up. */
+
+  return ACCESS_ONCE(int, loop->async_pending);
+}
+
+
+/* Called by the loop thread after the poll phase, runs the callbacks of
+ * pending sends.
+ */
+void uv__async_wake(uv_loop_t* loop) {
+  loop->async_awake = 1;
+  if (ACCESS_ONCE(int, loop->async_pending) != 0)
+    uv__async_dispatch(loop);
+}
+
+
+/* Called when the loop thread returns control to the embedder.  Sends that
+ * skipped the wakeup are still pending, wake up whoever polls the loop next:
+ * uv_run() or an embedder that watches the backend fd.
+ */
+void uv__async_leave(uv_loop_t* loop) {
+  if (uv__async_sleep(loop))
+    uv__async_send(loop);
+}
+
+
 void uv__async_close(uv_async_t* handle) {
   QUEUE_REMOVE(&handle->queue);
   uv__handle_stop(handle);
@@ -77,9 +122,6 @@ void uv__async_close(uv_async_t* handle) {
 static void uv__async_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
   char buf[1024];
   ssize_t r;
-  QUEUE queue;
-  QUEUE* q;
-  uv_async_t* h;
 
   assert(w == &loop->async_io_watcher);
 
@@ -101,6 +143,25 @@ static void uv__async_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
     abort();
   }
 
+  /* The callbacks run from uv__async_wake() once the poll phase is over and
+   * the loop counts as awake, so sends from inside them don't write to the
+   * wakeup fd again.
+   */
+}
+
+
+static void uv__async_dispatch(uv_loop_t* loop) {
+  struct uv__cb_frame frame;
+  QUEUE queue;
+  QUEUE* q;
+  uv_async_t* h;
+
+  /* Clear the flag before looking at the handles, a send that comes in
+   * after this sets it again and is picked up by the next dispatch.
+   */
+  if (cmpxchgi(&loop->async_pending, 1, 0) == 0)
+    return;
+
   QUEUE_MOVE(&loop->async_handles, &queue);
   while (!QUEUE_EMPTY(&queue)) {
     q = QUEUE_HEAD(&queue);
@@ -115,7 +176,9 @@ static void uv__async_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
     if (h->async_cb == NULL)
       continue;
 
+    UV__CB_ENTER(loop, &frame, h);
     h->async_cb(h);
+    UV__CB_LEAVE(loop, &frame);
   }
 }
 
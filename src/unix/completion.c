@@ -0,0 +1,205 @@
+/* Copyright libuv project contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "internal.h"
+
+/* Completions waiting for uv_loop_drain().  A ring buffer whose size is a
+ * power of two; it grows instead of dropping completions when it fills up.
+ */
+struct uv__completions {
+  unsigned int head;  /* Next completion to drain. */
+  unsigned int tail;  /* Next free slot. */
+  unsigned int mask;
+  uv_completion_t* ring;
+};
+
+
+static int uv__completion_resize(struct uv__completions* cq,
+                                 unsigned int size) {
+  uv_completion_t* ring;
+  unsigned int count;
+  unsigned int i;
+
+  ring = uv__malloc(size * sizeof(*ring));
+  if (ring == NULL)
+    return UV_ENOMEM;
+
+  count = cq->tail - cq->head;
+  for (i = 0; i < count; i++)
+    ring[i] = cq->ring[(cq->head + i) & cq->mask];
+
+  uv__free(cq->ring);
+  cq->ring = ring;
+  cq->mask = size - 1;
+  cq->head = 0;
+  cq->tail = count;
+
+  return 0;
+}
+
+
+void uv__completion_loop_close(uv_loop_t* loop) {
+  struct uv__completions* cq;
+
+  cq = loop->completions;
+  if (cq == NULL)
+    return;
+
+  uv__free(cq->ring);
+  uv__free(cq);
+  loop->completions = NULL;
+}
+
+
+int uv__completion_enable(uv_loop_t* loop, unsigned int size) {
+  struct uv__completions* cq;
+  unsigned int n;
+  int err;
+
+  cq = loop->completions;
+
+  if (size == 0) {
+    if (cq == NULL)
+      return 0;
+    if (cq->head != cq->tail)
+      return UV_EBUSY;
+    uv__completion_loop_close(loop);
+    return 0;
+  }
+
+  if (size > (1u << 24))
+    return UV_EINVAL;
+
+  for (n = 1; n < size; n *= 2);
+
+  if (cq == NULL) {
+    cq = uv__calloc(1, sizeof(*cq));
+    if (cq == NULL)
+      return UV_ENOMEM;
+  }
+
+  /* Never shrink below what's queued. */
+  while (n < cq->tail - cq->head)
+    n *= 2;
+
+  err = uv__completion_resize(cq, n);
+  if (err) {
+    if (loop->completions == NULL)
+      uv__free(cq);
+    return err;
+  }
+
+  loop->completions = cq;
+  return 0;
+}
+
+
+int uv__completion_add(uv_loop_t* loop,
+                       uv_completion_kind kind,
+                       void* object,
+                       char* base,
+                       int64_t result) {
+  struct uv__completions* cq;
+  uv_completion_t* c;
+
+  switch (kind) {
+    case UV_COMPLETION_READ:
+    case UV_COMPLETION_CONNECTION:
+    case UV_COMPLETION_TIMER:
+      if (((uv_handle_t*) object)->flags & UV__HANDLE_INTERNAL)
+        return UV_EINVAL;
+      break;
+    case UV_COMPLETION_FS:
+      if (uv__fs_poll_owns(object))
+        return UV_EINVAL;
+      break;
+    default:
+      break;
+  }
+
+  cq = loop->completions;
+
+  /* Run the callback after all if the ring can't grow. */
+  if (cq->tail - cq->head > cq->mask)
+    if (uv__completion_resize(cq, 2 * (cq->mask + 1)))
+      return UV_ENOMEM;
+
+  c = &cq->ring[cq->tail++ & cq->mask];
+  c->object = object;
+  c->base = base;
+  c->result = result;
+  c->kind = kind;
+
+  return 0;
+}
+
+
+/* Called right before the close callback, which may free the handle.  Its
+ * queued records stay, so a READ buffer can still be released, but no
+ * longer point at it.
+ */
+void uv__completion_handle_close(uv_handle_t* handle) {
+  struct uv__completions* cq;
+  uv_completion_t* c;
+  unsigned int i;
+
+  cq = handle->loop->completions;
+  if (cq == NULL)
+    return;
+
+  for (i = cq->head; i != cq->tail; i++) {
+    c = &cq->ring[i & cq->mask];
+    if (c->object != handle)
+      continue;
+
+    switch (c->kind) {
+      case UV_COMPLETION_READ:
+      case UV_COMPLETION_CONNECTION:
+      case UV_COMPLETION_TIMER:
+        c->object = NULL;
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+
+int uv_loop_drain(uv_loop_t* loop,
+                  uv_completion_t* completions,
+                  unsigned int n) {
+  struct uv__completions* cq;
+  unsigned int i;
+
+  cq = loop->completions;
+  if (cq == NULL)
+    return UV_EINVAL;
+
+  if (n > cq->tail - cq->head)
+    n = cq->tail - cq->head;
+
+  for (i = 0; i < n; i++)
+    completions[i] = cq->ring[cq->head++ & cq->mask];
+
+  return n;
+}
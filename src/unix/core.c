@@ -273,6 +273,8 @@ static void uv__finish_close(uv_handle_t* handle) {
 
   uv__handle_unref(handle);
   QUEUE_REMOVE(&handle->handle_queue);
+  uv__instrument_handle_close(handle);
+  uv__completion_handle_close(handle);
 
   if (handle->close_cb) {
     handle->close_cb(handle);
@@ -312,7 +314,10 @@ int uv_backend_timeout(const uv_loop_t* loop) {
   if (!uv__has_active_handles(loop) && !uv__has_active_reqs(loop))
     return 0;
 
-  if (!QUEUE_EMPTY(&loop->idle_handles))
+  if (!uv__watcher_list_empty(&loop->idle_handles))
+    return 0;
+
+  if (loop->defer_count != 0)
     return 0;
 
   if (!QUEUE_EMPTY(&loop->pending_queue))
@@ -328,6 +333,7 @@ int uv_backend_timeout(const uv_loop_t* loop) {
 static int uv__loop_alive(const uv_loop_t* loop) {
   return uv__has_active_handles(loop) ||
          uv__has_active_reqs(loop) ||
+         loop->defer_count != 0 ||
          loop->closing_handles != NULL;
 }
 
@@ -337,6 +343,26 @@ int uv_loop_alive(const uv_loop_t* loop) {
 }
 
 
+/* The first half of an iteration, up to the wait for i/o.  Returns non-zero
+ * if pending callbacks ran.
+ */
+static int uv__run_prepare_phase(uv_loop_t* loop) {
+  int ran_pending;
+
+  UV__ITERATION_START(loop);
+  loop->io_bytes = 0;
+  uv__update_time(loop);
+  uv__run_deferred(loop, UV_DEFER_NEXT_ITERATION);
+  uv__run_timers(loop);
+  uv__run_deferred(loop, UV_DEFER_AFTER_TIMERS);
+  ran_pending = uv__run_pending(loop);
+  uv__run_idle(loop);
+  uv__run_prepare(loop);
+
+  return ran_pending;
+}
+
+
 int uv_run(uv_loop_t* loop, uv_run_mode mode) {
   int timeout;
   int r;
@@ -346,18 +372,24 @@ int uv_run(uv_loop_t* loop, uv_run_mode mode) {
   if (!r)
     uv__update_time(loop);
 
+  /* While the loop is awake, uv_async_send() skips the write to the wakeup
+   * fd and leaves it to the loop to notice the pending send.
+   */
+  loop->async_awake = 1;
+
   while (r != 0 && loop->stop_flag == 0) {
-    uv__update_time(loop);
-    uv__run_timers(loop);
-    ran_pending = uv__run_pending(loop);
-    uv__run_idle(loop);
-    uv__run_prepare(loop);
+    ran_pending = uv__run_prepare_phase(loop);
 
     timeout = 0;
     if ((mode == UV_RUN_ONCE && !ran_pending) || mode == UV_RUN_DEFAULT)
       timeout = uv_backend_timeout(loop);
 
+    if (timeout != 0 && uv__async_sleep(loop))
+      timeout = 0;
+
     uv__io_poll(loop, timeout);
+    uv__async_wake(loop);
+    uv__run_deferred(loop, UV_DEFER_AFTER_POLL);
     uv__run_check(loop);
     uv__run_closing_handles(loop);
 
@@ -374,11 +406,14 @@ int uv_run(uv_loop_t* loop, uv_run_mode mode) {
       uv__run_timers(loop);
     }
 
+    UV__ITERATION_END(loop);
     r = uv__loop_alive(loop);
     if (mode == UV_RUN_ONCE || mode == UV_RUN_NOWAIT)
       break;
   }
 
+  uv__async_leave(loop);
+
   /* The if statement lets gcc compile it to a conditional store. Avoids
    * dirtying a cache line.
    */
@@ -389,6 +424,47 @@ int uv_run(uv_loop_t* loop, uv_run_mode mode) {
 }
 
 
+int uv_loop_prepare(uv_loop_t* loop) {
+  if (uv__run_prepare_phase(loop))
+    return 0;
+
+  return uv_backend_timeout(loop);
+}
+
+
+int uv_loop_dispatch(uv_loop_t* loop) {
+  /* The host has waited on the backend fd already, collect what's ready. */
+  uv__io_poll(loop, 0);
+  uv__async_wake(loop);
+  uv__run_deferred(loop, UV_DEFER_AFTER_POLL);
+  uv__run_check(loop);
+  uv__run_closing_handles(loop);
+  UV__ITERATION_END(loop);
+  uv__async_leave(loop);
+
+  if (loop->stop_flag != 0)
+    loop->stop_flag = 0;
+
+  return uv__loop_alive(loop);
+}
+
+
+int uv_run_budget(uv_loop_t* loop, uint64_t budget) {
+  uint64_t saved;
+  int r;
+
+  /* Only the poll phase looks at the deadline.  Backends that can't stop
+   * halfway through a batch of events ignore it.
+   */
+  saved = loop->run_deadline;
+  loop->run_deadline = uv__hrtime(UV_CLOCK_PRECISE) + budget;
+  r = uv_run(loop, UV_RUN_NOWAIT);
+  loop->run_deadline = saved;
+
+  return r;
+}
+
+
 void uv_update_time(uv_loop_t* loop) {
   uv__update_time(loop);
 }
@@ -750,6 +826,77 @@ int uv_fileno(const uv_handle_t* handle, uv_os_fd_t* fd) {
 }
 
 
+static uv__io_t* uv__handle_io_watcher(const uv_handle_t* handle) {
+  switch (handle->type) {
+  case UV_TCP:
+  case UV_NAMED_PIPE:
+  case UV_TTY:
+    return (uv__io_t*) &((const uv_stream_t*) handle)->io_watcher;
+
+  case UV_UDP:
+    return (uv__io_t*) &((const uv_udp_t*) handle)->io_watcher;
+
+  case UV_POLL:
+    return (uv__io_t*) &((const uv_poll_t*) handle)->io_watcher;
+
+  default:
+    return NULL;
+  }
+}
+
+
+int uv_handle_set_priority(uv_handle_t* handle, uv_priority priority) {
+  uv_loop_t* loop;
+  uv__io_t* w;
+
+  if (priority < UV_PRIORITY_LOW || priority > UV_PRIORITY_HIGH)
+    return UV_EINVAL;
+
+  w = uv__handle_io_watcher(handle);
+  if (w == NULL)
+    return UV_EINVAL;
+
+  /* Only watchers in the watcher table are counted, see uv__io_start(). */
+  loop = handle->loop;
+  if (w->fd >= 0 && uv__io_watcher(loop, w->fd) == w) {
+    loop->priority_watchers += priority != UV_PRIORITY_NORMAL;
+    loop->priority_watchers -= w->priority != UV_PRIORITY_NORMAL;
+  }
+
+  w->priority = priority;
+  return 0;
+}
+
+
+uv_priority uv_handle_get_priority(const uv_handle_t* handle) {
+  uv__io_t* w;
+
+  w = uv__handle_io_watcher(handle);
+  if (w == NULL)
+    return UV_PRIORITY_NORMAL;
+
+  return w->priority;
+}
+
+
+int uv_handle_set_read_budget(uv_handle_t* handle, unsigned int reads) {
+  switch (handle->type) {
+  case UV_TCP:
+  case UV_NAMED_PIPE:
+  case UV_TTY:
+    ((uv_stream_t*) handle)->read_budget = reads;
+    return 0;
+
+  case UV_UDP:
+    ((uv_udp_t*) handle)->read_budget = reads;
+    return 0;
+
+  default:
+    return UV_EINVAL;
+  }
+}
+
+
 static int uv__run_pending(uv_loop_t* loop) {
   QUEUE* q;
   QUEUE pq;
@@ -784,37 +931,67 @@ static unsigned int next_power_of_two(unsigned int val) {
 }
 
 static void maybe_resize(uv_loop_t* loop, unsigned int len) {
-  uv__io_t** watchers;
-  void* fake_watcher_list;
-  void* fake_watcher_count;
+  void** watchers;
+  unsigned int nchunks;
   unsigned int nwatchers;
   unsigned int i;
 
   if (len <= loop->nwatchers)
     return;
 
-  /* Preserve fake watcher list and count at the end of the watchers */
-  if (loop->watchers != NULL) {
-    fake_watcher_list = loop->watchers[loop->nwatchers];
-    fake_watcher_count = loop->watchers[loop->nwatchers + 1];
-  } else {
-    fake_watcher_list = NULL;
-    fake_watcher_count = NULL;
-  }
-
-  nwatchers = next_power_of_two(len + 2) - 2;
-  watchers = uv__realloc(loop->watchers,
-                         (nwatchers + 2) * sizeof(loop->watchers[0]));
+  /* Only the directory grows with the highest file descriptor, the chunks
+   * themselves are allocated on demand by uv__io_watcher_set().
+   */
+  nchunks = loop->nwatchers >> UV__WATCHER_CHUNK_SHIFT;
+  nwatchers = next_power_of_two(len);
+  if (nwatchers < UV__WATCHER_CHUNK_SIZE)
+    nwatchers = UV__WATCHER_CHUNK_SIZE;
+  nwatchers >>= UV__WATCHER_CHUNK_SHIFT;
 
+  watchers = uv__realloc(loop->watchers, nwatchers * sizeof(watchers[0]));
   if (watchers == NULL)
     abort();
-  for (i = loop->nwatchers; i < nwatchers; i++)
+  uv__mem_account(loop,
+                  UV_MEM_WATCHERS,
+                  nchunks * sizeof(watchers[0]),
+                  nwatchers * sizeof(watchers[0]));
+  for (i = nchunks; i < nwatchers; i++)
     watchers[i] = NULL;
-  watchers[nwatchers] = fake_watcher_list;
-  watchers[nwatchers + 1] = fake_watcher_count;
 
   loop->watchers = watchers;
-  loop->nwatchers = nwatchers;
+  loop->nwatchers = nwatchers << UV__WATCHER_CHUNK_SHIFT;
+}
+
+
+static void uv__io_watcher_set(uv_loop_t* loop, int fd, uv__io_t* w) {
+  struct uv__watcher_chunk* chunk;
+  void** slot;
+
+  assert((unsigned) fd < loop->nwatchers);
+  slot = &loop->watchers[fd >> UV__WATCHER_CHUNK_SHIFT];
+  chunk = *slot;
+
+  if (w != NULL) {
+    if (chunk == NULL) {
+      chunk = uv__calloc(1, sizeof(*chunk));
+      if (chunk == NULL)
+        abort();
+      uv__mem_account(loop, UV_MEM_WATCHERS, 0, sizeof(*chunk));
+      *slot = chunk;
+    }
+    chunk->count++;
+  } else {
+    assert(chunk != NULL);
+    assert(chunk->count > 0);
+    if (--chunk->count == 0) {
+      uv__mem_account(loop, UV_MEM_WATCHERS, sizeof(*chunk), 0);
+      uv__free(chunk);
+      *slot = NULL;
+      return;
+    }
+  }
+
+  chunk->slots[fd & (UV__WATCHER_CHUNK_SIZE - 1)] = w;
 }
 
 
@@ -827,6 +1004,7 @@ void uv__io_init(uv__io_t* w, uv__io_cb cb, int fd) {
   w->fd = fd;
   w->events = 0;
   w->pevents = 0;
+  w->priority = UV_PRIORITY_NORMAL;
 
 #if defined(UV_HAVE_KQUEUE)
   w->rcount = 0;
@@ -856,9 +1034,11 @@ void uv__io_start(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
   if (QUEUE_EMPTY(&w->watcher_queue))
     QUEUE_INSERT_TAIL(&loop->watcher_queue, &w->watcher_queue);
 
-  if (loop->watchers[w->fd] == NULL) {
-    loop->watchers[w->fd] = w;
+  if (uv__io_watcher(loop, w->fd) == NULL) {
+    uv__io_watcher_set(loop, w->fd, w);
     loop->nfds++;
+    if (w->priority != UV_PRIORITY_NORMAL)
+      loop->priority_watchers++;
   }
 }
 
@@ -882,12 +1062,14 @@ void uv__io_stop(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
     QUEUE_REMOVE(&w->watcher_queue);
     QUEUE_INIT(&w->watcher_queue);
 
-    if (loop->watchers[w->fd] != NULL) {
-      assert(loop->watchers[w->fd] == w);
+    if (uv__io_watcher(loop, w->fd) != NULL) {
+      assert(uv__io_watcher(loop, w->fd) == w);
       assert(loop->nfds > 0);
-      loop->watchers[w->fd] = NULL;
+      uv__io_watcher_set(loop, w->fd, NULL);
       loop->nfds--;
       w->events = 0;
+      if (w->priority != UV_PRIORITY_NORMAL)
+        loop->priority_watchers--;
     }
   }
   else if (QUEUE_EMPTY(&w->watcher_queue))
@@ -0,0 +1,142 @@
+/* Copyright libuv project contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "internal.h"
+
+#include <assert.h>
+
+#define UV__DEFER_PHASES 3
+#define UV__DEFER_MIN 16
+
+/* One-shot callbacks, one array per phase.  A phase runs from a swapped out
+ * copy of its array so callbacks that defer into their own phase land in the
+ * next occurrence of it.  The two buffers trade places on every run.
+ */
+struct uv__defer_entry {
+  uv_defer_cb cb;
+  void* arg;
+};
+
+struct uv__defer_queue {
+  struct uv__defer_entry* entries;
+  struct uv__defer_entry* spare;
+  unsigned int count;
+  unsigned int size;
+  unsigned int spare_size;
+};
+
+struct uv__defer_queues {
+  struct uv__defer_queue q[UV__DEFER_PHASES];
+};
+
+
+int uv_defer(uv_loop_t* loop,
+             uv_defer_phase phase,
+             uv_defer_cb cb,
+             void* arg) {
+  struct uv__defer_queues* dqs;
+  struct uv__defer_queue* dq;
+  struct uv__defer_entry* entries;
+  unsigned int size;
+
+  if ((unsigned int) phase >= UV__DEFER_PHASES || cb == NULL)
+    return UV_EINVAL;
+
+  dqs = loop->defer_queues;
+  if (dqs == NULL) {
+    dqs = uv__calloc(1, sizeof(*dqs));
+    if (dqs == NULL)
+      return UV_ENOMEM;
+    loop->defer_queues = dqs;
+  }
+
+  dq = &dqs->q[phase];
+  if (dq->count == dq->size) {
+    size = dq->size == 0 ? UV__DEFER_MIN : dq->size * 2;
+    entries = uv__realloc(dq->entries, size * sizeof(*entries));
+    if (entries == NULL)
+      return UV_ENOMEM;
+    dq->entries = entries;
+    dq->size = size;
+  }
+
+  dq->entries[dq->count].cb = cb;
+  dq->entries[dq->count].arg = arg;
+  dq->count++;
+  loop->defer_count++;
+
+  return 0;
+}
+
+
+void uv__run_deferred(uv_loop_t* loop, uv_defer_phase phase) {
+  struct uv__defer_queues* dqs;
+  struct uv__defer_queue* dq;
+  struct uv__defer_entry* entries;
+  unsigned int size;
+  unsigned int n;
+  unsigned int i;
+
+  assert((unsigned int) phase < UV__DEFER_PHASES);
+  dqs = loop->defer_queues;
+  if (dqs == NULL || dqs->q[phase].count == 0)
+    return;
+
+  dq = &dqs->q[phase];
+  entries = dq->entries;
+  size = dq->size;
+  n = dq->count;
+
+  dq->entries = dq->spare;
+  dq->size = dq->spare_size;
+  dq->count = 0;
+  dq->spare = NULL;
+  dq->spare_size = 0;
+
+  for (i = 0; i < n; i++) {
+    loop->defer_count--;
+    entries[i].cb(loop, entries[i].arg);
+  }
+
+  dq->spare = entries;
+  dq->spare_size = size;
+}
+
+
+void uv__defer_loop_close(uv_loop_t* loop) {
+  struct uv__defer_queues* dqs;
+  unsigned int i;
+
+  dqs = loop->defer_queues;
+  if (dqs == NULL)
+    return;
+
+  assert(loop->defer_count == 0);
+  for (i = 0; i < UV__DEFER_PHASES; i++) {
+    uv__free(dqs->q[i].entries);
+    uv__free(dqs->q[i].spare);
+  }
+
+  uv__free(dqs);
+  loop->defer_queues = NULL;
+}
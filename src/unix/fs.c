@@ -86,6 +86,7 @@
         uv__req_unregister(loop, req);                                        \
         return -ENOMEM;                                                       \
       }                                                                       \
+      uv__mem_account(NULL, UV_MEM_FS_PATHS, 0, strlen(path) + 1);            \
     }                                                                         \
   }                                                                           \
   while (0)
@@ -105,6 +106,7 @@
         uv__req_unregister(loop, req);                                        \
         return -ENOMEM;                                                       \
       }                                                                       \
+      uv__mem_account(NULL, UV_MEM_FS_PATHS, 0, path_len + new_path_len);     \
       req->new_path = req->path + path_len;                                   \
       memcpy((void*) req->path, path, path_len);                              \
       memcpy((void*) req->new_path, new_path, new_path_len);                  \
@@ -390,6 +392,7 @@ static int uv__fs_scandir_sort(const uv__dirent_t** a, const uv__dirent_t** b) {
 
 static ssize_t uv__fs_scandir(uv_fs_t* req) {
   uv__dirent_t **dents;
+  int i;
   int n;
 
   dents = NULL;
@@ -406,6 +409,10 @@ static ssize_t uv__fs_scandir(uv_fs_t* req) {
     dents = NULL;
   } else if (n == -1) {
     return n;
+  } else {
+    uv__mem_account(NULL, UV_MEM_SCANDIR, 0, n * sizeof(*dents));
+    for (i = 0; i < n; i++)
+      uv__mem_account(NULL, UV_MEM_SCANDIR, 0, UV__DIRENT_SIZE(dents[i]));
   }
 
   req->ptr = dents;
@@ -925,8 +932,13 @@ static ssize_t uv__fs_buf_iter(uv_fs_t* req, uv__fs_buf_iter_processor process)
   if (errno == EINTR && total == -1)
     return total;
 
-  if (bufs != req->bufsml)
+  if (bufs != req->bufsml) {
+    uv__mem_account(NULL,
+                    UV_MEM_FS_BUFS,
+                    (req->bufs - bufs + nbufs) * sizeof(*bufs),
+                    0);
     uv__free(bufs);
+  }
 
   req->bufs = NULL;
   req->nbufs = 0;
@@ -999,6 +1011,7 @@ static void uv__fs_work(struct uv__work* w) {
 
 
 static void uv__fs_done(struct uv__work* w, int status) {
+  struct uv__cb_frame frame;
   uv_fs_t* req;
 
   req = container_of(w, uv_fs_t, work_req);
@@ -1009,7 +1022,17 @@ static void uv__fs_done(struct uv__work* w, int status) {
     req->result = -ECANCELED;
   }
 
+  if (UV__COMPLETION_QUEUED(req->loop,
+                            UV_COMPLETION_FS,
+                            req,
+                            NULL,
+                            req->result)) {
+    return;
+  }
+
+  UV__REQ_CB_ENTER(req->loop, &frame, req, req->cb);
   req->cb(req);
+  UV__CB_LEAVE(req->loop, &frame);
 }
 
 
@@ -1172,6 +1195,7 @@ int uv_fs_mkdtemp(uv_loop_t* loop,
       uv__req_unregister(loop, req);
     return -ENOMEM;
   }
+  uv__mem_account(NULL, UV_MEM_FS_PATHS, 0, strlen(tpl) + 1);
   POST;
 }
 
@@ -1213,6 +1237,9 @@ int uv_fs_read(uv_loop_t* loop, uv_fs_t* req,
     return -ENOMEM;
   }
 
+  if (req->bufs != req->bufsml)
+    uv__mem_account(NULL, UV_MEM_FS_BUFS, 0, nbufs * sizeof(*bufs));
+
   memcpy(req->bufs, bufs, nbufs * sizeof(*bufs));
 
   req->off = off;
@@ -1351,6 +1378,9 @@ int uv_fs_write(uv_loop_t* loop,
     return -ENOMEM;
   }
 
+  if (req->bufs != req->bufsml)
+    uv__mem_account(NULL, UV_MEM_FS_BUFS, 0, nbufs * sizeof(*bufs));
+
   memcpy(req->bufs, bufs, nbufs * sizeof(*bufs));
 
   req->off = off;
@@ -1364,8 +1394,14 @@ void uv_fs_req_cleanup(uv_fs_t* req) {
    * req->new_path pointing to user-owned memory.  UV_FS_MKDTEMP is the
    * exception to the rule, it always allocates memory.
    */
-  if (req->path != NULL && (req->cb != NULL || req->fs_type == UV_FS_MKDTEMP))
+  if (req->path != NULL && (req->cb != NULL || req->fs_type == UV_FS_MKDTEMP)) {
+    uv__mem_account(NULL,
+                    UV_MEM_FS_PATHS,
+                    strlen(req->path) + 1 +
+                        (req->new_path != NULL ? strlen(req->new_path) + 1 : 0),
+                    0);
     uv__free((void*) req->path);  /* Memory is shared with req->new_path. */
+  }
 
   req->path = NULL;
   req->new_path = NULL;
@@ -105,6 +105,7 @@ static void uv__getaddrinfo_work(struct uv__work* w) {
 
 
 static void uv__getaddrinfo_done(struct uv__work* w, int status) {
+  struct uv__cb_frame frame;
   uv_getaddrinfo_t* req;
 
   req = container_of(w, uv_getaddrinfo_t, work_req);
@@ -129,8 +130,11 @@ static void uv__getaddrinfo_done(struct uv__work* w, int status) {
     req->retcode = UV_EAI_CANCELED;
   }
 
-  if (req->cb)
+  if (req->cb) {
+    UV__REQ_CB_ENTER(req->loop, &frame, req, req->cb);
     req->cb(req, req->retcode, req->addrinfo);
+    UV__CB_LEAVE(req->loop, &frame);
+  }
 }
 
 
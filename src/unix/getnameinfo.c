@@ -53,6 +53,7 @@ static void uv__getnameinfo_work(struct uv__work* w) {
 }
 
 static void uv__getnameinfo_done(struct uv__work* w, int status) {
+  struct uv__cb_frame frame;
   uv_getnameinfo_t* req;
   char* host;
   char* service;
@@ -69,8 +70,11 @@ static void uv__getnameinfo_done(struct uv__work* w, int status) {
     service = req->service;
   }
 
-  if (req->getnameinfo_cb)
+  if (req->getnameinfo_cb) {
+    UV__REQ_CB_ENTER(req->loop, &frame, req, req->getnameinfo_cb);
     req->getnameinfo_cb(req, req->retcode, host, service);
+    UV__CB_LEAVE(req->loop, &frame);
+  }
 }
 
 /*
@@ -0,0 +1,985 @@
+/* Copyright libuv project contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "internal.h"
+#include "spinlock.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+struct uv__watchdog {
+  uv_thread_t thread;
+  uv_mutex_t mutex;
+  uv_cond_t cond;
+  uv_stall_cb cb;
+  uint64_t threshold;  /* In nanoseconds. */
+  int signum;
+  int stop;
+};
+
+/* What the loop thread is doing, as seen by the watchdog thread.  Guarded by
+ * the spinlock; the loop thread only takes it while the watchdog runs.
+ */
+struct uv__loop_state {
+  uv_spinlock_t lock;
+  uint64_t busy_since;         /* 0 while blocked in the backend. */
+  unsigned int seq;            /* Bumped whenever the loop becomes busy. */
+  pthread_t thread;
+  uv_stall_info_t current;
+};
+
+enum uv__trace_kind {
+  UV__TRACE_ITERATION,
+  UV__TRACE_POLL,
+  UV__TRACE_HANDLE_CB,
+  UV__TRACE_REQ_CB
+};
+
+struct uv__trace_event {
+  uint64_t start;
+  uint64_t duration;
+  const void* object;  /* Handle or request of a callback event. */
+  int arg0;            /* Poll timeout, or handle or request type. */
+  int arg1;            /* Number of events returned by the poll. */
+  int kind;
+};
+
+/* Ring buffer of the most recent events.  The size is a power of two. */
+struct uv__trace {
+  uint64_t head;       /* Number of events recorded so far. */
+  unsigned int mask;
+  struct uv__trace_event events[1];
+};
+
+/* Per-loop instrumentation state.  It's allocated the first time one of the
+ * instrumentation options is turned on and lives until the loop is closed;
+ * loop->instrument != NULL is what the callback sites test for.
+ */
+struct uv__instrument {
+  struct uv__cb_frame* frame;  /* Innermost running callback. */
+  unsigned int epoch;          /* Bumped when a new sampling window starts. */
+  int handle_stats;
+  struct uv__watchdog* watchdog;
+  struct uv__loop_state state;
+  struct uv__trace* trace;
+  uint64_t iteration_start;
+  uint64_t poll_start;
+  int poll_timeout;
+  FILE* record;                /* UV_LOOP_RECORD stream. */
+  uint64_t record_start;
+};
+
+/* Hangs off handle->stats. */
+struct uv__handle_stats {
+  uv_handle_stats_t stats;
+  unsigned int epoch;
+};
+
+
+static struct uv__instrument* uv__instrument_get(uv_loop_t* loop) {
+  struct uv__instrument* inst;
+
+  inst = loop->instrument;
+  if (inst != NULL)
+    return inst;
+
+  inst = uv__calloc(1, sizeof(*inst));
+  if (inst == NULL)
+    return NULL;
+
+  loop->instrument = inst;
+  return inst;
+}
+
+
+/* Returns the handle's counters for the current window, allocating or
+ * resetting them as needed.  Returns NULL when out of memory; the sample is
+ * dropped in that case.
+ */
+static uv_handle_stats_t* uv__handle_stats(struct uv__instrument* inst,
+                                           uv_handle_t* handle) {
+  struct uv__handle_stats* hs;
+
+  hs = handle->stats;
+  if (hs == NULL) {
+    hs = uv__calloc(1, sizeof(*hs));
+    if (hs == NULL)
+      return NULL;
+    hs->epoch = inst->epoch;
+    handle->stats = hs;
+  }
+
+  if (hs->epoch != inst->epoch) {
+    memset(&hs->stats, 0, sizeof(hs->stats));
+    hs->epoch = inst->epoch;
+  }
+
+  return &hs->stats;
+}
+
+
+int uv__handle_stats_enable(uv_loop_t* loop, int enable) {
+  struct uv__instrument* inst;
+
+  if (!enable) {
+    inst = loop->instrument;
+    if (inst != NULL)
+      inst->handle_stats = 0;
+    return 0;
+  }
+
+  inst = uv__instrument_get(loop);
+  if (inst == NULL)
+    return UV_ENOMEM;
+
+  if (inst->handle_stats == 0) {
+    inst->handle_stats = 1;
+    inst->epoch++;
+  }
+
+  return 0;
+}
+
+
+int uv__trace_enable(uv_loop_t* loop, unsigned int nevents) {
+  struct uv__instrument* inst;
+  struct uv__trace* trace;
+  unsigned int size;
+
+  inst = loop->instrument;
+
+  if (nevents == 0) {
+    if (inst != NULL) {
+      uv__free(inst->trace);
+      inst->trace = NULL;
+    }
+    return 0;
+  }
+
+  if (nevents > (1u << 24))
+    return UV_EINVAL;
+
+  for (size = 1; size < nevents; size *= 2);
+
+  inst = uv__instrument_get(loop);
+  if (inst == NULL)
+    return UV_ENOMEM;
+
+  trace = uv__malloc(sizeof(*trace) + (size - 1) * sizeof(trace->events[0]));
+  if (trace == NULL)
+    return UV_ENOMEM;
+
+  trace->head = 0;
+  trace->mask = size - 1;
+
+  uv__free(inst->trace);
+  inst->trace = trace;
+  inst->iteration_start = 0;
+  inst->poll_start = 0;
+
+  return 0;
+}
+
+
+static struct uv__trace_event* uv__trace_add(struct uv__trace* trace,
+                                             int kind,
+                                             uint64_t start,
+                                             uint64_t now) {
+  struct uv__trace_event* e;
+
+  e = &trace->events[trace->head++ & trace->mask];
+  e->start = start;
+  e->duration = now - start;
+  e->object = NULL;
+  e->arg0 = 0;
+  e->arg1 = 0;
+  e->kind = kind;
+
+  return e;
+}
+
+
+int uv__record_enable(uv_loop_t* loop, FILE* stream) {
+  struct uv__instrument* inst;
+
+  inst = loop->instrument;
+
+  if (stream == NULL) {
+    if (inst != NULL && inst->record != NULL) {
+      fflush(inst->record);
+      inst->record = NULL;
+    }
+    return 0;
+  }
+
+  inst = uv__instrument_get(loop);
+  if (inst == NULL)
+    return UV_ENOMEM;
+
+  if (fwrite(UV_RECORD_MAGIC, sizeof(UV_RECORD_MAGIC) - 1, 1, stream) != 1)
+    return UV_EIO;
+
+  inst->record = stream;
+  inst->record_start = uv__hrtime(UV_CLOCK_PRECISE);
+  inst->iteration_start = 0;
+  inst->poll_start = 0;
+
+  return 0;
+}
+
+
+/* Write errors are sticky on the stream, the caller checks ferror() after it
+ * stops recording.
+ */
+static void uv__record_add(struct uv__instrument* inst,
+                           int kind,
+                           uint64_t time,
+                           uint64_t value,
+                           int fd,
+                           int type) {
+  uv_record_t r;
+
+  r.time = 0;
+  if (time > inst->record_start)
+    r.time = time - inst->record_start;
+  r.value = value;
+  r.fd = fd;
+  r.kind = kind;
+  r.type = type;
+
+  fwrite(&r, sizeof(r), 1, inst->record);
+}
+
+
+static int uv__record_fd(const uv_handle_t* handle) {
+  uv_os_fd_t fd;
+
+  if (uv_fileno(handle, &fd))
+    return -1;
+
+  return fd;
+}
+
+
+/* The user callback that a frame of `handle` stands for.  Streams run read,
+ * connection and request callbacks from the same frame; the request ones get
+ * their own frame.
+ */
+static void (*uv__handle_cb(uv_handle_t* handle))(void) {
+  switch (handle->type) {
+    case UV_ASYNC:
+      return (void (*)(void)) ((uv_async_t*) handle)->async_cb;
+    case UV_CHECK:
+      return (void (*)(void)) ((uv_check_t*) handle)->check_cb;
+    case UV_IDLE:
+      return (void (*)(void)) ((uv_idle_t*) handle)->idle_cb;
+    case UV_PREPARE:
+      return (void (*)(void)) ((uv_prepare_t*) handle)->prepare_cb;
+    case UV_POLL:
+      return (void (*)(void)) ((uv_poll_t*) handle)->poll_cb;
+    case UV_SIGNAL:
+      return (void (*)(void)) ((uv_signal_t*) handle)->signal_cb;
+    case UV_TIMER:
+      return (void (*)(void)) ((uv_timer_t*) handle)->timer_cb;
+    case UV_UDP:
+      return (void (*)(void)) ((uv_udp_t*) handle)->recv_cb;
+    case UV_NAMED_PIPE:
+    case UV_TCP:
+    case UV_TTY:
+      if (((uv_stream_t*) handle)->read_cb != NULL)
+        return (void (*)(void)) ((uv_stream_t*) handle)->read_cb;
+      return (void (*)(void)) ((uv_stream_t*) handle)->connection_cb;
+    default:
+      return NULL;
+  }
+}
+
+
+/* Publishes the innermost frame to the watchdog thread. */
+static void uv__watchdog_publish(struct uv__instrument* inst,
+                                 const struct uv__cb_frame* frame) {
+  uv_stall_info_t* current;
+
+  uv_spinlock_lock(&inst->state.lock);
+  current = &inst->state.current;
+
+  if (inst->state.busy_since == 0 && frame != NULL) {
+    inst->state.busy_since = frame->start;
+    inst->state.seq++;
+  }
+
+  if (frame == NULL) {
+    current->handle_type = UV_UNKNOWN_HANDLE;
+    current->req_type = UV_UNKNOWN_REQ;
+    current->object = NULL;
+    current->cb = NULL;
+  } else if (frame->req != NULL) {
+    current->handle_type = UV_UNKNOWN_HANDLE;
+    current->req_type = frame->req->type;
+    current->object = frame->req;
+    current->cb = frame->cb;
+  } else {
+    current->handle_type = frame->handle->type;
+    current->req_type = UV_UNKNOWN_REQ;
+    current->object = frame->handle;
+    current->cb = frame->cb;
+  }
+
+  uv_spinlock_unlock(&inst->state.lock);
+}
+
+
+static void uv__frame_push(struct uv__instrument* inst,
+                           struct uv__cb_frame* frame) {
+  frame->parent = inst->frame;
+  frame->nested = 0;
+  frame->start = uv__hrtime(UV_CLOCK_PRECISE);
+  frame->active = 1;
+  inst->frame = frame;
+
+  if (inst->watchdog != NULL)
+    uv__watchdog_publish(inst, frame);
+}
+
+
+void uv__cb_enter(uv_loop_t* loop,
+                  struct uv__cb_frame* frame,
+                  uv_handle_t* handle) {
+  struct uv__instrument* inst;
+
+  inst = loop->instrument;
+  if (inst->handle_stats == 0 &&
+      inst->watchdog == NULL &&
+      inst->trace == NULL &&
+      inst->record == NULL) {
+    return;
+  }
+
+  frame->handle = handle;
+  frame->req = NULL;
+  frame->cb = NULL;
+  if (inst->watchdog != NULL)
+    frame->cb = uv__handle_cb(handle);
+
+  uv__frame_push(inst, frame);
+}
+
+
+void uv__req_cb_enter(uv_loop_t* loop,
+                      struct uv__cb_frame* frame,
+                      uv_req_t* req,
+                      void (*cb)(void)) {
+  struct uv__instrument* inst;
+
+  inst = loop->instrument;
+  if (inst->watchdog == NULL && inst->trace == NULL && inst->record == NULL)
+    return;
+
+  frame->handle = NULL;
+  frame->req = req;
+  frame->cb = cb;
+  uv__frame_push(inst, frame);
+}
+
+
+void uv__cb_leave(uv_loop_t* loop, struct uv__cb_frame* frame) {
+  struct uv__instrument* inst;
+  struct uv__trace_event* e;
+  uv_handle_stats_t* stats;
+  uint64_t elapsed;
+  uint64_t now;
+
+  inst = loop->instrument;
+  assert(inst->frame == frame);
+  inst->frame = frame->parent;
+
+  if (inst->watchdog != NULL)
+    uv__watchdog_publish(inst, frame->parent);
+
+  now = uv__hrtime(UV_CLOCK_PRECISE);
+
+  if (inst->trace != NULL) {
+    if (frame->handle != NULL) {
+      e = uv__trace_add(inst->trace, UV__TRACE_HANDLE_CB, frame->start, now);
+      e->object = frame->handle;
+      e->arg0 = frame->handle->type;
+    } else {
+      e = uv__trace_add(inst->trace, UV__TRACE_REQ_CB, frame->start, now);
+      e->object = frame->req;
+      e->arg0 = frame->req->type;
+    }
+  }
+
+  if (inst->record != NULL) {
+    if (frame->handle != NULL)
+      uv__record_add(inst,
+                     UV_RECORD_HANDLE_CB,
+                     frame->start,
+                     now - frame->start,
+                     uv__record_fd(frame->handle),
+                     frame->handle->type);
+    else
+      uv__record_add(inst,
+                     UV_RECORD_REQ_CB,
+                     frame->start,
+                     now - frame->start,
+                     -1,
+                     frame->req->type);
+  }
+
+  /* Request callbacks are charged to the enclosing handle, so the frame is
+   * transparent to it.
+   */
+  if (frame->handle == NULL) {
+    if (frame->parent != NULL)
+      frame->parent->nested += frame->nested;
+    return;
+  }
+
+  elapsed = now - frame->start;
+  if (frame->parent != NULL)
+    frame->parent->nested += elapsed;
+
+  /* Sampling may have been switched off by the callback.  Internal handles
+   * don't show up in uv_walk() so don't bother with them either.
+   */
+  if (inst->handle_stats == 0 || (frame->handle->flags & UV__HANDLE_INTERNAL))
+    return;
+
+  stats = uv__handle_stats(inst, frame->handle);
+  if (stats == NULL)
+    return;
+
+  stats->time += elapsed - frame->nested;
+  stats->calls++;
+}
+
+
+void uv__handle_bytes(uv_handle_t* handle, uint64_t nread, uint64_t nwritten) {
+  struct uv__instrument* inst;
+  uv_handle_stats_t* stats;
+  uint64_t now;
+  int fd;
+
+  inst = handle->loop->instrument;
+
+  if (inst->record != NULL) {
+    now = uv__hrtime(UV_CLOCK_PRECISE);
+    fd = uv__record_fd(handle);
+    if (nread != 0)
+      uv__record_add(inst, UV_RECORD_READ, now, nread, fd, handle->type);
+    if (nwritten != 0)
+      uv__record_add(inst, UV_RECORD_WRITE, now, nwritten, fd, handle->type);
+  }
+
+  if (inst->handle_stats == 0 || (handle->flags & UV__HANDLE_INTERNAL))
+    return;
+
+  stats = uv__handle_stats(inst, handle);
+  if (stats == NULL)
+    return;
+
+  stats->bytes_read += nread;
+  stats->bytes_written += nwritten;
+}
+
+
+int uv_handle_get_stats(const uv_handle_t* handle, uv_handle_stats_t* stats) {
+  const struct uv__instrument* inst;
+  const struct uv__handle_stats* hs;
+
+  if (stats == NULL)
+    return UV_EINVAL;
+
+  memset(stats, 0, sizeof(*stats));
+
+  inst = handle->loop->instrument;
+  hs = handle->stats;
+  if (inst != NULL && hs != NULL && hs->epoch == inst->epoch)
+    *stats = hs->stats;
+
+  return 0;
+}
+
+
+struct uv__cost_entry {
+  uv_handle_t* handle;
+  uint64_t time;
+};
+
+
+static int uv__cost_entry_cmp(const void* a, const void* b) {
+  const struct uv__cost_entry* x;
+  const struct uv__cost_entry* y;
+
+  x = a;
+  y = b;
+
+  if (x->time > y->time)
+    return -1;
+
+  if (x->time < y->time)
+    return 1;
+
+  return 0;
+}
+
+
+int uv_walk_by_cost(uv_loop_t* loop, uv_walk_cb walk_cb, void* arg) {
+  struct uv__cost_entry* entries;
+  uv_handle_stats_t stats;
+  uv_handle_t* h;
+  unsigned int n;
+  unsigned int i;
+  QUEUE* q;
+
+  n = 0;
+  QUEUE_FOREACH(q, &loop->handle_queue)
+    n++;
+
+  if (n == 0)
+    return 0;
+
+  entries = uv__malloc(n * sizeof(*entries));
+  if (entries == NULL)
+    return UV_ENOMEM;
+
+  /* Snapshot the order first, walk_cb is allowed to close handles. */
+  i = 0;
+  QUEUE_FOREACH(q, &loop->handle_queue) {
+    h = QUEUE_DATA(q, uv_handle_t, handle_queue);
+    if (h->flags & UV__HANDLE_INTERNAL)
+      continue;
+    uv_handle_get_stats(h, &stats);
+    if (stats.calls == 0 && stats.bytes_read == 0 && stats.bytes_written == 0)
+      continue;
+    entries[i].handle = h;
+    entries[i].time = stats.time;
+    i++;
+  }
+
+  qsort(entries, i, sizeof(*entries), uv__cost_entry_cmp);
+
+  for (n = 0; n < i; n++)
+    walk_cb(entries[n].handle, arg);
+
+  uv__free(entries);
+  return 0;
+}
+
+
+void uv__instrument_handle_close(uv_handle_t* handle) {
+  uv__free(handle->stats);
+  handle->stats = NULL;
+}
+
+
+static void uv__watchdog_mark(struct uv__instrument* inst, uint64_t now) {
+  uv_spinlock_lock(&inst->state.lock);
+  if (now != 0) {
+    inst->state.busy_since = now;
+    inst->state.seq++;
+    inst->state.thread = pthread_self();
+  } else {
+    inst->state.busy_since = 0;
+  }
+  uv_spinlock_unlock(&inst->state.lock);
+}
+
+
+void uv__instrument_iteration(uv_loop_t* loop, int start) {
+  struct uv__instrument* inst;
+  uint64_t now;
+
+  inst = loop->instrument;
+  if (inst->watchdog == NULL && inst->trace == NULL && inst->record == NULL)
+    return;
+
+  now = uv__hrtime(UV_CLOCK_PRECISE);
+
+  if (inst->watchdog != NULL)
+    uv__watchdog_mark(inst, start ? now : 0);
+
+  if (start) {
+    inst->iteration_start = now;
+    return;
+  }
+
+  if (inst->iteration_start == 0)
+    return;
+
+  if (inst->trace != NULL)
+    uv__trace_add(inst->trace, UV__TRACE_ITERATION, inst->iteration_start, now);
+
+  if (inst->record != NULL)
+    uv__record_add(inst,
+                   UV_RECORD_ITERATION,
+                   inst->iteration_start,
+                   now - inst->iteration_start,
+                   -1,
+                   0);
+}
+
+
+void uv__instrument_poll(uv_loop_t* loop, int enter, int n) {
+  struct uv__instrument* inst;
+  struct uv__trace_event* e;
+  uint64_t now;
+
+  inst = loop->instrument;
+  if (inst->watchdog == NULL && inst->trace == NULL && inst->record == NULL)
+    return;
+
+  now = uv__hrtime(UV_CLOCK_PRECISE);
+
+  /* Blocking in the backend doesn't count as a stall. */
+  if (inst->watchdog != NULL)
+    uv__watchdog_mark(inst, enter ? 0 : now);
+
+  if (enter) {
+    inst->poll_start = now;
+    inst->poll_timeout = n;
+    return;
+  }
+
+  if (inst->poll_start == 0)
+    return;
+
+  if (inst->trace != NULL) {
+    e = uv__trace_add(inst->trace, UV__TRACE_POLL, inst->poll_start, now);
+    e->arg0 = inst->poll_timeout;
+    e->arg1 = n;
+  }
+
+  if (inst->record != NULL)
+    uv__record_add(inst,
+                   UV_RECORD_POLL,
+                   inst->poll_start,
+                   now - inst->poll_start,
+                   n,
+                   0);
+
+  inst->poll_start = 0;
+}
+
+
+void uv__instrument_io(uv_loop_t* loop, int fd, unsigned int events) {
+  struct uv__instrument* inst;
+  uint64_t value;
+
+  inst = loop->instrument;
+  if (inst->record == NULL)
+    return;
+
+  value = 0;
+  if (events & POLLIN)
+    value |= UV_READABLE;
+  if (events & POLLOUT)
+    value |= UV_WRITABLE;
+  if (events & (POLLERR | POLLHUP | UV__POLLRDHUP))
+    value |= UV_DISCONNECT;
+
+  uv__record_add(inst,
+                 UV_RECORD_IO,
+                 uv__hrtime(UV_CLOCK_PRECISE),
+                 value,
+                 fd,
+                 0);
+}
+
+
+static const char* uv__trace_handle_name(int type) {
+  switch (type) {
+#define XX(uc, lc) case UV_##uc: return #lc;
+    UV_HANDLE_TYPE_MAP(XX)
+#undef XX
+    default: return "unknown";
+  }
+}
+
+
+static const char* uv__trace_req_name(int type) {
+  switch (type) {
+#define XX(uc, lc) case UV_##uc: return #lc;
+    UV_REQ_TYPE_MAP(XX)
+#undef XX
+    default: return "unknown";
+  }
+}
+
+
+int uv_loop_trace_dump(uv_loop_t* loop, void* stream) {
+  const struct uv__trace_event* e;
+  const struct uv__instrument* inst;
+  const struct uv__trace* trace;
+  const char* sep;
+  uint64_t first;
+  uint64_t i;
+  FILE* fp;
+  int pid;
+
+  inst = loop->instrument;
+  if (inst == NULL || inst->trace == NULL)
+    return UV_EINVAL;
+
+  fp = stream;
+  trace = inst->trace;
+  pid = getpid();
+
+  first = 0;
+  if (trace->head > trace->mask + 1)
+    first = trace->head - (trace->mask + 1);
+
+  /* Timestamps are in microseconds.  The loop shows up as a thread of its
+   * own, callbacks nest inside the iteration and poll events.
+   */
+  fprintf(fp, "{\"traceEvents\":[\n");
+  fprintf(fp,
+          "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":1,"
+          "\"args\":{\"name\":\"uv loop %p\"}}",
+          pid,
+          (void*) loop);
+  sep = ",\n";
+
+  for (i = first; i < trace->head; i++) {
+    e = &trace->events[i & trace->mask];
+
+    fprintf(fp,
+            "%s{\"ph\":\"X\",\"pid\":%d,\"tid\":1,"
+            "\"ts\":%llu.%03u,\"dur\":%llu.%03u,",
+            sep,
+            pid,
+            (unsigned long long) (e->start / 1000),
+            (unsigned) (e->start % 1000),
+            (unsigned long long) (e->duration / 1000),
+            (unsigned) (e->duration % 1000));
+
+    switch (e->kind) {
+      case UV__TRACE_ITERATION:
+        fprintf(fp, "\"cat\":\"loop\",\"name\":\"iteration\"}");
+        break;
+      case UV__TRACE_POLL:
+        fprintf(fp,
+                "\"cat\":\"loop\",\"name\":\"poll\","
+                "\"args\":{\"timeout\":%d,\"events\":%d}}",
+                e->arg0,
+                e->arg1);
+        break;
+      case UV__TRACE_HANDLE_CB:
+        fprintf(fp,
+                "\"cat\":\"handle\",\"name\":\"%s\","
+                "\"args\":{\"handle\":\"%p\"}}",
+                uv__trace_handle_name(e->arg0),
+                e->object);
+        break;
+      case UV__TRACE_REQ_CB:
+        fprintf(fp,
+                "\"cat\":\"req\",\"name\":\"%s\","
+                "\"args\":{\"req\":\"%p\"}}",
+                uv__trace_req_name(e->arg0),
+                e->object);
+        break;
+    }
+  }
+
+  fprintf(fp, "\n],\"displayTimeUnit\":\"ns\"}\n");
+  fflush(fp);
+
+  if (ferror(fp))
+    return UV_EIO;
+
+  return 0;
+}
+
+
+static void uv__watchdog_run(void* arg) {
+  struct uv__instrument* inst;
+  struct uv__watchdog* wd;
+  uv_stall_info_t info;
+  unsigned int reported;
+  unsigned int seq;
+  uint64_t interval;
+  uint64_t busy_since;
+  uint64_t now;
+  pthread_t thread;
+  uv_loop_t* loop;
+
+  loop = arg;
+  inst = loop->instrument;
+  wd = inst->watchdog;
+
+  /* Check a few times per threshold so a stall is reported reasonably close
+   * to when it crosses the threshold.
+   */
+  interval = wd->threshold / 4;
+  if (interval < 1000000)
+    interval = 1000000;
+
+  reported = 0;
+  uv_mutex_lock(&wd->mutex);
+
+  while (wd->stop == 0) {
+    uv_cond_timedwait(&wd->cond, &wd->mutex, interval);
+    if (wd->stop != 0)
+      break;
+
+    uv_spinlock_lock(&inst->state.lock);
+    busy_since = inst->state.busy_since;
+    seq = inst->state.seq;
+    thread = inst->state.thread;
+    info = inst->state.current;
+    uv_spinlock_unlock(&inst->state.lock);
+
+    /* Report every stall once, no matter how long it lasts. */
+    if (busy_since == 0 || seq == reported)
+      continue;
+
+    now = uv__hrtime(UV_CLOCK_PRECISE);
+    if (now - busy_since < wd->threshold)
+      continue;
+
+    reported = seq;
+    info.elapsed = now - busy_since;
+
+    /* Don't hold the mutex, the callback may take its time. */
+    uv_mutex_unlock(&wd->mutex);
+    wd->cb(loop, &info);
+    if (wd->signum != 0)
+      pthread_kill(thread, wd->signum);
+    uv_mutex_lock(&wd->mutex);
+  }
+
+  uv_mutex_unlock(&wd->mutex);
+}
+
+
+int uv_loop_watchdog_start(uv_loop_t* loop,
+                           uint64_t threshold,
+                           int signum,
+                           uv_stall_cb cb) {
+  struct uv__instrument* inst;
+  struct uv__watchdog* wd;
+  int err;
+
+  if (threshold == 0 || cb == NULL || signum < 0 || signum >= NSIG)
+    return UV_EINVAL;
+
+  inst = uv__instrument_get(loop);
+  if (inst == NULL)
+    return UV_ENOMEM;
+
+  if (inst->watchdog != NULL)
+    return UV_EBUSY;
+
+  wd = uv__calloc(1, sizeof(*wd));
+  if (wd == NULL)
+    return UV_ENOMEM;
+
+  wd->cb = cb;
+  wd->threshold = threshold * 1000000;
+  wd->signum = signum;
+
+  err = uv_mutex_init(&wd->mutex);
+  if (err)
+    goto fail_mutex;
+
+  err = uv_cond_init(&wd->cond);
+  if (err)
+    goto fail_cond;
+
+  uv_spinlock_init(&inst->state.lock);
+  inst->state.busy_since = 0;
+  inst->state.thread = pthread_self();
+  inst->watchdog = wd;
+
+  /* Callbacks that are already running when the watchdog is started aren't
+   * attributed until the next one starts.
+   */
+  uv__watchdog_publish(inst, NULL);
+
+  err = uv_thread_create(&wd->thread, uv__watchdog_run, loop);
+  if (err)
+    goto fail_thread;
+
+  return 0;
+
+fail_thread:
+  inst->watchdog = NULL;
+  uv_cond_destroy(&wd->cond);
+
+fail_cond:
+  uv_mutex_destroy(&wd->mutex);
+
+fail_mutex:
+  uv__free(wd);
+  return err;
+}
+
+
+int uv_loop_watchdog_stop(uv_loop_t* loop) {
+  struct uv__instrument* inst;
+  struct uv__watchdog* wd;
+
+  inst = loop->instrument;
+  if (inst == NULL || inst->watchdog == NULL)
+    return 0;
+
+  wd = inst->watchdog;
+  uv_mutex_lock(&wd->mutex);
+  wd->stop = 1;
+  uv_cond_signal(&wd->cond);
+  uv_mutex_unlock(&wd->mutex);
+
+  if (uv_thread_join(&wd->thread))
+    abort();
+
+  inst->watchdog = NULL;
+  uv_cond_destroy(&wd->cond);
+  uv_mutex_destroy(&wd->mutex);
+  uv__free(wd);
+
+  return 0;
+}
+
+
+void uv__instrument_loop_close(uv_loop_t* loop) {
+  uv_handle_t* h;
+  QUEUE* q;
+
+  uv_loop_watchdog_stop(loop);
+
+  /* Internal handles are never closed through uv_close(). */
+  QUEUE_FOREACH(q, &loop->handle_queue) {
+    h = QUEUE_DATA(q, uv_handle_t, handle_queue);
+    uv__instrument_handle_close(h);
+  }
+
+  uv__trace_enable(loop, 0);
+  uv__record_enable(loop, NULL);
+  uv__free(loop->instrument);
+  loop->instrument = NULL;
+}
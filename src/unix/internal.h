@@ -29,6 +29,7 @@
 #include <string.h> /* strrchr */
 #include <fcntl.h>  /* O_CLOEXEC, may be */
 #include <stdio.h>
+#include <time.h>
 
 #if defined(__linux__)
 # include "linux-syscalls.h"
@@ -138,14 +139,25 @@ enum {
 
 /* loop flags */
 enum {
-  UV_LOOP_BLOCK_SIGPROF = 1
+  UV_LOOP_BLOCK_SIGPROF = 1,
+  UV_LOOP_COARSE_TIME = 2
 };
 
 typedef enum {
   UV_CLOCK_PRECISE = 0,  /* Use the highest resolution clock available. */
-  UV_CLOCK_FAST = 1      /* Use the fastest clock with <= 1ms granularity. */
+  UV_CLOCK_FAST = 1,     /* Use the fastest clock with <= 1ms granularity. */
+  UV_CLOCK_COARSE = 2    /* Use the cheapest clock, whatever its granularity. */
 } uv_clocktype_t;
 
+/* The clock behind UV_CLOCK_COARSE, where there's one.  Both are read from
+ * the vDSO or a shared page and advance once per scheduler tick.
+ */
+#if defined(CLOCK_MONOTONIC_COARSE)
+# define UV__CLOCK_COARSE CLOCK_MONOTONIC_COARSE
+#elif defined(CLOCK_MONOTONIC_FAST)
+# define UV__CLOCK_COARSE CLOCK_MONOTONIC_FAST
+#endif
+
 struct uv__stream_queued_fds_s {
   unsigned int size;
   unsigned int offset;
@@ -191,6 +203,116 @@ void uv__io_poll(uv_loop_t* loop, int timeout); /* in milliseconds or -1 */
 
 /* async */
 void uv__async_stop(uv_loop_t* loop);
+int uv__async_sleep(uv_loop_t* loop);
+void uv__async_wake(uv_loop_t* loop);
+void uv__async_leave(uv_loop_t* loop);
+
+/* instrument */
+int uv__handle_stats_enable(uv_loop_t* loop, int enable);
+void uv__handle_bytes(uv_handle_t* handle, uint64_t nread, uint64_t nwritten);
+void uv__instrument_handle_close(uv_handle_t* handle);
+void uv__instrument_loop_close(uv_loop_t* loop);
+int uv__trace_enable(uv_loop_t* loop, unsigned int nevents);
+void uv__instrument_iteration(uv_loop_t* loop, int start);
+void uv__instrument_poll(uv_loop_t* loop, int enter, int n);
+int uv__record_enable(uv_loop_t* loop, FILE* stream);
+void uv__instrument_io(uv_loop_t* loop, int fd, unsigned int events);
+
+#define UV__HANDLE_BYTES(loop, h, nread, nwritten)                            \
+  do {                                                                        \
+    if ((loop)->instrument != NULL)                                           \
+      uv__handle_bytes((uv_handle_t*) (h), (nread), (nwritten));              \
+  }                                                                           \
+  while (0)
+
+/* Loop phase markers for the USDT probes, the stall watchdog and the tracer.
+ * The backends bracket the system call that waits for events with
+ * UV__POLL_ENTER() and UV__POLL_LEAVE(); time spent in between doesn't count
+ * as a stall.
+ */
+#define UV__ITERATION_START(loop)                                             \
+  do {                                                                        \
+    UV__PROBE1(loop__iteration__start, (loop));                               \
+    if ((loop)->instrument != NULL)                                           \
+      uv__instrument_iteration((loop), 1);                                    \
+  }                                                                           \
+  while (0)
+
+#define UV__ITERATION_END(loop)                                               \
+  do {                                                                        \
+    UV__PROBE1(loop__iteration__end, (loop));                                 \
+    if ((loop)->instrument != NULL)                                           \
+      uv__instrument_iteration((loop), 0);                                    \
+  }                                                                           \
+  while (0)
+
+#define UV__POLL_ENTER(loop, timeout)                                         \
+  do {                                                                        \
+    UV__PROBE2(poll__start, (loop), (timeout));                               \
+    if ((loop)->instrument != NULL)                                           \
+      uv__instrument_poll((loop), 1, (timeout));                              \
+  }                                                                           \
+  while (0)
+
+#define UV__POLL_LEAVE(loop, nevents)                                         \
+  do {                                                                        \
+    UV__PROBE2(poll__end, (loop), (nevents));                                 \
+    if ((loop)->instrument != NULL)                                           \
+      uv__instrument_poll((loop), 0, (nevents));                              \
+  }                                                                           \
+  while (0)
+
+/* Readiness reported by the backend, for the event recorder. */
+#define UV__IO_EVENT(loop, fd, events)                                        \
+  do {                                                                        \
+    if ((loop)->instrument != NULL)                                           \
+      uv__instrument_io((loop), (fd), (events));                              \
+  }                                                                           \
+  while (0)
+
+/* completion */
+int uv__completion_enable(uv_loop_t* loop, unsigned int size);
+void uv__completion_loop_close(uv_loop_t* loop);
+void uv__completion_handle_close(uv_handle_t* handle);
+
+/* stream idle timeouts */
+void uv__stream_idle_stop(uv_stream_t* stream);
+void uv__idle_wheel_loop_close(uv_loop_t* loop);
+
+/* rate limits */
+void uv__throttle_init(uv__throttle_t* t, uv__throttle_cb cb);
+void uv__throttle_set(uv__throttle_t* t, uv_rate_limit_t* limit);
+void uv__throttle_start(uv__throttle_t* t);
+void uv__throttle_stop(uv__throttle_t* t);
+size_t uv__rate_limit_avail(uv_rate_limit_t* limit);
+void uv__rate_limit_consume(uv_rate_limit_t* limit, size_t n);
+void uv__rate_limit_loop_close(uv_loop_t* loop);
+
+/* deferred callbacks */
+void uv__run_deferred(uv_loop_t* loop, uv_defer_phase phase);
+void uv__defer_loop_close(uv_loop_t* loop);
+
+#define uv__throttled(t) (!QUEUE_EMPTY(&(t)->queue))
+
+/* I/O budget defaults, see UV_LOOP_IO_BUDGET. */
+#define UV__READ_BUDGET 32
+#define UV__POLL_EVENTS 1024  /* Size of the backends' event arrays. */
+#define UV__POLL_COUNT 48     /* Benchmarks suggest this gives the best
+                               * throughput.
+                               */
+
+#define uv__io_budget_spent(loop)                                             \
+  ((loop)->io_budget.bytes != 0 && (loop)->io_bytes >= (loop)->io_budget.bytes)
+
+/* Cheap enough for every read and write: a stream on the idle wheel is only
+ * looked at again when its slot comes up.
+ */
+#define UV__STREAM_ACTIVITY(stream, kind)                                     \
+  do {                                                                        \
+    if ((stream)->idle_flags & (kind))                                        \
+      (stream)->idle_last = (stream)->loop->time;                             \
+  }                                                                           \
+  while (0)
 
 /* loop */
 void uv__run_idle(uv_loop_t* loop);
@@ -269,9 +391,47 @@ void uv__fsevents_loop_delete(uv_loop_t* loop);
 #endif /* defined(__APPLE__) */
 
 UV_UNUSED(static void uv__update_time(uv_loop_t* loop)) {
+  uint64_t now;
+
   /* Use a fast time source if available.  We only need millisecond precision.
    */
-  loop->time = uv__hrtime(UV_CLOCK_FAST) / 1000000;
+  if ((loop->flags & UV_LOOP_COARSE_TIME) == 0) {
+    loop->time = uv__hrtime(UV_CLOCK_FAST) / 1000000;
+    return;
+  }
+
+  /* The coarse clock lags behind the others, don't let the loop time go
+   * backwards when the option is switched on.
+   */
+  now = uv__hrtime(UV_CLOCK_COARSE) / 1000000;
+  if (now > loop->time)
+    loop->time = now;
+}
+
+/* The watcher table is split into chunks of UV__WATCHER_CHUNK_SIZE slots.
+ * loop->watchers is a directory with one pointer per chunk; a chunk is only
+ * allocated while at least one file descriptor in its range is watched, so
+ * a handful of high-numbered file descriptors doesn't cost a flat table.
+ */
+#define UV__WATCHER_CHUNK_SHIFT 8
+#define UV__WATCHER_CHUNK_SIZE (1u << UV__WATCHER_CHUNK_SHIFT)
+
+struct uv__watcher_chunk {
+  unsigned int count;
+  uv__io_t* slots[UV__WATCHER_CHUNK_SIZE];
+};
+
+UV_UNUSED(static uv__io_t* uv__io_watcher(const uv_loop_t* loop, int fd)) {
+  struct uv__watcher_chunk* chunk;
+
+  if ((unsigned) fd >= loop->nwatchers)
+    return NULL;
+
+  chunk = loop->watchers[fd >> UV__WATCHER_CHUNK_SHIFT];
+  if (chunk == NULL)
+    return NULL;
+
+  return chunk->slots[fd & (UV__WATCHER_CHUNK_SIZE - 1)];
 }
 
 UV_UNUSED(static char* uv__basename_r(const char* path)) {
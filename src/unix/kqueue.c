@@ -79,6 +79,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
   uint64_t base;
   uint64_t diff;
   int have_signals;
+  int maxevents;
   int filter;
   int fflags;
   int count;
@@ -147,7 +148,14 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
 
   assert(timeout >= -1);
   base = loop->time;
-  count = 48; /* Benchmarks suggest this gives the best throughput. */
+  count = loop->io_budget.polls;
+
+  /* With a time budget, fetch one event at a time so the events left over
+   * when it runs out are reported first next time.
+   */
+  maxevents = loop->io_budget.events_per_poll;
+  if (loop->run_deadline != 0)
+    maxevents = 1;
 
   for (;; nevents = 0) {
     if (timeout != -1) {
@@ -155,6 +163,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
       spec.tv_nsec = (timeout % 1000) * 1000000;
     }
 
+    UV__POLL_ENTER(loop, timeout);
+
     if (pset != NULL)
       pthread_sigmask(SIG_BLOCK, pset, NULL);
 
@@ -162,12 +172,14 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
                   events,
                   nevents,
                   events,
-                  ARRAY_SIZE(events),
+                  maxevents,
                   timeout == -1 ? NULL : &spec);
 
     if (pset != NULL)
       pthread_sigmask(SIG_UNBLOCK, pset, NULL);
 
+    SAVE_ERRNO(UV__POLL_LEAVE(loop, nfds));
+
     /* Update loop->time unconditionally. It's tempting to skip the update when
      * timeout == 0 (i.e. non-blocking poll) but there is no guarantee that the
      * operating system didn't reschedule our process while in the syscall.
@@ -196,16 +208,15 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     have_signals = 0;
     nevents = 0;
 
-    assert(loop->watchers != NULL);
-    loop->watchers[loop->nwatchers] = (void*) events;
-    loop->watchers[loop->nwatchers + 1] = (void*) (uintptr_t) nfds;
+    loop->poll_events = events;
+    loop->poll_nevents = nfds;
     for (i = 0; i < nfds; i++) {
       ev = events + i;
       fd = ev->ident;
       /* Skip invalidated events, see uv__platform_invalidate_fd */
       if (fd == -1)
         continue;
-      w = loop->watchers[fd];
+      w = uv__io_watcher(loop, fd);
 
       if (w == NULL) {
         /* File descriptor that we've stopped watching, disarm it. */
@@ -267,6 +278,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
       if (revents == 0)
         continue;
 
+      UV__IO_EVENT(loop, w->fd, revents);
+
       /* Run signal watchers last.  This also affects child process watchers
        * because those are implemented in terms of signal watchers.
        */
@@ -281,14 +294,24 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     if (have_signals != 0)
       loop->signal_io_watcher.cb(loop, &loop->signal_io_watcher, POLLIN);
 
-    loop->watchers[loop->nwatchers] = NULL;
-    loop->watchers[loop->nwatchers + 1] = NULL;
+    loop->poll_events = NULL;
+    loop->poll_nevents = 0;
 
     if (have_signals != 0)
       return;  /* Event loop should cycle now so don't poll again. */
 
     if (nevents != 0) {
-      if (nfds == ARRAY_SIZE(events) && --count != 0) {
+      if (uv__io_budget_spent(loop))
+        return;
+
+      if (loop->run_deadline != 0) {
+        if (uv__hrtime(UV_CLOCK_PRECISE) >= loop->run_deadline)
+          return;
+        timeout = 0;
+        continue;
+      }
+
+      if (nfds == maxevents && --count != 0) {
         /* Poll for more events but don't block this time. */
         timeout = 0;
         continue;
@@ -319,10 +342,8 @@ void uv__platform_invalidate_fd(uv_loop_t* loop, int fd) {
   uintptr_t i;
   uintptr_t nfds;
 
-  assert(loop->watchers != NULL);
-
-  events = (struct kevent*) loop->watchers[loop->nwatchers];
-  nfds = (uintptr_t) loop->watchers[loop->nwatchers + 1];
+  events = (struct kevent*) loop->poll_events;
+  nfds = loop->poll_nevents;
   if (events == NULL)
     return;
 
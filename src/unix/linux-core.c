@@ -121,10 +121,8 @@ void uv__platform_invalidate_fd(uv_loop_t* loop, int fd) {
   uintptr_t i;
   uintptr_t nfds;
 
-  assert(loop->watchers != NULL);
-
-  events = (struct uv__epoll_event*) loop->watchers[loop->nwatchers];
-  nfds = (uintptr_t) loop->watchers[loop->nwatchers + 1];
+  events = (struct uv__epoll_event*) loop->poll_events;
+  nfds = loop->poll_nevents;
   if (events != NULL)
     /* Invalidate events with same file descriptor */
     for (i = 0; i < nfds; i++)
@@ -188,9 +186,15 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
   sigset_t sigset;
   uint64_t sigmask;
   uint64_t base;
+  unsigned int budget;
+  unsigned int spent;
   int have_signals;
+  int deferred;
+  int maxevents;
   int nevents;
   int count;
+  int lower;
+  int prio;
   int nfds;
   int fd;
   int op;
@@ -249,9 +253,19 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
 
   assert(timeout >= -1);
   base = loop->time;
-  count = 48; /* Benchmarks suggest this gives the best throughput. */
+  budget = loop->poll_budget;
+  spent = 0;
+  count = loop->io_budget.polls;
   real_timeout = timeout;
 
+  /* With a time budget, fetch one event at a time.  The kernel moves reported
+   * level-triggered fds to the back of its ready list, so events left over
+   * when the budget runs out are the first in line next time.
+   */
+  maxevents = loop->io_budget.events_per_poll;
+  if (loop->run_deadline != 0)
+    maxevents = 1;
+
   for (;;) {
     /* See the comment for max_safe_timeout for an explanation of why
      * this is necessary.  Executive summary: kernel bug workaround.
@@ -259,6 +273,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     if (sizeof(int32_t) == sizeof(long) && timeout >= max_safe_timeout)
       timeout = max_safe_timeout;
 
+    UV__POLL_ENTER(loop, timeout);
+
     if (sigmask != 0 && no_epoll_pwait != 0)
       if (pthread_sigmask(SIG_BLOCK, &sigset, NULL))
         abort();
@@ -266,7 +282,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     if (no_epoll_wait != 0 || (sigmask != 0 && no_epoll_pwait == 0)) {
       nfds = uv__epoll_pwait(loop->backend_fd,
                              events,
-                             ARRAY_SIZE(events),
+                             maxevents,
                              timeout,
                              sigmask);
       if (nfds == -1 && errno == ENOSYS)
@@ -274,7 +290,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     } else {
       nfds = uv__epoll_wait(loop->backend_fd,
                             events,
-                            ARRAY_SIZE(events),
+                            maxevents,
                             timeout);
       if (nfds == -1 && errno == ENOSYS)
         no_epoll_wait = 1;
@@ -284,6 +300,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
       if (pthread_sigmask(SIG_UNBLOCK, &sigset, NULL))
         abort();
 
+    SAVE_ERRNO(UV__POLL_LEAVE(loop, nfds));
+
     /* Update loop->time unconditionally. It's tempting to skip the update when
      * timeout == 0 (i.e. non-blocking poll) but there is no guarantee that the
      * operating system didn't reschedule our process while in the syscall.
@@ -324,82 +342,128 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
 
     have_signals = 0;
     nevents = 0;
+    deferred = 0;
+
+    /* Dispatch the batch one priority level at a time, highest first.  Done
+     * events are marked the same way as invalidated ones.  Once the budget
+     * for normal and low priority callbacks or the byte budget is spent the
+     * rest of the batch is left alone; the fds are level-triggered and show
+     * up again on the next poll.  Without prioritized watchers everything is
+     * normal priority and one pass does.
+     */
+    loop->poll_events = events;
+    loop->poll_nevents = nfds;
+    prio = UV_PRIORITY_HIGH;
+    if (loop->priority_watchers == 0)
+      prio = UV_PRIORITY_NORMAL;
+    for (; !deferred; prio--) {
+      lower = 0;
+
+      for (i = 0; i < nfds; i++) {
+        pe = events + i;
+        fd = pe->data;
+
+        /* Skip invalidated events, see uv__platform_invalidate_fd */
+        if (fd == -1)
+          continue;
+
+        assert(fd >= 0);
+        assert((unsigned) fd < loop->nwatchers);
+
+        w = uv__io_watcher(loop, fd);
+
+        if (w == NULL) {
+          /* File descriptor that we've stopped watching, disarm it.
+           *
+           * Ignore all errors because we may be racing with another thread
+           * when the file descriptor is closed.
+           */
+          uv__epoll_ctl(loop->backend_fd, UV__EPOLL_CTL_DEL, fd, pe);
+          pe->data = -1;
+          continue;
+        }
 
-    assert(loop->watchers != NULL);
-    loop->watchers[loop->nwatchers] = (void*) events;
-    loop->watchers[loop->nwatchers + 1] = (void*) (uintptr_t) nfds;
-    for (i = 0; i < nfds; i++) {
-      pe = events + i;
-      fd = pe->data;
+        if (w->priority < prio) {
+          lower = 1;
+          continue;
+        }
 
-      /* Skip invalidated events, see uv__platform_invalidate_fd */
-      if (fd == -1)
-        continue;
+        /* The byte budget may already be spent by timer, idle or prepare
+         * callbacks, at least one event goes out per poll regardless.
+         */
+        if (w->priority < UV_PRIORITY_HIGH) {
+          if ((budget != 0 && spent == budget) ||
+              (spent != 0 && uv__io_budget_spent(loop))) {
+            deferred = 1;
+            break;
+          }
+          spent++;
+        }
 
-      assert(fd >= 0);
-      assert((unsigned) fd < loop->nwatchers);
+        pe->data = -1;
 
-      w = loop->watchers[fd];
+        /* Give users only events they're interested in. Prevents spurious
+         * callbacks when previous callback invocation in this loop has stopped
+         * the current watcher. Also, filters out events that users has not
+         * requested us to watch.
+         */
+        pe->events &= w->pevents | POLLERR | POLLHUP;
 
-      if (w == NULL) {
-        /* File descriptor that we've stopped watching, disarm it.
+        /* Work around an epoll quirk where it sometimes reports just the
+         * EPOLLERR or EPOLLHUP event.  In order to force the event loop to
+         * move forward, we merge in the read/write events that the watcher
+         * is interested in; uv__read() and uv__write() will then deal with
+         * the error or hangup in the usual fashion.
          *
-         * Ignore all errors because we may be racing with another thread
-         * when the file descriptor is closed.
+         * Note to self: happens when epoll reports EPOLLIN|EPOLLHUP, the user
+         * reads the available data, calls uv_read_stop(), then sometime later
+         * calls uv_read_start() again.  By then, libuv has forgotten about the
+         * hangup and the kernel won't report EPOLLIN again because there's
+         * nothing left to read.  If anything, libuv is to blame here.  The
+         * current hack is just a quick bandaid; to properly fix it, libuv
+         * needs to remember the error/hangup event.  We should get that for
+         * free when we switch over to edge-triggered I/O.
          */
-        uv__epoll_ctl(loop->backend_fd, UV__EPOLL_CTL_DEL, fd, pe);
-        continue;
-      }
+        if (pe->events == POLLERR || pe->events == POLLHUP)
+          pe->events |= w->pevents & (POLLIN | POLLOUT);
 
-      /* Give users only events they're interested in. Prevents spurious
-       * callbacks when previous callback invocation in this loop has stopped
-       * the current watcher. Also, filters out events that users has not
-       * requested us to watch.
-       */
-      pe->events &= w->pevents | POLLERR | POLLHUP;
-
-      /* Work around an epoll quirk where it sometimes reports just the
-       * EPOLLERR or EPOLLHUP event.  In order to force the event loop to
-       * move forward, we merge in the read/write events that the watcher
-       * is interested in; uv__read() and uv__write() will then deal with
-       * the error or hangup in the usual fashion.
-       *
-       * Note to self: happens when epoll reports EPOLLIN|EPOLLHUP, the user
-       * reads the available data, calls uv_read_stop(), then sometime later
-       * calls uv_read_start() again.  By then, libuv has forgotten about the
-       * hangup and the kernel won't report EPOLLIN again because there's
-       * nothing left to read.  If anything, libuv is to blame here.  The
-       * current hack is just a quick bandaid; to properly fix it, libuv
-       * needs to remember the error/hangup event.  We should get that for
-       * free when we switch over to edge-triggered I/O.
-       */
-      if (pe->events == POLLERR || pe->events == POLLHUP)
-        pe->events |= w->pevents & (POLLIN | POLLOUT);
+        if (pe->events != 0) {
+          UV__IO_EVENT(loop, w->fd, pe->events);
 
-      if (pe->events != 0) {
-        /* Run signal watchers last.  This also affects child process watchers
-         * because those are implemented in terms of signal watchers.
-         */
-        if (w == &loop->signal_io_watcher)
-          have_signals = 1;
-        else
-          w->cb(loop, w, pe->events);
+          /* Run signal watchers last.  This also affects child process watchers
+           * because those are implemented in terms of signal watchers.
+           */
+          if (w == &loop->signal_io_watcher)
+            have_signals = 1;
+          else
+            w->cb(loop, w, pe->events);
 
-        nevents++;
+          nevents++;
+        }
       }
+
+      if (lower == 0)
+        break;
     }
 
     if (have_signals != 0)
       loop->signal_io_watcher.cb(loop, &loop->signal_io_watcher, POLLIN);
 
-    loop->watchers[loop->nwatchers] = NULL;
-    loop->watchers[loop->nwatchers + 1] = NULL;
+    loop->poll_events = NULL;
+    loop->poll_nevents = 0;
 
-    if (have_signals != 0)
+    if (have_signals != 0 || deferred != 0)
       return;  /* Event loop should cycle now so don't poll again. */
 
     if (nevents != 0) {
-      if (nfds == ARRAY_SIZE(events) && --count != 0) {
+      if (loop->run_deadline != 0) {
+        if (uv__hrtime(UV_CLOCK_PRECISE) >= loop->run_deadline)
+          return;
+        timeout = 0;
+        continue;
+      }
+
+      if (nfds == maxevents && --count != 0) {
         /* Poll for more events but don't block this time. */
         timeout = 0;
         continue;
@@ -450,6 +514,8 @@ uint64_t uv__hrtime(uv_clocktype_t type) {
   clock_id = CLOCK_MONOTONIC;
   if (type == UV_CLOCK_FAST)
     clock_id = fast_clock_id;
+  else if (type == UV_CLOCK_COARSE)
+    clock_id = UV__CLOCK_COARSE;
 
   if (clock_gettime(clock_id, &t))
     return 0;  /* Not really possible. */
@@ -27,6 +27,132 @@
 #include <string.h>
 #include <unistd.h>
 
+/* Process-wide memory accounting.  File system requests allocate and release
+ * memory on the threadpool and may outlive their loop, so their categories are
+ * not tracked per loop.
+ */
+static uv_once_t mem_stats_guard = UV_ONCE_INIT;
+static uv_mutex_t mem_stats_mutex;
+static uv_mem_stats_t mem_stats_global[UV_MEM_CATEGORY_MAX];
+static int mem_stats_global_enabled;
+
+#define UV__MEM_LOOP_CATEGORIES (UV_MEM_UDP_SEND_QUEUE + 1)
+
+
+static void uv__mem_stats_init(void) {
+  if (uv_mutex_init(&mem_stats_mutex))
+    abort();
+}
+
+
+static void uv__mem_stats_update(uv_mem_stats_t* stats,
+                                 size_t old_size,
+                                 size_t new_size) {
+  /* Allocations made before accounting was enabled are not known to us,
+   * don't let their release push the counters below zero.
+   */
+  if (old_size != 0) {
+    stats->bytes -= old_size < stats->bytes ? old_size : stats->bytes;
+    if (new_size == 0 && stats->count > 0)
+      stats->count--;
+  }
+
+  if (new_size != 0) {
+    stats->bytes += new_size;
+    if (old_size == 0) {
+      stats->count++;
+      stats->total_count++;
+    }
+  }
+
+  if (stats->bytes > stats->peak_bytes)
+    stats->peak_bytes = stats->bytes;
+}
+
+
+void uv__mem_account(uv_loop_t* loop,
+                     uv_mem_category category,
+                     size_t old_size,
+                     size_t new_size) {
+  uv_mem_stats_t* stats;
+
+  if (loop != NULL) {
+    stats = loop->mem_stats;
+    if (stats != NULL)
+      uv__mem_stats_update(stats + category, old_size, new_size);
+    return;
+  }
+
+  if (ACCESS_ONCE(int, mem_stats_global_enabled) == 0)
+    return;
+
+  uv_mutex_lock(&mem_stats_mutex);
+  uv__mem_stats_update(mem_stats_global + category, old_size, new_size);
+  uv_mutex_unlock(&mem_stats_mutex);
+}
+
+
+static int uv__loop_mem_stats_enable(uv_loop_t* loop) {
+  uv_mem_stats_t* stats;
+  unsigned int nchunks;
+  unsigned int i;
+
+  if (loop->mem_stats != NULL)
+    return 0;
+
+  stats = uv__calloc(UV__MEM_LOOP_CATEGORIES, sizeof(*stats));
+  if (stats == NULL)
+    return UV_ENOMEM;
+
+  loop->mem_stats = stats;
+
+  /* The watcher table may already exist, start from its current size. */
+  nchunks = loop->nwatchers >> UV__WATCHER_CHUNK_SHIFT;
+  if (nchunks != 0)
+    uv__mem_account(loop,
+                    UV_MEM_WATCHERS,
+                    0,
+                    nchunks * sizeof(loop->watchers[0]));
+  for (i = 0; i < nchunks; i++)
+    if (loop->watchers[i] != NULL)
+      uv__mem_account(loop,
+                      UV_MEM_WATCHERS,
+                      0,
+                      sizeof(struct uv__watcher_chunk));
+
+  uv_once(&mem_stats_guard, uv__mem_stats_init);
+  uv_mutex_lock(&mem_stats_mutex);
+  mem_stats_global_enabled = 1;
+  uv_mutex_unlock(&mem_stats_mutex);
+
+  return 0;
+}
+
+
+int uv_loop_mem_stats(const uv_loop_t* loop,
+                      uv_mem_category category,
+                      uv_mem_stats_t* stats) {
+  if (stats == NULL || (int) category < 0 || category >= UV_MEM_CATEGORY_MAX)
+    return UV_EINVAL;
+
+  if (category < UV__MEM_LOOP_CATEGORIES) {
+    if (loop == NULL || loop->mem_stats == NULL)
+      return UV_EINVAL;
+    *stats = ((const uv_mem_stats_t*) loop->mem_stats)[category];
+    return 0;
+  }
+
+  if (ACCESS_ONCE(int, mem_stats_global_enabled) == 0)
+    return UV_EINVAL;
+
+  uv_mutex_lock(&mem_stats_mutex);
+  *stats = mem_stats_global[category];
+  uv_mutex_unlock(&mem_stats_mutex);
+
+  return 0;
+}
+
+
 int uv_loop_init(uv_loop_t* loop) {
   void* saved_data;
   int err;
@@ -40,15 +166,15 @@ int uv_loop_init(uv_loop_t* loop) {
   heap_init((struct heap*) &loop->timer_heap);
   QUEUE_INIT(&loop->wq);
   QUEUE_INIT(&loop->active_reqs);
-  QUEUE_INIT(&loop->idle_handles);
   QUEUE_INIT(&loop->async_handles);
-  QUEUE_INIT(&loop->check_handles);
-  QUEUE_INIT(&loop->prepare_handles);
+  uv__loop_watchers_init(loop);
   QUEUE_INIT(&loop->handle_queue);
 
   loop->nfds = 0;
   loop->watchers = NULL;
   loop->nwatchers = 0;
+  loop->poll_events = NULL;
+  loop->poll_nevents = 0;
   QUEUE_INIT(&loop->pending_queue);
   QUEUE_INIT(&loop->watcher_queue);
 
@@ -56,6 +182,8 @@ int uv_loop_init(uv_loop_t* loop) {
   uv__update_time(loop);
   loop->async_io_watcher.fd = -1;
   loop->async_wfd = -1;
+  loop->async_pending = 0;
+  loop->async_awake = 0;
   loop->signal_pipefd[0] = -1;
   loop->signal_pipefd[1] = -1;
   loop->backend_fd = -1;
@@ -64,6 +192,11 @@ int uv_loop_init(uv_loop_t* loop) {
   loop->timer_counter = 0;
   loop->stop_flag = 0;
 
+  loop->io_budget.reads_per_event = UV__READ_BUDGET;
+  loop->io_budget.events_per_poll = UV__POLL_EVENTS;
+  loop->io_budget.polls = UV__POLL_COUNT;
+  loop->io_budget.bytes = 0;
+
   err = uv__platform_loop_init(loop);
   if (err)
     return err;
@@ -110,6 +243,8 @@ fail_signal_init:
 
 
 void uv__loop_close(uv_loop_t* loop) {
+  unsigned int i;
+
   uv__signal_loop_cleanup(loop);
   uv__platform_loop_delete(loop);
   uv__async_stop(loop);
@@ -142,13 +277,92 @@ void uv__loop_close(uv_loop_t* loop) {
   assert(loop->nfds == 0);
 #endif
 
+  for (i = 0; i < loop->nwatchers >> UV__WATCHER_CHUNK_SHIFT; i++)
+    uv__free(loop->watchers[i]);
   uv__free(loop->watchers);
   loop->watchers = NULL;
   loop->nwatchers = 0;
+
+  uv__free(loop->mem_stats);
+  loop->mem_stats = NULL;
+
+  uv__instrument_loop_close(loop);
+  uv__completion_loop_close(loop);
+  uv__idle_wheel_loop_close(loop);
+  uv__rate_limit_loop_close(loop);
+  uv__defer_loop_close(loop);
+}
+
+
+static int uv__loop_coarse_clock(uv_loop_t* loop, int enable) {
+#ifdef UV__CLOCK_COARSE
+  struct timespec ts;
+
+  /* Not every kernel that defines the clock id implements the clock. */
+  if (enable && clock_getres(UV__CLOCK_COARSE, &ts))
+    return -errno;
+
+  if (enable)
+    loop->flags |= UV_LOOP_COARSE_TIME;
+  else
+    loop->flags &= ~UV_LOOP_COARSE_TIME;
+
+  uv__update_time(loop);
+  return 0;
+#else
+  return UV_ENOSYS;
+#endif
+}
+
+
+static int uv__loop_io_budget(uv_loop_t* loop, const uv_io_budget_t* budget) {
+  if (budget == NULL || budget->events_per_poll > UV__POLL_EVENTS)
+    return UV_EINVAL;
+
+  /* Zero picks the default. */
+  loop->io_budget = *budget;
+  if (loop->io_budget.reads_per_event == 0)
+    loop->io_budget.reads_per_event = UV__READ_BUDGET;
+  if (loop->io_budget.events_per_poll == 0)
+    loop->io_budget.events_per_poll = UV__POLL_EVENTS;
+  if (loop->io_budget.polls == 0)
+    loop->io_budget.polls = UV__POLL_COUNT;
+
+  return 0;
 }
 
 
 int uv__loop_configure(uv_loop_t* loop, uv_loop_option option, va_list ap) {
+  if (option == UV_LOOP_MEMORY_STATS)
+    return uv__loop_mem_stats_enable(loop);
+
+  if (option == UV_LOOP_HANDLE_STATS)
+    return uv__handle_stats_enable(loop, va_arg(ap, int));
+
+  if (option == UV_LOOP_TRACE)
+    return uv__trace_enable(loop, va_arg(ap, unsigned int));
+
+  if (option == UV_LOOP_RECORD)
+    return uv__record_enable(loop, va_arg(ap, FILE*));
+
+  if (option == UV_LOOP_COMPLETION_QUEUE)
+    return uv__completion_enable(loop, va_arg(ap, unsigned int));
+
+  if (option == UV_LOOP_COARSE_CLOCK)
+    return uv__loop_coarse_clock(loop, va_arg(ap, int));
+
+  if (option == UV_LOOP_IO_BUDGET)
+    return uv__loop_io_budget(loop, va_arg(ap, const uv_io_budget_t*));
+
+  if (option == UV_LOOP_POLL_BUDGET) {
+#if defined(__linux__)
+    loop->poll_budget = va_arg(ap, unsigned int);
+    return 0;
+#else
+    return UV_ENOSYS;
+#endif
+  }
+
   if (option != UV_LOOP_BLOCK_SIGNAL)
     return UV_ENOSYS;
 
@@ -629,10 +629,8 @@ void uv__platform_invalidate_fd(uv_loop_t* loop, int fd) {
   uintptr_t i;
   uintptr_t nfds;
 
-  assert(loop->watchers != NULL);
-
-  events = (struct epoll_event*) loop->watchers[loop->nwatchers];
-  nfds = (uintptr_t) loop->watchers[loop->nwatchers + 1];
+  events = (struct epoll_event*) loop->poll_events;
+  nfds = loop->poll_nevents;
   if (events != NULL)
     /* Invalidate events with same file descriptor */
     for (i = 0; i < nfds; i++)
@@ -727,7 +725,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
 
   assert(timeout >= -1);
   base = loop->time;
-  count = 48; /* Benchmarks suggest this gives the best throughput. */
+  count = loop->io_budget.polls;
   real_timeout = timeout;
   int nevents = 0;
 
@@ -736,8 +734,10 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     if (sizeof(int32_t) == sizeof(long) && timeout >= max_safe_timeout)
       timeout = max_safe_timeout;
 
+    UV__POLL_ENTER(loop, timeout);
     nfds = epoll_wait(loop->ep, events,
                       ARRAY_SIZE(events), timeout);
+    SAVE_ERRNO(UV__POLL_LEAVE(loop, nfds));
 
     /* Update loop->time unconditionally. It's tempting to skip the update when
      * timeout == 0 (i.e. non-blocking poll) but there is no guarantee that the
@@ -770,9 +770,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     }
 
 
-    assert(loop->watchers != NULL);
-    loop->watchers[loop->nwatchers] = (void*) events;
-    loop->watchers[loop->nwatchers + 1] = (void*) (uintptr_t) nfds;
+    loop->poll_events = events;
+    loop->poll_nevents = nfds;
     for (i = 0; i < nfds; i++) {
       pe = events + i;
       fd = pe->fd;
@@ -784,7 +783,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
       assert(fd >= 0);
       assert((unsigned) fd < loop->nwatchers);
 
-      w = loop->watchers[fd];
+      w = uv__io_watcher(loop, fd);
 
       if (w == NULL) {
         /* File descriptor that we've stopped watching, disarm it.
@@ -807,14 +806,18 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
         pe->events |= w->pevents & (POLLIN | POLLOUT);
 
       if (pe->events != 0) {
+        UV__IO_EVENT(loop, w->fd, pe->events);
         w->cb(loop, w, pe->events);
         nevents++;
       }
     }
-    loop->watchers[loop->nwatchers] = NULL;
-    loop->watchers[loop->nwatchers + 1] = NULL;
+    loop->poll_events = NULL;
+    loop->poll_nevents = 0;
 
     if (nevents != 0) {
+      if (uv__io_budget_spent(loop))
+        return;
+
       if (nfds == ARRAY_SIZE(events) && --count != 0) {
         /* Poll for more events but don't block this time. */
         timeout = 0;
@@ -28,6 +28,7 @@
 
 
 static void uv__poll_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
+  struct uv__cb_frame frame;
   uv_poll_t* handle;
   int pevents;
 
@@ -36,7 +37,9 @@ static void uv__poll_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
   if (events & POLLERR) {
     uv__io_stop(loop, w, POLLIN | POLLOUT | UV__POLLRDHUP);
     uv__handle_stop(handle);
+    UV__CB_ENTER(loop, &frame, handle);
     handle->poll_cb(handle, -EBADF, 0);
+    UV__CB_LEAVE(loop, &frame);
     return;
   }
 
@@ -48,7 +51,9 @@ static void uv__poll_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
   if (events & UV__POLLRDHUP)
     pevents |= UV_DISCONNECT;
 
+  UV__CB_ENTER(loop, &frame, handle);
   handle->poll_cb(handle, 0, pevents);
+  UV__CB_LEAVE(loop, &frame);
 }
 
 
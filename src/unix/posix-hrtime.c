@@ -30,6 +30,14 @@
 
 uint64_t uv__hrtime(uv_clocktype_t type) {
   struct timespec ts;
-  clock_gettime(CLOCK_MONOTONIC, &ts);
+  clockid_t clock_id;
+
+  clock_id = CLOCK_MONOTONIC;
+#ifdef UV__CLOCK_COARSE
+  if (type == UV_CLOCK_COARSE)
+    clock_id = UV__CLOCK_COARSE;
+#endif
+
+  clock_gettime(clock_id, &ts);
   return (((uint64_t) ts.tv_sec) * NANOSEC + ts.tv_nsec);
 }
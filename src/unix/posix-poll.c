@@ -172,6 +172,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
    * our caller then we need to loop around and poll() again.
    */
   for (;;) {
+    UV__POLL_ENTER(loop, timeout);
     if (pset != NULL)
       if (pthread_sigmask(SIG_BLOCK, pset, NULL))
         abort();
@@ -179,6 +180,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     if (pset != NULL)
       if (pthread_sigmask(SIG_UNBLOCK, pset, NULL))
         abort();
+    SAVE_ERRNO(UV__POLL_LEAVE(loop, nfds));
 
     /* Update loop->time unconditionally. It's tempting to skip the update when
      * timeout == 0 (i.e. non-blocking poll) but there is no guarantee that the
@@ -226,7 +228,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
       assert(fd >= 0);
       assert((unsigned) fd < loop->nwatchers);
 
-      w = loop->watchers[fd];
+      w = uv__io_watcher(loop, fd);
 
       if (w == NULL) {
         /* File descriptor that we've stopped watching, ignore.  */
@@ -240,6 +242,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
       pe->revents &= w->pevents | POLLERR | POLLHUP;
 
       if (pe->revents != 0) {
+        UV__IO_EVENT(loop, w->fd, pe->revents);
+
         /* Run signal watchers last.  */
         if (w == &loop->signal_io_watcher) {
           have_signals = 1;
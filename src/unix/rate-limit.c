@@ -0,0 +1,295 @@
+/* Copyright libuv project contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "internal.h"
+
+#include <assert.h>
+
+/* Keeps rate * elapsed and burst * 1000 well inside an int64_t. */
+#define UV__RATE_LIMIT_MAX ((uint64_t) 1 << 40)
+
+/* Throttled handles are woken up once the bucket holds this much, so a
+ * limiter doesn't hand out a few bytes per millisecond.
+ */
+#define UV__RATE_LIMIT_WAKE_MS 10
+
+/* Limiters with throttled handles, ordered by nothing; there are few. */
+struct uv__rate_limits {
+  uv_timer_t timer;
+  void* queue[2];
+};
+
+
+static void uv__rate_limits_cb(uv_timer_t* timer);
+
+
+static void uv__rate_limit_refill(uv_rate_limit_t* limit) {
+  uint64_t elapsed;
+  int64_t cap;
+
+  elapsed = limit->loop->time - limit->refill_time;
+  limit->refill_time = limit->loop->time;
+  cap = (int64_t) limit->burst * 1000;
+
+  if (elapsed >= (uint64_t) (cap - limit->tokens) / limit->rate)
+    limit->tokens = cap;
+  else
+    limit->tokens += (int64_t) (elapsed * limit->rate);
+}
+
+
+size_t uv__rate_limit_avail(uv_rate_limit_t* limit) {
+  uv__rate_limit_refill(limit);
+
+  if (limit->tokens < 1000)
+    return 0;
+
+  return limit->tokens / 1000;
+}
+
+
+/* May run the bucket into debt: a datagram is sent whole or not at all. */
+void uv__rate_limit_consume(uv_rate_limit_t* limit, size_t n) {
+  limit->tokens -= (int64_t) n * 1000;
+}
+
+
+static void uv__rate_limits_arm(struct uv__rate_limits* rls, uv_loop_t* loop) {
+  uv_rate_limit_t* limit;
+  uint64_t wake;
+  QUEUE* q;
+
+  if (QUEUE_EMPTY(&rls->queue)) {
+    uv_timer_stop(&rls->timer);
+    return;
+  }
+
+  wake = UINT64_MAX;
+  QUEUE_FOREACH(q, &rls->queue) {
+    limit = QUEUE_DATA(q, uv_rate_limit_t, loop_queue);
+    if (limit->wake_time < wake)
+      wake = limit->wake_time;
+  }
+
+  if (uv_is_active((uv_handle_t*) &rls->timer) && rls->timer.timeout == wake)
+    return;
+
+  uv_timer_start(&rls->timer,
+                 uv__rate_limits_cb,
+                 wake > loop->time ? wake - loop->time : 0,
+                 0);
+}
+
+
+static void uv__rate_limits_cb(uv_timer_t* timer) {
+  struct uv__rate_limits* rls;
+  uv_rate_limit_t* limit;
+  uv__throttle_t* t;
+  QUEUE limits;
+  QUEUE handles;
+  QUEUE* q;
+
+  rls = container_of(timer, struct uv__rate_limits, timer);
+
+  QUEUE_INIT(&limits);
+  QUEUE_INIT(&handles);
+
+  /* Detach everything that is due first; the resume callbacks restart I/O
+   * but don't run it, so nothing gets requeued behind our back.
+   */
+  q = QUEUE_HEAD(&rls->queue);
+  while (q != &rls->queue) {
+    limit = QUEUE_DATA(q, uv_rate_limit_t, loop_queue);
+    q = QUEUE_NEXT(q);
+
+    if (limit->wake_time > timer->loop->time)
+      continue;
+
+    QUEUE_REMOVE(&limit->loop_queue);
+    QUEUE_INIT(&limit->loop_queue);
+    QUEUE_ADD(&handles, &limit->throttled);
+    QUEUE_INIT(&limit->throttled);
+  }
+
+  while (!QUEUE_EMPTY(&handles)) {
+    q = QUEUE_HEAD(&handles);
+    QUEUE_REMOVE(q);
+    QUEUE_INIT(q);
+    t = QUEUE_DATA(q, uv__throttle_t, queue);
+    t->cb(t);
+  }
+
+  uv__rate_limits_arm(rls, timer->loop);
+}
+
+
+static struct uv__rate_limits* uv__rate_limits_get(uv_loop_t* loop) {
+  struct uv__rate_limits* rls;
+
+  if (loop->rate_limits != NULL)
+    return loop->rate_limits;
+
+  rls = uv__malloc(sizeof(*rls));
+  if (rls == NULL)
+    return NULL;
+
+  uv_timer_init(loop, &rls->timer);
+  rls->timer.flags |= UV__HANDLE_INTERNAL;
+  uv_unref((uv_handle_t*) &rls->timer);
+  QUEUE_INIT(&rls->queue);
+
+  loop->rate_limits = rls;
+  return rls;
+}
+
+
+void uv__rate_limit_loop_close(uv_loop_t* loop) {
+  struct uv__rate_limits* rls;
+
+  rls = loop->rate_limits;
+  if (rls == NULL)
+    return;
+
+  uv_timer_stop(&rls->timer);
+  QUEUE_REMOVE(&rls->timer.handle_queue);
+  uv__free(rls);
+  loop->rate_limits = NULL;
+}
+
+
+void uv__throttle_init(uv__throttle_t* t, uv__throttle_cb cb) {
+  t->cb = cb;
+  t->limit = NULL;
+  QUEUE_INIT(&t->queue);
+}
+
+
+/* Park the handle until its limiter has refilled.  The caller has stopped
+ * the I/O watcher for this direction.
+ */
+void uv__throttle_start(uv__throttle_t* t) {
+  struct uv__rate_limits* rls;
+  uv_rate_limit_t* limit;
+  int64_t wake;
+
+  limit = t->limit;
+  assert(limit != NULL);
+
+  if (uv__throttled(t))
+    return;
+
+  QUEUE_INSERT_TAIL(&limit->throttled, &t->queue);
+
+  if (!QUEUE_EMPTY(&limit->loop_queue))
+    return;
+
+  /* uv__rate_limit_set() made sure this is allocated. */
+  rls = limit->loop->rate_limits;
+
+  wake = (int64_t) limit->rate * UV__RATE_LIMIT_WAKE_MS;
+  if (wake < 1000)
+    wake = 1000;
+  if (wake > (int64_t) limit->burst * 1000)
+    wake = (int64_t) limit->burst * 1000;
+
+  wake -= limit->tokens;
+  limit->wake_time = limit->loop->time;
+  if (wake > 0)
+    limit->wake_time += (wake + limit->rate - 1) / limit->rate;
+
+  QUEUE_INSERT_TAIL(&rls->queue, &limit->loop_queue);
+  uv__rate_limits_arm(rls, limit->loop);
+}
+
+
+void uv__throttle_stop(uv__throttle_t* t) {
+  uv_rate_limit_t* limit;
+
+  if (!uv__throttled(t))
+    return;
+
+  QUEUE_REMOVE(&t->queue);
+  QUEUE_INIT(&t->queue);
+
+  /* Unlink an idle limiter so the loop doesn't hold on to it. */
+  limit = t->limit;
+  if (QUEUE_EMPTY(&limit->throttled) && !QUEUE_EMPTY(&limit->loop_queue)) {
+    QUEUE_REMOVE(&limit->loop_queue);
+    QUEUE_INIT(&limit->loop_queue);
+    uv__rate_limits_arm(limit->loop->rate_limits, limit->loop);
+  }
+}
+
+
+void uv__throttle_set(uv__throttle_t* t, uv_rate_limit_t* limit) {
+  int throttled;
+
+  throttled = uv__throttled(t);
+  uv__throttle_stop(t);
+  t->limit = limit;
+
+  if (throttled)
+    t->cb(t);
+}
+
+
+int uv_rate_limit_init(uv_loop_t* loop,
+                       uv_rate_limit_t* limit,
+                       uint64_t rate,
+                       uint64_t burst) {
+  limit->loop = loop;
+  limit->rate = 0;
+  limit->burst = 0;
+  limit->tokens = 0;
+  limit->refill_time = loop->time;
+  limit->wake_time = 0;
+  QUEUE_INIT(&limit->throttled);
+  QUEUE_INIT(&limit->loop_queue);
+
+  return uv_rate_limit_set(limit, rate, burst);
+}
+
+
+int uv_rate_limit_set(uv_rate_limit_t* limit, uint64_t rate, uint64_t burst) {
+  if (rate == 0 || rate > UV__RATE_LIMIT_MAX)
+    return UV_EINVAL;
+
+  if (burst == 0 || burst > UV__RATE_LIMIT_MAX)
+    return UV_EINVAL;
+
+  if (uv__rate_limits_get(limit->loop) == NULL)
+    return UV_ENOMEM;
+
+  /* Settle what accrued at the old rate; a new limiter starts full. */
+  if (limit->rate != 0)
+    uv__rate_limit_refill(limit);
+  else
+    limit->tokens = (int64_t) burst * 1000;
+
+  limit->rate = rate;
+  limit->burst = burst;
+  if (limit->tokens > (int64_t) burst * 1000)
+    limit->tokens = (int64_t) burst * 1000;
+
+  return 0;
+}
@@ -372,6 +372,7 @@ static int uv__signal_start(uv_signal_t* handle,
 static void uv__signal_event(uv_loop_t* loop,
                              uv__io_t* w,
                              unsigned int events) {
+  struct uv__cb_frame frame;
   uv__signal_msg_t* msg;
   uv_signal_t* handle;
   char buf[sizeof(uv__signal_msg_t) * 32];
@@ -414,7 +415,9 @@ static void uv__signal_event(uv_loop_t* loop,
 
       if (msg->signum == handle->signum) {
         assert(!(handle->flags & UV_CLOSING));
+        UV__CB_ENTER(loop, &frame, handle);
         handle->signal_cb(handle, handle->signum);
+        UV__CB_LEAVE(loop, &frame);
       }
 
       handle->dispatched_signals++;
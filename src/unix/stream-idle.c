@@ -0,0 +1,207 @@
+/* Copyright libuv project contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "internal.h"
+
+#include <assert.h>
+
+/* Idle timeouts for all streams of a loop share one internal timer and a
+ * hashed timing wheel with UV__IDLE_TICK granularity.  Reads and writes only
+ * refresh stream->idle_last; a stream stays in its slot until the slot comes
+ * up, and is then either reported or moved to the slot of its new deadline.
+ */
+#define UV__IDLE_TICK 100
+#define UV__IDLE_SLOTS 128
+
+struct uv__idle_wheel {
+  uv_timer_t timer;
+  uint64_t tick;       /* Last tick that was processed. */
+  unsigned int count;  /* Streams on the wheel. */
+  void* slots[UV__IDLE_SLOTS][2];
+};
+
+
+static void uv__idle_wheel_insert(struct uv__idle_wheel* wheel,
+                                  uv_stream_t* stream) {
+  uint64_t due;
+
+  due = (stream->idle_last + stream->idle_timeout + UV__IDLE_TICK - 1) /
+        UV__IDLE_TICK;
+  if (due <= wheel->tick)
+    due = wheel->tick + 1;
+
+  QUEUE_INSERT_TAIL(&wheel->slots[due % UV__IDLE_SLOTS], &stream->idle_queue);
+}
+
+
+static void uv__idle_wheel_cb(uv_timer_t* timer) {
+  struct uv__cb_frame frame;
+  struct uv__idle_wheel* wheel;
+  uv_stream_t* stream;
+  uv_loop_t* loop;
+  uint64_t now;
+  uint64_t tick;
+  QUEUE expired;
+  QUEUE* q;
+
+  wheel = container_of(timer, struct uv__idle_wheel, timer);
+  loop = timer->loop;
+  now = loop->time / UV__IDLE_TICK;
+
+  /* Collect every slot that came up since the last run before putting
+   * anything back, so a stream is looked at no more than once per run.
+   */
+  QUEUE_INIT(&expired);
+  tick = wheel->tick;
+  if (now - tick > UV__IDLE_SLOTS)
+    tick = now - UV__IDLE_SLOTS;
+  while (tick < now) {
+    tick++;
+    QUEUE_ADD(&expired, &wheel->slots[tick % UV__IDLE_SLOTS]);
+    QUEUE_INIT(&wheel->slots[tick % UV__IDLE_SLOTS]);
+  }
+  wheel->tick = now;
+
+  while (!QUEUE_EMPTY(&expired)) {
+    q = QUEUE_HEAD(&expired);
+    QUEUE_REMOVE(q);
+    stream = QUEUE_DATA(q, uv_stream_t, idle_queue);
+
+    if (loop->time - stream->idle_last < stream->idle_timeout) {
+      uv__idle_wheel_insert(wheel, stream);
+      continue;
+    }
+
+    /* Rearm before the callback so it is free to close the stream or change
+     * the timeout.
+     */
+    stream->idle_last = loop->time;
+    uv__idle_wheel_insert(wheel, stream);
+
+    UV__CB_ENTER(loop, &frame, stream);
+    stream->idle_cb(stream);
+    UV__CB_LEAVE(loop, &frame);
+  }
+
+  if (wheel->count == 0)
+    uv_timer_stop(&wheel->timer);
+}
+
+
+static struct uv__idle_wheel* uv__idle_wheel_get(uv_loop_t* loop) {
+  struct uv__idle_wheel* wheel;
+  unsigned int i;
+
+  if (loop->idle_wheel != NULL)
+    return loop->idle_wheel;
+
+  wheel = uv__malloc(sizeof(*wheel));
+  if (wheel == NULL)
+    return NULL;
+
+  uv_timer_init(loop, &wheel->timer);
+  wheel->timer.flags |= UV__HANDLE_INTERNAL;
+  uv_unref((uv_handle_t*) &wheel->timer);
+  wheel->tick = loop->time / UV__IDLE_TICK;
+  wheel->count = 0;
+  for (i = 0; i < UV__IDLE_SLOTS; i++)
+    QUEUE_INIT(&wheel->slots[i]);
+
+  loop->idle_wheel = wheel;
+  return wheel;
+}
+
+
+void uv__idle_wheel_loop_close(uv_loop_t* loop) {
+  struct uv__idle_wheel* wheel;
+
+  wheel = loop->idle_wheel;
+  if (wheel == NULL)
+    return;
+
+  uv_timer_stop(&wheel->timer);
+  QUEUE_REMOVE(&wheel->timer.handle_queue);
+  uv__free(wheel);
+  loop->idle_wheel = NULL;
+}
+
+
+void uv__stream_idle_stop(uv_stream_t* stream) {
+  struct uv__idle_wheel* wheel;
+
+  if (stream->idle_flags == 0)
+    return;
+
+  wheel = stream->loop->idle_wheel;
+  QUEUE_REMOVE(&stream->idle_queue);
+  QUEUE_INIT(&stream->idle_queue);
+  stream->idle_flags = 0;
+  stream->idle_cb = NULL;
+
+  if (--wheel->count == 0)
+    uv_timer_stop(&wheel->timer);
+}
+
+
+int uv_stream_set_idle_timeout(uv_stream_t* stream,
+                               unsigned int flags,
+                               uint64_t timeout,
+                               uv_idle_timeout_cb cb) {
+  struct uv__idle_wheel* wheel;
+
+  if (flags & ~(UV_IDLE_TIMEOUT_READ | UV_IDLE_TIMEOUT_WRITE))
+    return UV_EINVAL;
+
+  if (uv__is_closing(stream))
+    return UV_EINVAL;
+
+  if (flags == 0 || timeout == 0) {
+    uv__stream_idle_stop(stream);
+    return 0;
+  }
+
+  if (cb == NULL)
+    return UV_EINVAL;
+
+  wheel = uv__idle_wheel_get(stream->loop);
+  if (wheel == NULL)
+    return UV_ENOMEM;
+
+  if (stream->idle_flags == 0) {
+    if (wheel->count++ == 0) {
+      wheel->tick = stream->loop->time / UV__IDLE_TICK;
+      uv_timer_start(&wheel->timer, uv__idle_wheel_cb, UV__IDLE_TICK,
+                     UV__IDLE_TICK);
+    }
+  } else {
+    QUEUE_REMOVE(&stream->idle_queue);
+  }
+
+  stream->idle_flags = flags;
+  stream->idle_timeout = timeout;
+  stream->idle_cb = cb;
+  stream->idle_last = stream->loop->time;
+  uv__idle_wheel_insert(wheel, stream);
+
+  return 0;
+}
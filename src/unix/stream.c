@@ -66,6 +66,8 @@ static void uv__read(uv_stream_t* stream);
 static void uv__stream_io(uv_loop_t* loop, uv__io_t* w, unsigned int events);
 static void uv__write_callbacks(uv_stream_t* stream);
 static size_t uv__write_req_size(uv_write_t* req);
+static void uv__stream_read_resume(uv__throttle_t* t);
+static void uv__stream_write_resume(uv__throttle_t* t);
 
 
 void uv__stream_init(uv_loop_t* loop,
@@ -83,6 +85,14 @@ void uv__stream_init(uv_loop_t* loop,
   stream->accepted_fd = -1;
   stream->queued_fds = NULL;
   stream->delayed_error = 0;
+  stream->idle_cb = NULL;
+  stream->idle_timeout = 0;
+  stream->idle_last = 0;
+  stream->idle_flags = 0;
+  QUEUE_INIT(&stream->idle_queue);
+  uv__throttle_init(&stream->read_throttle, uv__stream_read_resume);
+  uv__throttle_init(&stream->write_throttle, uv__stream_write_resume);
+  stream->read_budget = 0;
   QUEUE_INIT(&stream->write_queue);
   QUEUE_INIT(&stream->write_completed_queue);
   stream->write_queue_size = 0;
@@ -445,7 +455,13 @@ void uv__stream_destroy(uv_stream_t* stream) {
 
   if (stream->connect_req) {
     uv__req_unregister(stream->loop, stream->connect_req);
-    stream->connect_req->cb(stream->connect_req, -ECANCELED);
+    if (!UV__COMPLETION_QUEUED(stream->loop,
+                               UV_COMPLETION_CONNECT,
+                               stream->connect_req,
+                               NULL,
+                               UV_ECANCELED)) {
+      stream->connect_req->cb(stream->connect_req, -ECANCELED);
+    }
     stream->connect_req = NULL;
   }
 
@@ -459,7 +475,13 @@ void uv__stream_destroy(uv_stream_t* stream) {
      * callee that the handle has been destroyed.
      */
     uv__req_unregister(stream->loop, stream->shutdown_req);
-    stream->shutdown_req->cb(stream->shutdown_req, -ECANCELED);
+    if (!UV__COMPLETION_QUEUED(stream->loop,
+                               UV_COMPLETION_SHUTDOWN,
+                               stream->shutdown_req,
+                               NULL,
+                               UV_ECANCELED)) {
+      stream->shutdown_req->cb(stream->shutdown_req, -ECANCELED);
+    }
     stream->shutdown_req = NULL;
   }
 
@@ -509,7 +531,9 @@ static int uv__emfile_trick(uv_loop_t* loop, int accept_fd) {
 #endif /* defined(UV_HAVE_KQUEUE) */
 
 
-void uv__server_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
+static void uv__server_io_events(uv_loop_t* loop,
+                                 uv__io_t* w,
+                                 unsigned int events) {
   uv_stream_t* stream;
   int err;
 
@@ -545,13 +569,25 @@ void uv__server_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
           break;
       }
 
-      stream->connection_cb(stream, err);
+      if (!UV__COMPLETION_QUEUED(loop,
+                                 UV_COMPLETION_CONNECTION,
+                                 stream,
+                                 NULL,
+                                 err)) {
+        stream->connection_cb(stream, err);
+      }
       continue;
     }
 
     UV_DEC_BACKLOG(w)
     stream->accepted_fd = err;
-    stream->connection_cb(stream, 0);
+    if (!UV__COMPLETION_QUEUED(loop,
+                               UV_COMPLETION_CONNECTION,
+                               stream,
+                               NULL,
+                               0)) {
+      stream->connection_cb(stream, 0);
+    }
 
     if (stream->accepted_fd != -1) {
       /* The user hasn't yet accepted called uv_accept() */
@@ -568,6 +604,15 @@ void uv__server_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
 }
 
 
+void uv__server_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
+  struct uv__cb_frame frame;
+
+  UV__CB_ENTER(loop, &frame, container_of(w, uv_stream_t, io_watcher));
+  uv__server_io_events(loop, w, events);
+  UV__CB_LEAVE(loop, &frame);
+}
+
+
 #undef UV_DEC_BACKLOG
 
 
@@ -660,6 +705,7 @@ int uv_listen(uv_stream_t* stream, int backlog, uv_connection_cb cb) {
 
 
 static void uv__drain(uv_stream_t* stream) {
+  struct uv__cb_frame frame;
   uv_shutdown_t* req;
   int err;
 
@@ -685,8 +731,16 @@ static void uv__drain(uv_stream_t* stream) {
     if (err == 0)
       stream->flags |= UV_STREAM_SHUT;
 
-    if (req->cb != NULL)
+    if (req->cb != NULL &&
+        !UV__COMPLETION_QUEUED(stream->loop,
+                               UV_COMPLETION_SHUTDOWN,
+                               req,
+                               NULL,
+                               err)) {
+      UV__REQ_CB_ENTER(stream->loop, &frame, req, req->cb);
       req->cb(req, err);
+      UV__CB_LEAVE(stream->loop, &frame);
+    }
   }
 }
 
@@ -716,8 +770,13 @@ static void uv__write_req_finish(uv_write_t* req) {
    * to revisit in future revisions of the libuv API.
    */
   if (req->error == 0) {
-    if (req->bufs != req->bufsml)
+    if (req->bufs != req->bufsml) {
+      uv__mem_account(stream->loop,
+                      UV_MEM_WRITE_QUEUE,
+                      req->nbufs * sizeof(req->bufs[0]),
+                      0);
       uv__free(req->bufs);
+    }
     req->bufs = NULL;
   }
 
@@ -744,10 +803,55 @@ static int uv__handle_fd(uv_handle_t* handle) {
 }
 
 
+static void uv__stream_read_resume(uv__throttle_t* t) {
+  uv_stream_t* stream;
+
+  stream = container_of(t, uv_stream_t, read_throttle);
+  if (stream->flags & UV_STREAM_READING) {
+    uv__io_start(stream->loop, &stream->io_watcher, POLLIN);
+    uv__stream_osx_interrupt_select(stream);
+  }
+}
+
+
+static void uv__stream_write_resume(uv__throttle_t* t) {
+  uv_stream_t* stream;
+
+  stream = container_of(t, uv_stream_t, write_throttle);
+  if (!QUEUE_EMPTY(&stream->write_queue)) {
+    uv__io_start(stream->loop, &stream->io_watcher, POLLOUT);
+    uv__stream_osx_interrupt_select(stream);
+  }
+}
+
+
+/* Blocking writes ignore the write limit: they can't wait for the loop. */
+static size_t uv__write_avail(uv_stream_t* stream) {
+  size_t avail;
+
+  if (stream->write_throttle.limit == NULL ||
+      (stream->flags & UV_STREAM_BLOCKING)) {
+    return SIZE_MAX;
+  }
+
+  avail = uv__rate_limit_avail(stream->write_throttle.limit);
+  if (avail == 0) {
+    uv__io_stop(stream->loop, &stream->io_watcher, POLLOUT);
+    uv__stream_osx_interrupt_select(stream);
+    uv__throttle_start(&stream->write_throttle);
+  }
+
+  return avail;
+}
+
+
 static void uv__write(uv_stream_t* stream) {
   struct iovec* iov;
   QUEUE* q;
   uv_write_t* req;
+  size_t old_iov_len;
+  size_t max_bytes;
+  size_t avail;
   int iovmax;
   int iovcnt;
   ssize_t n;
@@ -760,6 +864,10 @@ start:
   if (QUEUE_EMPTY(&stream->write_queue))
     return;
 
+  avail = uv__write_avail(stream);
+  if (avail == 0)
+    return;
+
   q = QUEUE_HEAD(&stream->write_queue);
   req = QUEUE_DATA(q, uv_write_t, queue);
   assert(req->handle == stream);
@@ -778,6 +886,35 @@ start:
   if (iovcnt > iovmax)
     iovcnt = iovmax;
 
+  if (req->send_handle && uv__is_closing(req->send_handle)) {
+    err = -EBADF;
+    goto error;
+  }
+
+  /* On some platforms, notably macOS, the sum of iov_len must not overflow a
+   * 32-bit signed integer.  The write limiter may cut the write shorter
+   * still.  The length of the last iov is restored after the write.
+   */
+  old_iov_len = iov[iovcnt - 1].iov_len;
+  max_bytes = INT32_MAX;
+  if (avail < max_bytes)
+    max_bytes = avail;  /* Write limit. */
+  if (stream->write_queue_size > max_bytes) {
+    int32_t total_bytes = 0;
+    int new_iov_cnt;
+    for (new_iov_cnt = 0; new_iov_cnt < iovcnt; new_iov_cnt++) {
+      old_iov_len = iov[new_iov_cnt].iov_len;
+      if (((int64_t)total_bytes + iov[new_iov_cnt].iov_len) >= max_bytes) {
+        iov[new_iov_cnt].iov_len = max_bytes - total_bytes;
+        break;
+      }
+      total_bytes += iov[new_iov_cnt].iov_len;
+    }
+    /* The rest of the queue may be in the next request. */
+    if (new_iov_cnt < iovcnt)
+      iovcnt = new_iov_cnt + 1;
+  }
+
   /*
    * Now do the actual writev. Note that we've been updating the pointers
    * inside the iov each time we write. So there is no need to offset it.
@@ -792,11 +929,6 @@ start:
       struct cmsghdr alias;
     } scratch;
 
-    if (uv__is_closing(req->send_handle)) {
-      err = -EBADF;
-      goto error;
-    }
-
     fd_to_send = uv__handle_fd((uv_handle_t*) req->send_handle);
 
     memset(&scratch, 0, sizeof(scratch));
@@ -840,31 +972,11 @@ start:
 #endif
   } else {
     do {
-      /* On some platforms, notably macOS, the sum of iov_len must not
-       * overflow a 32-bit signed integer.
-       */
-      size_t old_iov_len = iov[iovcnt - 1].iov_len;
-      if (stream->write_queue_size > INT32_MAX) {
-        int32_t total_bytes = 0;
-        int new_iov_cnt;
-        for (new_iov_cnt = 0; new_iov_cnt < iovcnt; new_iov_cnt++) {
-          old_iov_len = iov[new_iov_cnt].iov_len;
-          if (((int64_t)total_bytes + iov[new_iov_cnt].iov_len) >= INT32_MAX) {
-            iov[new_iov_cnt].iov_len = INT32_MAX - total_bytes;
-            break;
-          }
-          total_bytes += iov[new_iov_cnt].iov_len;
-        }
-        iovcnt = new_iov_cnt + 1;
-       }
-
       if (iovcnt == 1) {
         n = write(uv__stream_fd(stream), iov[0].iov_base, iov[0].iov_len);
       } else {
         n = writev(uv__stream_fd(stream), iov, iovcnt);
       }
-
-      iov[iovcnt - 1].iov_len = old_iov_len; /* restore original size of write in iov buf */
     }
 #if defined(__APPLE__)
     /*
@@ -879,6 +991,8 @@ start:
 #endif
   }
 
+  iov[iovcnt - 1].iov_len = old_iov_len;
+
   if (n < 0) {
     if (errno != EAGAIN && errno != EWOULDBLOCK) {
       err = -errno;
@@ -889,6 +1003,14 @@ start:
     }
   } else {
     /* Successful write */
+    UV__PROBE2(stream__write, stream, n);
+    UV__HANDLE_BYTES(stream->loop, stream, 0, n);
+    stream->loop->io_bytes += n;
+    UV__STREAM_ACTIVITY(stream, UV_IDLE_TIMEOUT_WRITE);
+    /* The handle went out with the first bytes, don't send it again. */
+    req->send_handle = NULL;
+    if (stream->write_throttle.limit != NULL)
+      uv__rate_limit_consume(stream->write_throttle.limit, n);
 
     while (n >= 0) {
       uv_buf_t* buf = &(req->bufs[req->write_index]);
@@ -941,6 +1063,10 @@ start:
   /* Only non-blocking streams should use the write_watcher. */
   assert(!(stream->flags & UV_STREAM_BLOCKING));
 
+  /* Out of tokens, wait for the limiter rather than for POLLOUT. */
+  if (uv__write_avail(stream) == 0)
+    return;
+
   /* We're not done. */
   uv__io_start(stream->loop, &stream->io_watcher, POLLOUT);
 
@@ -953,13 +1079,16 @@ error:
   req->error = err;
   uv__write_req_finish(req);
   uv__io_stop(stream->loop, &stream->io_watcher, POLLOUT);
-  if (!uv__io_active(&stream->io_watcher, POLLIN))
+  if (!uv__io_active(&stream->io_watcher, POLLIN) &&
+      !uv__throttled(&stream->read_throttle)) {
     uv__handle_stop(stream);
+  }
   uv__stream_osx_interrupt_select(stream);
 }
 
 
 static void uv__write_callbacks(uv_stream_t* stream) {
+  struct uv__cb_frame frame;
   uv_write_t* req;
   QUEUE* q;
 
@@ -972,14 +1101,27 @@ static void uv__write_callbacks(uv_stream_t* stream) {
 
     if (req->bufs != NULL) {
       stream->write_queue_size -= uv__write_req_size(req);
-      if (req->bufs != req->bufsml)
+      if (req->bufs != req->bufsml) {
+        uv__mem_account(stream->loop,
+                        UV_MEM_WRITE_QUEUE,
+                        req->nbufs * sizeof(req->bufs[0]),
+                        0);
         uv__free(req->bufs);
+      }
       req->bufs = NULL;
     }
 
     /* NOTE: call callback AFTER freeing the request data. */
-    if (req->cb)
+    if (req->cb &&
+        !UV__COMPLETION_QUEUED(stream->loop,
+                               UV_COMPLETION_WRITE,
+                               req,
+                               NULL,
+                               req->error)) {
+      UV__REQ_CB_ENTER(stream->loop, &frame, req, req->cb);
       req->cb(req, req->error);
+      UV__CB_LEAVE(stream->loop, &frame);
+    }
   }
 
   assert(QUEUE_EMPTY(&stream->write_completed_queue));
@@ -1029,13 +1171,31 @@ uv_handle_type uv__handle_type(int fd) {
 }
 
 
+static void uv__stream_read_cb(uv_stream_t* stream,
+                               ssize_t nread,
+                               const uv_buf_t* buf) {
+  if (UV__COMPLETION_QUEUED(stream->loop,
+                            UV_COMPLETION_READ,
+                            stream,
+                            buf->base,
+                            nread)) {
+    return;
+  }
+
+  stream->read_cb(stream, nread, buf);
+}
+
+
 static void uv__stream_eof(uv_stream_t* stream, const uv_buf_t* buf) {
   stream->flags |= UV_STREAM_READ_EOF;
   uv__io_stop(stream->loop, &stream->io_watcher, POLLIN);
-  if (!uv__io_active(&stream->io_watcher, POLLOUT))
+  uv__throttle_stop(&stream->read_throttle);
+  if (!uv__io_active(&stream->io_watcher, POLLOUT) &&
+      !uv__throttled(&stream->write_throttle)) {
     uv__handle_stop(stream);
+  }
   uv__stream_osx_interrupt_select(stream);
-  stream->read_cb(stream, UV_EOF, buf);
+  uv__stream_read_cb(stream, UV_EOF, buf);
   stream->flags &= ~UV_STREAM_READING;
 }
 
@@ -1141,8 +1301,10 @@ static int uv__stream_recv_cmsg(uv_stream_t* stream, struct msghdr* msg) {
 static void uv__read(uv_stream_t* stream) {
   uv_buf_t buf;
   ssize_t nread;
+  struct iovec iov;
   struct msghdr msg;
   char cmsg_space[CMSG_SPACE(UV__CMSG_FD_SIZE)];
+  size_t avail;
   int count;
   int err;
   int is_ipc;
@@ -1152,7 +1314,9 @@ static void uv__read(uv_stream_t* stream) {
   /* Prevent loop starvation when the data comes in as fast as (or faster than)
    * we can read it. XXX Need to rearm fd if we switch to edge-triggered I/O.
    */
-  count = 32;
+  count = stream->read_budget;
+  if (count == 0)
+    count = stream->loop->io_budget.reads_per_event;
 
   is_ipc = stream->type == UV_NAMED_PIPE && ((uv_pipe_t*) stream)->ipc;
 
@@ -1164,23 +1328,40 @@ static void uv__read(uv_stream_t* stream) {
       && (count-- > 0)) {
     assert(stream->alloc_cb != NULL);
 
+    avail = SIZE_MAX;
+    if (stream->read_throttle.limit != NULL) {
+      avail = uv__rate_limit_avail(stream->read_throttle.limit);
+      if (avail == 0) {
+        uv__io_stop(stream->loop, &stream->io_watcher, POLLIN);
+        uv__stream_osx_interrupt_select(stream);
+        uv__throttle_start(&stream->read_throttle);
+        return;
+      }
+    }
+
     buf = uv_buf_init(NULL, 0);
     stream->alloc_cb((uv_handle_t*)stream, 64 * 1024, &buf);
     if (buf.base == NULL || buf.len == 0) {
       /* User indicates it can't or won't handle the read. */
-      stream->read_cb(stream, UV_ENOBUFS, &buf);
+      uv__stream_read_cb(stream, UV_ENOBUFS, &buf);
       return;
     }
 
     assert(buf.base != NULL);
     assert(uv__stream_fd(stream) >= 0);
 
+    /* Don't read more than the read limit allows. */
+    iov.iov_base = buf.base;
+    iov.iov_len = buf.len;
+    if (iov.iov_len > avail)
+      iov.iov_len = avail;
+
     if (!is_ipc) {
       do {
        /* On some platforms, notably macOS, attempting a read > 2GB
         * returns an EINVAL.
         */
-       size_t buflen_limited = buf.len;
+       size_t buflen_limited = iov.iov_len;
        if (buflen_limited > INT32_MAX)
          buflen_limited = INT32_MAX;
        nread = read(uv__stream_fd(stream), buf.base, buflen_limited);
@@ -1189,7 +1370,7 @@ static void uv__read(uv_stream_t* stream) {
     } else {
       /* ipc uses recvmsg */
       msg.msg_flags = 0;
-      msg.msg_iov = (struct iovec*) &buf;
+      msg.msg_iov = &iov;
       msg.msg_iovlen = 1;
       msg.msg_name = NULL;
       msg.msg_namelen = 0;
@@ -1211,7 +1392,7 @@ static void uv__read(uv_stream_t* stream) {
           uv__io_start(stream->loop, &stream->io_watcher, POLLIN);
           uv__stream_osx_interrupt_select(stream);
         }
-        stream->read_cb(stream, 0, &buf);
+        uv__stream_read_cb(stream, 0, &buf);
 #if defined(__CYGWIN__) || defined(__MSYS__)
       } else if (errno == ECONNRESET && stream->type == UV_NAMED_PIPE) {
         uv__stream_eof(stream, &buf);
@@ -1219,12 +1400,14 @@ static void uv__read(uv_stream_t* stream) {
 #endif
       } else {
         /* Error. User should call uv_close(). */
-        stream->read_cb(stream, -errno, &buf);
+        uv__stream_read_cb(stream, -errno, &buf);
         if (stream->flags & UV_STREAM_READING) {
           stream->flags &= ~UV_STREAM_READING;
           uv__io_stop(stream->loop, &stream->io_watcher, POLLIN);
-          if (!uv__io_active(&stream->io_watcher, POLLOUT))
+          if (!uv__io_active(&stream->io_watcher, POLLOUT) &&
+              !uv__throttled(&stream->write_throttle)) {
             uv__handle_stop(stream);
+          }
           uv__stream_osx_interrupt_select(stream);
         }
       }
@@ -1234,12 +1417,19 @@ static void uv__read(uv_stream_t* stream) {
       return;
     } else {
       /* Successful read */
-      ssize_t buflen = buf.len;
+      ssize_t buflen = iov.iov_len;
+
+      UV__PROBE2(stream__read, stream, nread);
+      UV__HANDLE_BYTES(stream->loop, stream, nread, 0);
+      stream->loop->io_bytes += nread;
+      UV__STREAM_ACTIVITY(stream, UV_IDLE_TIMEOUT_READ);
+      if (stream->read_throttle.limit != NULL)
+        uv__rate_limit_consume(stream->read_throttle.limit, nread);
 
       if (is_ipc) {
         err = uv__stream_recv_cmsg(stream, &msg);
         if (err != 0) {
-          stream->read_cb(stream, err, &buf);
+          uv__stream_read_cb(stream, err, &buf);
           return;
         }
       }
@@ -1259,7 +1449,7 @@ static void uv__read(uv_stream_t* stream) {
           nread = uv__recvmsg(uv__stream_fd(stream), &msg, 0);
           err = uv__stream_recv_cmsg(stream, &msg);
           if (err != 0) {
-            stream->read_cb(stream, err, &buf);
+            uv__stream_read_cb(stream, err, &buf);
             msg.msg_iov = old;
             return;
           }
@@ -1267,13 +1457,17 @@ static void uv__read(uv_stream_t* stream) {
         msg.msg_iov = old;
       }
 #endif
-      stream->read_cb(stream, nread, &buf);
+      uv__stream_read_cb(stream, nread, &buf);
 
       /* Return if we didn't fill the buffer, there is no more data to read. */
       if (nread < buflen) {
         stream->flags |= UV_STREAM_READ_PARTIAL;
         return;
       }
+
+      /* Checked after the read so that the stream always makes progress. */
+      if (uv__io_budget_spent(stream->loop))
+        return;
     }
   }
 }
@@ -1314,11 +1508,7 @@ int uv_shutdown(uv_shutdown_t* req, uv_stream_t* stream, uv_shutdown_cb cb) {
 }
 
 
-static void uv__stream_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
-  uv_stream_t* stream;
-
-  stream = container_of(w, uv_stream_t, io_watcher);
-
+static void uv__stream_io_events(uv_stream_t* stream, unsigned int events) {
   assert(stream->type == UV_TCP ||
          stream->type == UV_NAMED_PIPE ||
          stream->type == UV_TTY);
@@ -1366,12 +1556,25 @@ static void uv__stream_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
 }
 
 
+static void uv__stream_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
+  struct uv__cb_frame frame;
+  uv_stream_t* stream;
+
+  stream = container_of(w, uv_stream_t, io_watcher);
+
+  UV__CB_ENTER(loop, &frame, stream);
+  uv__stream_io_events(stream, events);
+  UV__CB_LEAVE(loop, &frame);
+}
+
+
 /**
  * We get called here from directly following a call to connect(2).
  * In order to determine if we've errored out or succeeded must call
  * getsockopt.
  */
 static void uv__stream_connect(uv_stream_t* stream) {
+  struct uv__cb_frame frame;
   int error;
   uv_connect_t* req = stream->connect_req;
   socklen_t errorsize = sizeof(int);
@@ -1407,8 +1610,16 @@ static void uv__stream_connect(uv_stream_t* stream) {
     uv__io_stop(stream->loop, &stream->io_watcher, POLLOUT);
   }
 
-  if (req->cb)
+  if (req->cb &&
+      !UV__COMPLETION_QUEUED(stream->loop,
+                             UV_COMPLETION_CONNECT,
+                             req,
+                             NULL,
+                             error)) {
+    UV__REQ_CB_ENTER(stream->loop, &frame, req, req->cb);
     req->cb(req, error);
+    UV__CB_LEAVE(stream->loop, &frame);
+  }
 
   if (uv__stream_fd(stream) == -1)
     return;
@@ -1480,6 +1691,12 @@ int uv_write2(uv_write_t* req,
   if (req->bufs == NULL)
     return -ENOMEM;
 
+  if (req->bufs != req->bufsml)
+    uv__mem_account(stream->loop,
+                    UV_MEM_WRITE_QUEUE,
+                    0,
+                    nbufs * sizeof(bufs[0]));
+
   memcpy(req->bufs, bufs, nbufs * sizeof(bufs[0]));
   req->nbufs = nbufs;
   req->write_index = 0;
@@ -1505,8 +1722,10 @@ int uv_write2(uv_write_t* req,
      * sufficiently flushed in uv__write.
      */
     assert(!(stream->flags & UV_STREAM_BLOCKING));
-    uv__io_start(stream->loop, &stream->io_watcher, POLLOUT);
-    uv__stream_osx_interrupt_select(stream);
+    if (!uv__throttled(&stream->write_throttle)) {
+      uv__io_start(stream->loop, &stream->io_watcher, POLLOUT);
+      uv__stream_osx_interrupt_select(stream);
+    }
   }
 
   return 0;
@@ -1562,8 +1781,13 @@ int uv_try_write(uv_stream_t* stream,
   /* Unqueue request, regardless of immediateness */
   QUEUE_REMOVE(&req.queue);
   uv__req_unregister(stream->loop, &req);
-  if (req.bufs != req.bufsml)
+  if (req.bufs != NULL && req.bufs != req.bufsml) {
+    uv__mem_account(stream->loop,
+                    UV_MEM_WRITE_QUEUE,
+                    req.nbufs * sizeof(req.bufs[0]),
+                    0);
     uv__free(req.bufs);
+  }
   req.bufs = NULL;
 
   /* Do not poll for writable, if we wasn't before calling this */
@@ -1617,8 +1841,11 @@ int uv_read_stop(uv_stream_t* stream) {
 
   stream->flags &= ~UV_STREAM_READING;
   uv__io_stop(stream->loop, &stream->io_watcher, POLLIN);
-  if (!uv__io_active(&stream->io_watcher, POLLOUT))
+  uv__throttle_stop(&stream->read_throttle);
+  if (!uv__io_active(&stream->io_watcher, POLLOUT) &&
+      !uv__throttled(&stream->write_throttle)) {
     uv__handle_stop(stream);
+  }
   uv__stream_osx_interrupt_select(stream);
 
   stream->read_cb = NULL;
@@ -1682,6 +1909,9 @@ void uv__stream_close(uv_stream_t* handle) {
   uv__io_close(handle->loop, &handle->io_watcher);
   uv_read_stop(handle);
   uv__handle_stop(handle);
+  uv__stream_idle_stop(handle);
+  uv__throttle_stop(&handle->read_throttle);
+  uv__throttle_stop(&handle->write_throttle);
 
   if (handle->io_watcher.fd != -1) {
     /* Don't close stdio file descriptors.  Nothing good comes from it. */
@@ -1708,6 +1938,24 @@ void uv__stream_close(uv_stream_t* handle) {
 }
 
 
+int uv_stream_set_rate_limit(uv_stream_t* handle,
+                             uv_rate_limit_t* read_limit,
+                             uv_rate_limit_t* write_limit) {
+  if (uv__is_closing(handle))
+    return UV_EINVAL;
+
+  if (read_limit != NULL && read_limit->loop != handle->loop)
+    return UV_EINVAL;
+
+  if (write_limit != NULL && write_limit->loop != handle->loop)
+    return UV_EINVAL;
+
+  uv__throttle_set(&handle->read_throttle, read_limit);
+  uv__throttle_set(&handle->write_throttle, write_limit);
+  return 0;
+}
+
+
 int uv_stream_set_blocking(uv_stream_t* handle, int blocking) {
   /* Don't need to check the file descriptor, uv__nonblock()
    * will fail with EBADF if it's not valid.
@@ -104,10 +104,8 @@ void uv__platform_invalidate_fd(uv_loop_t* loop, int fd) {
   uintptr_t i;
   uintptr_t nfds;
 
-  assert(loop->watchers != NULL);
-
-  events = (struct port_event*) loop->watchers[loop->nwatchers];
-  nfds = (uintptr_t) loop->watchers[loop->nwatchers + 1];
+  events = (struct port_event*) loop->poll_events;
+  nfds = loop->poll_nevents;
   if (events == NULL)
     return;
 
@@ -176,7 +174,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
 
   assert(timeout >= -1);
   base = loop->time;
-  count = 48; /* Benchmarks suggest this gives the best throughput. */
+  count = loop->io_budget.polls;
 
   for (;;) {
     if (timeout != -1) {
@@ -190,6 +188,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     nfds = 1;
     saved_errno = 0;
 
+    UV__POLL_ENTER(loop, timeout);
+
     if (pset != NULL)
       pthread_sigmask(SIG_BLOCK, pset, NULL);
 
@@ -202,6 +202,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     if (pset != NULL)
       pthread_sigmask(SIG_UNBLOCK, pset, NULL);
 
+    SAVE_ERRNO(UV__POLL_LEAVE(loop, (int) nfds));
+
     if (err) {
       /* Work around another kernel bug: port_getn() may return events even
        * on error.
@@ -236,9 +238,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     have_signals = 0;
     nevents = 0;
 
-    assert(loop->watchers != NULL);
-    loop->watchers[loop->nwatchers] = (void*) events;
-    loop->watchers[loop->nwatchers + 1] = (void*) (uintptr_t) nfds;
+    loop->poll_events = events;
+    loop->poll_nevents = nfds;
     for (i = 0; i < nfds; i++) {
       pe = events + i;
       fd = pe->portev_object;
@@ -250,12 +251,14 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
       assert(fd >= 0);
       assert((unsigned) fd < loop->nwatchers);
 
-      w = loop->watchers[fd];
+      w = uv__io_watcher(loop, fd);
 
       /* File descriptor that we've stopped watching, ignore. */
       if (w == NULL)
         continue;
 
+      UV__IO_EVENT(loop, w->fd, pe->portev_events);
+
       /* Run signal watchers last.  This also affects child process watchers
        * because those are implemented in terms of signal watchers.
        */
@@ -266,7 +269,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
 
       nevents++;
 
-      if (w != loop->watchers[fd])
+      if (w != uv__io_watcher(loop, fd))
         continue;  /* Disabled by callback. */
 
       /* Events Ports operates in oneshot mode, rearm timer on next run. */
@@ -277,13 +280,16 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     if (have_signals != 0)
       loop->signal_io_watcher.cb(loop, &loop->signal_io_watcher, POLLIN);
 
-    loop->watchers[loop->nwatchers] = NULL;
-    loop->watchers[loop->nwatchers + 1] = NULL;
+    loop->poll_events = NULL;
+    loop->poll_nevents = 0;
 
     if (have_signals != 0)
       return;  /* Event loop should cycle now so don't poll again. */
 
     if (nevents != 0) {
+      if (uv__io_budget_spent(loop))
+        return;
+
       if (nfds == ARRAY_SIZE(events) && --count != 0) {
         /* Poll for more events but don't block this time. */
         timeout = 0;
@@ -44,6 +44,8 @@ static void uv__udp_run_completed(uv_udp_t* handle);
 static void uv__udp_io(uv_loop_t* loop, uv__io_t* w, unsigned int revents);
 static void uv__udp_recvmsg(uv_udp_t* handle);
 static void uv__udp_sendmsg(uv_udp_t* handle);
+static void uv__udp_recv_resume(uv__throttle_t* t);
+static void uv__udp_send_resume(uv__throttle_t* t);
 static int uv__udp_maybe_deferred_bind(uv_udp_t* handle,
                                        int domain,
                                        unsigned int flags);
@@ -52,6 +54,8 @@ static int uv__udp_maybe_deferred_bind(uv_udp_t* handle,
 void uv__udp_close(uv_udp_t* handle) {
   uv__io_close(handle->loop, &handle->io_watcher);
   uv__handle_stop(handle);
+  uv__throttle_stop(&handle->recv_throttle);
+  uv__throttle_stop(&handle->send_throttle);
 
   if (handle->io_watcher.fd != -1) {
     uv__close(handle->io_watcher.fd);
@@ -89,6 +93,7 @@ void uv__udp_finish_close(uv_udp_t* handle) {
 
 
 static void uv__udp_run_completed(uv_udp_t* handle) {
+  struct uv__cb_frame frame;
   uv_udp_send_t* req;
   QUEUE* q;
 
@@ -105,8 +110,13 @@ static void uv__udp_run_completed(uv_udp_t* handle) {
     handle->send_queue_size -= uv__count_bufs(req->bufs, req->nbufs);
     handle->send_queue_count--;
 
-    if (req->bufs != req->bufsml)
+    if (req->bufs != req->bufsml) {
+      uv__mem_account(handle->loop,
+                      UV_MEM_UDP_SEND_QUEUE,
+                      req->nbufs * sizeof(req->bufs[0]),
+                      0);
       uv__free(req->bufs);
+    }
     req->bufs = NULL;
 
     if (req->send_cb == NULL)
@@ -115,17 +125,21 @@ static void uv__udp_run_completed(uv_udp_t* handle) {
     /* req->status >= 0 == bytes written
      * req->status <  0 == errno
      */
+    UV__REQ_CB_ENTER(handle->loop, &frame, req, req->send_cb);
     if (req->status >= 0)
       req->send_cb(req, 0);
     else
       req->send_cb(req, req->status);
+    UV__CB_LEAVE(handle->loop, &frame);
   }
 
   if (QUEUE_EMPTY(&handle->write_queue)) {
     /* Pending queue and completion queue empty, stop watcher. */
     uv__io_stop(handle->loop, &handle->io_watcher, POLLOUT);
-    if (!uv__io_active(&handle->io_watcher, POLLIN))
+    if (!uv__io_active(&handle->io_watcher, POLLIN) &&
+        !uv__throttled(&handle->recv_throttle)) {
       uv__handle_stop(handle);
+    }
   }
 
   handle->flags &= ~UV_UDP_PROCESSING;
@@ -133,11 +147,14 @@ static void uv__udp_run_completed(uv_udp_t* handle) {
 
 
 static void uv__udp_io(uv_loop_t* loop, uv__io_t* w, unsigned int revents) {
+  struct uv__cb_frame frame;
   uv_udp_t* handle;
 
   handle = container_of(w, uv_udp_t, io_watcher);
   assert(handle->type == UV_UDP);
 
+  UV__CB_ENTER(loop, &frame, handle);
+
   if (revents & POLLIN)
     uv__udp_recvmsg(handle);
 
@@ -145,6 +162,41 @@ static void uv__udp_io(uv_loop_t* loop, uv__io_t* w, unsigned int revents) {
     uv__udp_sendmsg(handle);
     uv__udp_run_completed(handle);
   }
+
+  UV__CB_LEAVE(loop, &frame);
+}
+
+
+static void uv__udp_recv_resume(uv__throttle_t* t) {
+  uv_udp_t* handle;
+
+  handle = container_of(t, uv_udp_t, recv_throttle);
+  if (handle->recv_cb != NULL)
+    uv__io_start(handle->loop, &handle->io_watcher, POLLIN);
+}
+
+
+static void uv__udp_send_resume(uv__throttle_t* t) {
+  uv_udp_t* handle;
+
+  handle = container_of(t, uv_udp_t, send_throttle);
+  if (!QUEUE_EMPTY(&handle->write_queue))
+    uv__io_start(handle->loop, &handle->io_watcher, POLLOUT);
+}
+
+
+/* Datagrams can't be cut short to fit the limit.  One goes out or comes in
+ * as long as there are tokens, possibly leaving the limiter in debt.
+ */
+static int uv__udp_throttle(uv_udp_t* handle,
+                            uv__throttle_t* t,
+                            unsigned int events) {
+  if (t->limit == NULL || uv__rate_limit_avail(t->limit) > 0)
+    return 0;
+
+  uv__io_stop(handle->loop, &handle->io_watcher, events);
+  uv__throttle_start(t);
+  return 1;
 }
 
 
@@ -162,12 +214,17 @@ static void uv__udp_recvmsg(uv_udp_t* handle) {
   /* Prevent loop starvation when the data comes in as fast as (or faster than)
    * we can read it. XXX Need to rearm fd if we switch to edge-triggered I/O.
    */
-  count = 32;
+  count = handle->read_budget;
+  if (count == 0)
+    count = handle->loop->io_budget.reads_per_event;
 
   memset(&h, 0, sizeof(h));
   h.msg_name = &peer;
 
   do {
+    if (uv__udp_throttle(handle, &handle->recv_throttle, POLLIN))
+      return;
+
     buf = uv_buf_init(NULL, 0);
     handle->alloc_cb((uv_handle_t*) handle, 64 * 1024, &buf);
     if (buf.base == NULL || buf.len == 0) {
@@ -202,6 +259,12 @@ static void uv__udp_recvmsg(uv_udp_t* handle) {
       if (h.msg_flags & MSG_TRUNC)
         flags |= UV_UDP_PARTIAL;
 
+      UV__PROBE2(udp__recv, handle, nread);
+      UV__HANDLE_BYTES(handle->loop, handle, nread, 0);
+      handle->loop->io_bytes += nread;
+      if (handle->recv_throttle.limit != NULL)
+        uv__rate_limit_consume(handle->recv_throttle.limit, nread);
+
       handle->recv_cb(handle, nread, &buf, addr, flags);
     }
   }
@@ -209,7 +272,8 @@ static void uv__udp_recvmsg(uv_udp_t* handle) {
   while (nread != -1
       && count-- > 0
       && handle->io_watcher.fd != -1
-      && handle->recv_cb != NULL);
+      && handle->recv_cb != NULL
+      && !uv__io_budget_spent(handle->loop));
 }
 
 
@@ -226,6 +290,9 @@ static void uv__udp_sendmsg(uv_udp_t* handle) {
     req = QUEUE_DATA(q, uv_udp_send_t, queue);
     assert(req != NULL);
 
+    if (uv__udp_throttle(handle, &handle->send_throttle, POLLOUT))
+      break;
+
     memset(&h, 0, sizeof h);
     h.msg_name = &req->addr;
     h.msg_namelen = (req->addr.ss_family == AF_INET6 ?
@@ -241,6 +308,13 @@ static void uv__udp_sendmsg(uv_udp_t* handle) {
       break;
 
     req->status = (size == -1 ? -errno : size);
+    if (size > 0) {
+      UV__PROBE2(udp__send, handle, size);
+      UV__HANDLE_BYTES(handle->loop, handle, 0, size);
+      handle->loop->io_bytes += size;
+      if (handle->send_throttle.limit != NULL)
+        uv__rate_limit_consume(handle->send_throttle.limit, size);
+    }
 
     /* Sending a datagram is an atomic operation: either all data
      * is written or nothing is (and EMSGSIZE is raised). That is
@@ -419,6 +493,12 @@ int uv__udp_send(uv_udp_send_t* req,
     return -ENOMEM;
   }
 
+  if (req->bufs != req->bufsml)
+    uv__mem_account(handle->loop,
+                    UV_MEM_UDP_SEND_QUEUE,
+                    0,
+                    nbufs * sizeof(bufs[0]));
+
   memcpy(req->bufs, bufs, nbufs * sizeof(bufs[0]));
   handle->send_queue_size += uv__count_bufs(req->bufs, req->nbufs);
   handle->send_queue_count++;
@@ -432,9 +512,11 @@ int uv__udp_send(uv_udp_send_t* req,
      * away. In such cases the `io_watcher` has to be queued for asynchronous
      * write.
      */
-    if (!QUEUE_EMPTY(&handle->write_queue))
+    if (!QUEUE_EMPTY(&handle->write_queue) &&
+        !uv__throttled(&handle->send_throttle)) {
       uv__io_start(handle->loop, &handle->io_watcher, POLLOUT);
-  } else {
+    }
+  } else if (!uv__throttled(&handle->send_throttle)) {
     uv__io_start(handle->loop, &handle->io_watcher, POLLOUT);
   }
 
@@ -457,6 +539,11 @@ int uv__udp_try_send(uv_udp_t* handle,
   if (handle->send_queue_count != 0)
     return -EAGAIN;
 
+  if (handle->send_throttle.limit != NULL &&
+      uv__rate_limit_avail(handle->send_throttle.limit) == 0) {
+    return -EAGAIN;
+  }
+
   err = uv__udp_maybe_deferred_bind(handle, addr->sa_family, 0);
   if (err)
     return err;
@@ -478,6 +565,11 @@ int uv__udp_try_send(uv_udp_t* handle,
       return -errno;
   }
 
+  UV__PROBE2(udp__send, handle, size);
+  UV__HANDLE_BYTES(handle->loop, handle, 0, size);
+  handle->loop->io_bytes += size;
+  if (handle->send_throttle.limit != NULL)
+    uv__rate_limit_consume(handle->send_throttle.limit, size);
   return size;
 }
 
@@ -604,6 +696,9 @@ int uv_udp_init_ex(uv_loop_t* loop, uv_udp_t* handle, unsigned int flags) {
   handle->send_queue_size = 0;
   handle->send_queue_count = 0;
   uv__io_init(&handle->io_watcher, uv__udp_io, fd);
+  uv__throttle_init(&handle->recv_throttle, uv__udp_recv_resume);
+  uv__throttle_init(&handle->send_throttle, uv__udp_send_resume);
+  handle->read_budget = 0;
   QUEUE_INIT(&handle->write_queue);
   QUEUE_INIT(&handle->write_completed_queue);
   return 0;
@@ -889,12 +984,33 @@ int uv__udp_recv_start(uv_udp_t* handle,
 
 int uv__udp_recv_stop(uv_udp_t* handle) {
   uv__io_stop(handle->loop, &handle->io_watcher, POLLIN);
+  uv__throttle_stop(&handle->recv_throttle);
 
-  if (!uv__io_active(&handle->io_watcher, POLLOUT))
+  if (!uv__io_active(&handle->io_watcher, POLLOUT) &&
+      !uv__throttled(&handle->send_throttle)) {
     uv__handle_stop(handle);
+  }
 
   handle->alloc_cb = NULL;
   handle->recv_cb = NULL;
 
   return 0;
 }
+
+
+int uv_udp_set_rate_limit(uv_udp_t* handle,
+                          uv_rate_limit_t* recv_limit,
+                          uv_rate_limit_t* send_limit) {
+  if (uv__is_closing(handle))
+    return UV_EINVAL;
+
+  if (recv_limit != NULL && recv_limit->loop != handle->loop)
+    return UV_EINVAL;
+
+  if (send_limit != NULL && send_limit->loop != handle->loop)
+    return UV_EINVAL;
+
+  uv__throttle_set(&handle->recv_throttle, recv_limit);
+  uv__throttle_set(&handle->send_throttle, send_limit);
+  return 0;
+}
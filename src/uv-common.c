@@ -492,10 +492,24 @@ static unsigned int* uv__get_nbufs(uv_fs_t* req) {
 */
 #ifdef _WIN32
 # define uv__fs_scandir_free uv__free
+# define uv__fs_scandir_account(size)
 #else
 # define uv__fs_scandir_free free
+# define uv__fs_scandir_account(size)                                         \
+  uv__mem_account(NULL, UV_MEM_SCANDIR, (size), 0)
 #endif
 
+static void uv__fs_scandir_free_dent(uv__dirent_t* dent) {
+  uv__fs_scandir_account(UV__DIRENT_SIZE(dent));
+  uv__fs_scandir_free(dent);
+}
+
+static void uv__fs_scandir_free_dents(uv_fs_t* req) {
+  uv__fs_scandir_account(req->result * sizeof(uv__dirent_t*));
+  uv__fs_scandir_free(req->ptr);
+  req->ptr = NULL;
+}
+
 void uv__fs_scandir_cleanup(uv_fs_t* req) {
   uv__dirent_t** dents;
 
@@ -505,10 +519,9 @@ void uv__fs_scandir_cleanup(uv_fs_t* req) {
   if (*nbufs > 0 && *nbufs != (unsigned int) req->result)
     (*nbufs)--;
   for (; *nbufs < (unsigned int) req->result; (*nbufs)++)
-    uv__fs_scandir_free(dents[*nbufs]);
+    uv__fs_scandir_free_dent(dents[*nbufs]);
 
-  uv__fs_scandir_free(req->ptr);
-  req->ptr = NULL;
+  uv__fs_scandir_free_dents(req);
 }
 
 
@@ -532,12 +545,11 @@ int uv_fs_scandir_next(uv_fs_t* req, uv_dirent_t* ent) {
 
   /* Free previous entity */
   if (*nbufs > 0)
-    uv__fs_scandir_free(dents[*nbufs - 1]);
+    uv__fs_scandir_free_dent(dents[*nbufs - 1]);
 
   /* End was already reached */
   if (*nbufs == (unsigned int) req->result) {
-    uv__fs_scandir_free(dents);
-    req->ptr = NULL;
+    uv__fs_scandir_free_dents(req);
     return UV_EOF;
   }
 
@@ -633,6 +645,11 @@ int uv_loop_close(uv_loop_t* loop) {
   if (!QUEUE_EMPTY(&(loop)->active_reqs))
     return UV_EBUSY;
 
+#ifndef _WIN32
+  if (loop->defer_count != 0)
+    return UV_EBUSY;
+#endif
+
   QUEUE_FOREACH(q, &loop->handle_queue) {
     h = QUEUE_DATA(q, uv_handle_t, handle_queue);
     if (!(h->flags & UV__HANDLE_INTERNAL))
@@ -640,6 +657,7 @@ int uv_loop_close(uv_loop_t* loop) {
   }
 
   uv__loop_close(loop);
+  uv__loop_watchers_close(loop);
 
 #ifndef NDEBUG
   saved_data = loop->data;
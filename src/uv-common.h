@@ -36,6 +36,10 @@
 #include "uv/tree.h"
 #include "queue.h"
 
+#if defined(HAVE_SYS_SDT_H)
+# include <sys/sdt.h>
+#endif
+
 
 #define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
 
@@ -45,6 +49,17 @@
 #define STATIC_ASSERT(expr)                                                   \
   void uv__static_assert(int static_assert_failed[1 - 2 * !(expr)])
 
+/* Static USDT probes in the "libuv" provider, compiled in when the system
+ * has <sys/sdt.h>.  A disabled probe is a single nop.
+ */
+#if defined(HAVE_SYS_SDT_H)
+# define UV__PROBE1(name, a) DTRACE_PROBE1(libuv, name, a)
+# define UV__PROBE2(name, a, b) DTRACE_PROBE2(libuv, name, a, b)
+#else
+# define UV__PROBE1(name, a) do {} while (0)
+# define UV__PROBE2(name, a, b) do {} while (0)
+#endif
+
 #ifndef _WIN32
 enum {
   UV__SIGNAL_ONE_SHOT = 0x80000,  /* On signal reception remove sighandler */
@@ -64,6 +79,87 @@ enum {
 
 int uv__loop_configure(uv_loop_t* loop, uv_loop_option option, va_list ap);
 
+/* Callback instrumentation.  Bracket a handle's callback with UV__CB_ENTER()
+ * and UV__CB_LEAVE() to charge the time spent in it to the handle when the
+ * loop is instrumented.  Nested frames only charge their own time.  Request
+ * callbacks use UV__REQ_CB_ENTER(); their time is charged to the enclosing
+ * handle frame but the stall watchdog can attribute it to the request.
+ */
+#ifndef _WIN32
+struct uv__cb_frame {
+  struct uv__cb_frame* parent;
+  uv_handle_t* handle;
+  uv_req_t* req;
+  void (*cb)(void);
+  uint64_t start;
+  uint64_t nested;
+  int active;
+};
+
+void uv__cb_enter(uv_loop_t* loop,
+                  struct uv__cb_frame* frame,
+                  uv_handle_t* handle);
+void uv__req_cb_enter(uv_loop_t* loop,
+                      struct uv__cb_frame* frame,
+                      uv_req_t* req,
+                      void (*cb)(void));
+void uv__cb_leave(uv_loop_t* loop, struct uv__cb_frame* frame);
+
+# define UV__CB_ENTER(loop, frame, h)                                         \
+  do {                                                                        \
+    (frame)->active = 0;                                                      \
+    if ((loop)->instrument != NULL)                                           \
+      uv__cb_enter((loop), (frame), (uv_handle_t*) (h));                      \
+  }                                                                           \
+  while (0)
+
+# define UV__REQ_CB_ENTER(loop, frame, r, cb)                                 \
+  do {                                                                        \
+    (frame)->active = 0;                                                      \
+    if ((loop)->instrument != NULL)                                           \
+      uv__req_cb_enter((loop),                                                \
+                       (frame),                                               \
+                       (uv_req_t*) (r),                                       \
+                       (void (*)(void)) (cb));                                \
+  }                                                                           \
+  while (0)
+
+# define UV__CB_LEAVE(loop, frame)                                            \
+  do {                                                                        \
+    if ((frame)->active)                                                      \
+      uv__cb_leave((loop), (frame));                                          \
+  }                                                                           \
+  while (0)
+#else
+struct uv__cb_frame {
+  int active;
+};
+
+# define UV__CB_ENTER(loop, frame, h) ((void) (frame))
+# define UV__REQ_CB_ENTER(loop, frame, r, cb) ((void) (frame))
+# define UV__CB_LEAVE(loop, frame) ((void) (frame))
+#endif
+
+/* Completion queue.  A callback site that can be deferred to uv_loop_drain()
+ * skips the callback when UV__COMPLETION_QUEUED() is true.  Internal handles
+ * and requests always get their callback.
+ */
+#ifndef _WIN32
+int uv__completion_add(uv_loop_t* loop,
+                       uv_completion_kind kind,
+                       void* object,
+                       char* base,
+                       int64_t result);
+
+# define UV__COMPLETION_QUEUED(loop, kind, object, base, result)              \
+  ((loop)->completions != NULL &&                                             \
+   uv__completion_add((loop), (kind), (object), (base), (result)) == 0)
+#else
+# define UV__COMPLETION_QUEUED(loop, kind, object, base, result) 0
+#endif
+
+int uv__fs_poll_owns(const uv_fs_t* req);
+
 void uv__loop_close(uv_loop_t* loop);
 
 int uv__tcp_bind(uv_tcp_t* tcp,
@@ -197,7 +293,12 @@ void uv__fs_scandir_cleanup(uv_fs_t* req);
 #if defined(_WIN32)
 # define uv__handle_platform_init(h)
 #else
-# define uv__handle_platform_init(h) ((h)->next_closing = NULL)
+# define uv__handle_platform_init(h)                                          \
+  do {                                                                        \
+    (h)->next_closing = NULL;                                                 \
+    (h)->stats = NULL;                                                        \
+  }                                                                           \
+  while (0)
 #endif
 
 #define uv__handle_init(loop_, h, type_)                                      \
@@ -243,7 +344,23 @@ void* uv__malloc(size_t size);
 void uv__free(void* ptr);
 void* uv__realloc(void* ptr, size_t size);
 
+/* Memory accounting, see uv_loop_mem_stats().  Records a change in the size of
+ * an allocation from old_size to new_size bytes; a size of zero means "no
+ * allocation".  Pass a NULL loop for the process-wide categories.
+ */
+void uv__mem_account(uv_loop_t* loop,
+                     uv_mem_category category,
+                     size_t old_size,
+                     size_t new_size);
+
+#define UV__DIRENT_SIZE(dent)                                                 \
+  (offsetof(uv__dirent_t, d_name) + strlen((dent)->d_name) + 1)
+
 /* Loop watcher prototypes */
+#define uv__watcher_list_empty(list) ((list)->count == (list)->holes)
+
+void uv__loop_watchers_init(uv_loop_t* loop);
+void uv__loop_watchers_close(uv_loop_t* loop);
 void uv__idle_close(uv_idle_t* handle);
 void uv__prepare_close(uv_prepare_t* handle);
 void uv__check_close(uv_check_t* handle);
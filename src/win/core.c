@@ -135,9 +135,7 @@ int uv_loop_init(uv_loop_t* loop) {
   heap_init((struct heap*) &loop->timer_heap);
   loop->timer_counter = 0;
 
-  QUEUE_INIT(&loop->check_handles);
-  QUEUE_INIT(&loop->prepare_handles);
-  QUEUE_INIT(&loop->idle_handles);
+  uv__loop_watchers_init(loop);
 
   QUEUE_INIT(&loop->async_handles);
   UV_REQ_INIT(&loop->async_req, UV_WAKEUP);
@@ -210,6 +208,56 @@ int uv__loop_configure(uv_loop_t* loop, uv_loop_option option, va_list ap) {
 }
 
 
+int uv_loop_mem_stats(const uv_loop_t* loop,
+                      uv_mem_category category,
+                      uv_mem_stats_t* stats) {
+  return UV_ENOSYS;
+}
+
+
+int uv_handle_get_stats(const uv_handle_t* handle, uv_handle_stats_t* stats) {
+  return UV_ENOSYS;
+}
+
+
+int uv_walk_by_cost(uv_loop_t* loop, uv_walk_cb walk_cb, void* arg) {
+  return UV_ENOSYS;
+}
+
+
+int uv_loop_watchdog_start(uv_loop_t* loop,
+                           uint64_t threshold,
+                           int signum,
+                           uv_stall_cb cb) {
+  return UV_ENOSYS;
+}
+
+
+int uv_loop_watchdog_stop(uv_loop_t* loop) {
+  return UV_ENOSYS;
+}
+
+
+int uv_loop_drain(uv_loop_t* loop,
+                  uv_completion_t* completions,
+                  unsigned int n) {
+  return UV_ENOSYS;
+}
+
+
+int uv_loop_trace_dump(uv_loop_t* loop, void* stream) {
+  return UV_ENOSYS;
+}
+
+
+int uv_defer(uv_loop_t* loop,
+             uv_defer_phase phase,
+             uv_defer_cb cb,
+             void* arg) {
+  return UV_ENOSYS;
+}
+
+
 uv_os_fd_t uv_backend_fd(const uv_loop_t* loop) {
   return loop->iocp;
 }
@@ -228,7 +276,7 @@ int uv_backend_timeout(const uv_loop_t* loop) {
   if (loop->endgame_handles)
     return 0;
 
-  if (!QUEUE_EMPTY(&loop->idle_handles))
+  if (!uv__watcher_list_empty(&loop->idle_handles))
     return 0;
 
   return uv__next_timeout(loop);
@@ -357,6 +405,31 @@ int uv_loop_alive(const uv_loop_t* loop) {
 }
 
 
+/* The first half of an iteration, up to the wait for i/o.  Returns non-zero
+ * if pending callbacks ran.
+ */
+static int uv__run_prepare_phase(uv_loop_t* loop) {
+  int ran_pending;
+
+  uv_update_time(loop);
+  uv__run_timers(loop);
+
+  ran_pending = uv_process_reqs(loop);
+  uv__run_idle(loop);
+  uv__run_prepare(loop);
+
+  return ran_pending;
+}
+
+
+static void uv__run_poll(uv_loop_t* loop, int timeout) {
+  if (pGetQueuedCompletionStatusEx)
+    uv__loop_poll(loop, timeout == -1 ? INFINITE : timeout);
+  else
+    uv__loop_poll_wine(loop, timeout == -1 ? INFINITE : timeout);
+}
+
+
 int uv_run(uv_loop_t *loop, uv_run_mode mode) {
   int timeout;
   int r;
@@ -367,21 +440,13 @@ int uv_run(uv_loop_t *loop, uv_run_mode mode) {
     uv_update_time(loop);
 
   while (r != 0 && loop->stop_flag == 0) {
-    uv_update_time(loop);
-    uv__run_timers(loop);
-
-    ran_pending = uv_process_reqs(loop);
-    uv__run_idle(loop);
-    uv__run_prepare(loop);
+    ran_pending = uv__run_prepare_phase(loop);
 
     timeout = 0;
     if ((mode == UV_RUN_ONCE && !ran_pending) || mode == UV_RUN_DEFAULT)
       timeout = uv_backend_timeout(loop);
 
-    if (pGetQueuedCompletionStatusEx)
-      uv__loop_poll(loop, timeout == -1 ? INFINITE : timeout);
-    else
-      uv__loop_poll_wine(loop, timeout == -1 ? INFINITE : timeout);
+    uv__run_poll(loop, timeout);
 
     uv__run_check(loop);
     uv_process_endgames(loop);
@@ -413,6 +478,31 @@ int uv_run(uv_loop_t *loop, uv_run_mode mode) {
 }
 
 
+int uv_loop_prepare(uv_loop_t* loop) {
+  if (uv__run_prepare_phase(loop))
+    return 0;
+
+  return uv_backend_timeout(loop);
+}
+
+
+int uv_loop_dispatch(uv_loop_t* loop) {
+  uv__run_poll(loop, 0);
+  uv__run_check(loop);
+  uv_process_endgames(loop);
+
+  if (loop->stop_flag != 0)
+    loop->stop_flag = 0;
+
+  return uv__loop_alive(loop);
+}
+
+
+int uv_run_budget(uv_loop_t* loop, uint64_t budget) {
+  return UV_ENOSYS;
+}
+
+
 int uv_fileno(const uv_handle_t* handle, uv_os_fd_t* fd) {
   uv_os_fd_t fd_out;
 
@@ -449,6 +539,21 @@ int uv_fileno(const uv_handle_t* handle, uv_os_fd_t* fd) {
 }
 
 
+int uv_handle_set_priority(uv_handle_t* handle, uv_priority priority) {
+  return UV_ENOSYS;
+}
+
+
+uv_priority uv_handle_get_priority(const uv_handle_t* handle) {
+  return UV_PRIORITY_NORMAL;
+}
+
+
+int uv_handle_set_read_budget(uv_handle_t* handle, unsigned int reads) {
+  return UV_ENOSYS;
+}
+
+
 int uv__socket_sockopt(uv_handle_t* handle, int optname, int* value) {
   int r;
   int len;
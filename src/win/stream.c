@@ -246,3 +246,31 @@ int uv_stream_set_blocking(uv_stream_t* handle, int blocking) {
 
   return 0;
 }
+
+
+int uv_stream_set_idle_timeout(uv_stream_t* handle,
+                               unsigned int flags,
+                               uint64_t timeout,
+                               uv_idle_timeout_cb cb) {
+  return UV_ENOSYS;
+}
+
+
+int uv_rate_limit_init(uv_loop_t* loop,
+                       uv_rate_limit_t* limit,
+                       uint64_t rate,
+                       uint64_t burst) {
+  return UV_ENOSYS;
+}
+
+
+int uv_rate_limit_set(uv_rate_limit_t* limit, uint64_t rate, uint64_t burst) {
+  return UV_ENOSYS;
+}
+
+
+int uv_stream_set_rate_limit(uv_stream_t* handle,
+                             uv_rate_limit_t* read_limit,
+                             uv_rate_limit_t* write_limit) {
+  return UV_ENOSYS;
+}
@@ -894,3 +894,10 @@ int uv__udp_try_send(uv_udp_t* handle,
 
   return bytes;
 }
+
+
+int uv_udp_set_rate_limit(uv_udp_t* handle,
+                          uv_rate_limit_t* recv_limit,
+                          uv_rate_limit_t* send_limit) {
+  return UV_ENOSYS;
+}
@@ -0,0 +1,861 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench-harness.h"
+#include "runner.h"
+#include "task.h"
+#include "uv.h"
+
+#if defined(__linux__)
+# include <linux/perf_event.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+#define BENCH_MAX_SAMPLES 100
+#define BENCH_MAX_METRICS 16
+#define BENCH_MAX_RESULTS 64
+#define BENCH_METRIC_PREFIX "@metric "
+
+typedef struct {
+  char name[64];
+  char unit[32];
+  double samples[BENCH_MAX_SAMPLES];
+  int nsamples;
+} bench_metric_t;
+
+typedef struct {
+  const char* name;
+  int status;
+  bench_metric_t metrics[BENCH_MAX_METRICS];
+  int nmetrics;
+} bench_result_t;
+
+typedef struct {
+  double min;
+  double median;
+  double p99;
+  double mean;
+  double stddev;
+} bench_stats_t;
+
+enum bench_format {
+  BENCH_TEXT,
+  BENCH_JSON,
+  BENCH_CSV
+};
+
+
+void benchmark_report(const char* metric, double value, const char* unit) {
+  /* Only the harness is interested, keep the human-readable output clean. */
+  if (getenv("UV_BENCHMARK_REPORT") == NULL)
+    return;
+
+  fprintf(stderr, BENCH_METRIC_PREFIX "%s %.17g %s\n", metric, value, unit);
+  fflush(stderr);
+}
+
+
+#define HALF_COUNT (1 << (BENCH_HISTOGRAM_BITS - 1))
+
+static unsigned int bench_histogram_index(uint64_t v) {
+  int shift;
+
+  if (v < 2 * HALF_COUNT)
+    return (unsigned int) v;
+
+  /* Keep the BENCH_HISTOGRAM_BITS most significant bits. */
+  for (shift = 0; (v >> shift) >= 2 * HALF_COUNT; shift++);
+  return shift * HALF_COUNT + (unsigned int) (v >> shift);
+}
+
+
+static uint64_t bench_histogram_value(unsigned int index) {
+  unsigned int shift;
+
+  if (index < 2 * HALF_COUNT)
+    return index;
+
+  shift = index / HALF_COUNT - 1;
+  return (uint64_t) (index - shift * HALF_COUNT) << shift;
+}
+
+
+void bench_histogram_reset(bench_histogram_t* h) {
+  memset(h, 0, sizeof(*h));
+}
+
+
+void bench_histogram_record(bench_histogram_t* h, uint64_t value) {
+  h->counts[bench_histogram_index(value)]++;
+  h->total++;
+  if (value > h->max)
+    h->max = value;
+}
+
+
+/* Nearest rank, rounded down to the bucket's lowest value. */
+uint64_t bench_histogram_percentile(const bench_histogram_t* h, double p) {
+  uint64_t rank;
+  uint64_t seen;
+  unsigned int i;
+
+  rank = (uint64_t) (p / 100 * h->total + 0.5);
+  if (rank == 0)
+    rank = 1;
+
+  seen = 0;
+  for (i = 0; i < BENCH_HISTOGRAM_BUCKETS; i++) {
+    seen += h->counts[i];
+    if (seen >= rank)
+      return bench_histogram_value(i);
+  }
+
+  return h->max;
+}
+
+#undef HALF_COUNT
+
+
+static int compare_double(const void* va, const void* vb) {
+  double a;
+  double b;
+
+  a = *(const double*) va;
+  b = *(const double*) vb;
+
+  return a < b ? -1 : a > b;
+}
+
+
+static void bench_stats(const double* samples, int n, bench_stats_t* stats) {
+  double sorted[BENCH_MAX_SAMPLES];
+  double sum;
+  int rank;
+  int i;
+
+  memset(stats, 0, sizeof(*stats));
+  if (n == 0)
+    return;
+
+  memcpy(sorted, samples, n * sizeof(sorted[0]));
+  qsort(sorted, n, sizeof(sorted[0]), compare_double);
+
+  sum = 0;
+  for (i = 0; i < n; i++)
+    sum += sorted[i];
+
+  stats->min = sorted[0];
+  stats->mean = sum / n;
+
+  if (n % 2)
+    stats->median = sorted[n / 2];
+  else
+    stats->median = (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+
+  /* Nearest-rank percentile. */
+  rank = (int) ceil(0.99 * n);
+  stats->p99 = sorted[rank - 1];
+
+  if (n > 1) {
+    sum = 0;
+    for (i = 0; i < n; i++)
+      sum += (sorted[i] - stats->mean) * (sorted[i] - stats->mean);
+    stats->stddev = sqrt(sum / (n - 1));
+  }
+}
+
+
+static bench_metric_t* bench_metric(bench_result_t* result,
+                                    const char* name,
+                                    const char* unit) {
+  bench_metric_t* m;
+  int i;
+
+  for (i = 0; i < result->nmetrics; i++)
+    if (strcmp(result->metrics[i].name, name) == 0)
+      return &result->metrics[i];
+
+  if (result->nmetrics == BENCH_MAX_METRICS)
+    return NULL;
+
+  m = &result->metrics[result->nmetrics++];
+  snprintf(m->name, sizeof(m->name), "%s", name);
+  snprintf(m->unit, sizeof(m->unit), "%s", unit);
+  m->nsamples = 0;
+
+  return m;
+}
+
+
+static void bench_add_sample(bench_result_t* result,
+                             const char* name,
+                             const char* unit,
+                             double value) {
+  bench_metric_t* m;
+
+  m = bench_metric(result, name, unit);
+  if (m != NULL && m->nsamples < BENCH_MAX_SAMPLES)
+    m->samples[m->nsamples++] = value;
+}
+
+
+/* Runs the benchmark and its helpers once.  The output of the benchmark
+ * process ends up in `output`.
+ */
+static int bench_run_once(const char* name, FILE* output, double* wall) {
+  process_info_t processes[MAX_PROCESSES];
+  process_info_t* main_proc;
+  task_entry_t* task;
+  uint64_t start;
+  int nprocesses;
+  int nhelpers;
+  int status;
+  int i;
+
+  main_proc = NULL;
+  nprocesses = 0;
+  nhelpers = 0;
+  status = 255;
+
+#ifndef _WIN32
+  remove(TEST_PIPENAME);
+  remove(TEST_PIPENAME_2);
+  remove(TEST_PIPENAME_3);
+#endif
+
+  for (task = TASKS; task->main; task++) {
+    if (!task->is_helper || strcmp(name, task->task_name) != 0)
+      continue;
+
+    if (process_start(task->task_name, task->process_name,
+                      &processes[nprocesses], 1) == -1)
+      goto out;
+
+    nprocesses++;
+  }
+
+  /* Give the helpers time to settle, like run_test() does. */
+  nhelpers = nprocesses;
+  if (nhelpers > 0)
+    uv_sleep(250);
+
+  for (task = TASKS; task->main; task++)
+    if (!task->is_helper && strcmp(name, task->task_name) == 0)
+      break;
+
+  if (task->main == NULL)
+    goto out;
+
+  start = uv_hrtime();
+  if (process_start(task->task_name, task->process_name,
+                    &processes[nprocesses], 0) == -1)
+    goto out;
+
+  main_proc = &processes[nprocesses++];
+
+  if (process_wait(main_proc, 1, task->timeout) != 0)
+    goto out;
+
+  *wall = (uv_hrtime() - start) / 1e6;
+  status = process_reap(main_proc);
+  process_copy_output(main_proc, output);
+
+out:
+  if (main_proc != NULL && status == 255)
+    process_terminate(main_proc);
+
+  for (i = 0; i < nhelpers; i++)
+    process_terminate(&processes[i]);
+
+  for (i = 0; i < nprocesses; i++)
+    process_wait(&processes[i], 1, -1);
+
+  for (i = 0; i < nprocesses; i++)
+    process_cleanup(&processes[i]);
+
+  return status;
+}
+
+
+static void bench_parse_output(FILE* output, bench_result_t* result) {
+  char line[1024];
+  char name[64];
+  char unit[32];
+  double value;
+  char* p;
+
+  rewind(output);
+  while (fgets(line, sizeof(line), output) != NULL) {
+    /* process_copy_output() prefixes every line with "# ". */
+    p = line;
+    if (strncmp(p, "# ", 2) == 0)
+      p += 2;
+
+    if (strncmp(p, BENCH_METRIC_PREFIX, strlen(BENCH_METRIC_PREFIX)) != 0)
+      continue;
+
+    if (sscanf(p + strlen(BENCH_METRIC_PREFIX),
+               "%63s %lf %31s",
+               name,
+               &value,
+               unit) != 3)
+      continue;
+
+    bench_add_sample(result, name, unit, value);
+  }
+}
+
+
+static int bench_run(bench_result_t* result, int warmup, int repeat) {
+  double wall;
+  FILE* output;
+  int status;
+  int i;
+
+  for (i = 0; i < warmup + repeat; i++) {
+    output = tmpfile();
+    if (output == NULL)
+      return -1;
+
+    wall = 0;
+    status = bench_run_once(result->name, output, &wall);
+    if (status != TEST_OK) {
+      fclose(output);
+      result->status = status;
+      return status;
+    }
+
+    if (i >= warmup) {
+      bench_add_sample(result, "wall", "ms", wall);
+      bench_parse_output(output, result);
+    }
+
+    fclose(output);
+  }
+
+  result->status = 0;
+  return 0;
+}
+
+
+static void bench_print(FILE* fp,
+                        enum bench_format format,
+                        const bench_result_t* results,
+                        int nresults) {
+  const bench_metric_t* m;
+  bench_stats_t s;
+  const char* sep;
+  int i;
+  int j;
+  int k;
+
+  if (format == BENCH_CSV)
+    fprintf(fp, "benchmark,metric,unit,n,min,median,p99,mean,stddev\n");
+  else if (format == BENCH_JSON)
+    fprintf(fp, "{\"version\":1,\"results\":[\n");
+
+  sep = "";
+  for (i = 0; i < nresults; i++) {
+    if (results[i].status != 0) {
+      if (format == BENCH_TEXT)
+        fprintf(fp, "%s: failed with status %d\n",
+                results[i].name, results[i].status);
+      continue;
+    }
+
+    for (j = 0; j < results[i].nmetrics; j++) {
+      m = &results[i].metrics[j];
+      bench_stats(m->samples, m->nsamples, &s);
+
+      switch (format) {
+        case BENCH_TEXT:
+          fprintf(fp,
+                  "%-24s %-16s %-10s n=%-3d min=%-12.6g median=%-12.6g "
+                  "p99=%-12.6g stddev=%.3g\n",
+                  results[i].name, m->name, m->unit, m->nsamples,
+                  s.min, s.median, s.p99, s.stddev);
+          break;
+
+        case BENCH_CSV:
+          fprintf(fp, "%s,%s,%s,%d,%.17g,%.17g,%.17g,%.17g,%.17g\n",
+                  results[i].name, m->name, m->unit, m->nsamples,
+                  s.min, s.median, s.p99, s.mean, s.stddev);
+          break;
+
+        case BENCH_JSON:
+          /* One metric per line keeps bench_compare_main() simple. */
+          fprintf(fp,
+                  "%s{\"benchmark\":\"%s\",\"metric\":\"%s\",\"unit\":\"%s\","
+                  "\"min\":%.17g,\"median\":%.17g,\"p99\":%.17g,"
+                  "\"mean\":%.17g,\"stddev\":%.17g,\"samples\":[",
+                  sep, results[i].name, m->name, m->unit,
+                  s.min, s.median, s.p99, s.mean, s.stddev);
+          for (k = 0; k < m->nsamples; k++)
+            fprintf(fp, "%s%.17g", k > 0 ? "," : "", m->samples[k]);
+          fprintf(fp, "]}");
+          sep = ",\n";
+          break;
+      }
+    }
+  }
+
+  if (format == BENCH_JSON)
+    fprintf(fp, "\n]}\n");
+
+  fflush(fp);
+}
+
+
+static const char* bench_option(const char* arg, const char* name) {
+  size_t len;
+
+  len = strlen(name);
+  if (strncmp(arg, name, len) != 0 || arg[len] != '=')
+    return NULL;
+
+  return arg + len + 1;
+}
+
+
+static int bench_usage(void) {
+  fprintf(stderr,
+          "Usage: run-benchmarks [--repeat=N] [--warmup=N] "
+          "[--format=text|json|csv] [--output=FILE] [--perf] [benchmark...]\n"
+          "       run-benchmarks --compare [--threshold=PERCENT] OLD NEW\n");
+  return 2;
+}
+
+
+int bench_harness_main(int argc, char** argv) {
+  static bench_result_t results[BENCH_MAX_RESULTS];
+  enum bench_format format;
+  const char* output;
+  const char* val;
+  task_entry_t* task;
+  int nresults;
+  int nnames;
+  int repeat;
+  int warmup;
+  int failed;
+  FILE* fp;
+  int i;
+
+  format = BENCH_TEXT;
+  output = NULL;
+  repeat = 5;
+  warmup = 1;
+  nnames = 0;
+
+  for (i = 1; i < argc; i++) {
+    if ((val = bench_option(argv[i], "--repeat")) != NULL)
+      repeat = atoi(val);
+    else if ((val = bench_option(argv[i], "--warmup")) != NULL)
+      warmup = atoi(val);
+    else if ((val = bench_option(argv[i], "--output")) != NULL)
+      output = val;
+    else if ((val = bench_option(argv[i], "--format")) != NULL) {
+      if (strcmp(val, "json") == 0)
+        format = BENCH_JSON;
+      else if (strcmp(val, "csv") == 0)
+        format = BENCH_CSV;
+      else if (strcmp(val, "text") == 0)
+        format = BENCH_TEXT;
+      else
+        return bench_usage();
+    } else if (strcmp(argv[i], "--perf") == 0)
+      uv_os_setenv("UV_BENCHMARK_PERF", "1");
+    else if (argv[i][0] == '-')
+      return bench_usage();
+    else
+      argv[1 + nnames++] = argv[i];
+  }
+
+  if (repeat < 1 || repeat > BENCH_MAX_SAMPLES || warmup < 0)
+    return bench_usage();
+
+  uv_os_setenv("UV_BENCHMARK_REPORT", "1");
+
+  nresults = 0;
+  for (task = TASKS; task->main; task++) {
+    if (task->is_helper)
+      continue;
+
+    if (nnames > 0) {
+      for (i = 0; i < nnames; i++)
+        if (strcmp(argv[1 + i], task->task_name) == 0)
+          break;
+      if (i == nnames)
+        continue;
+    }
+
+    if (nresults == BENCH_MAX_RESULTS)
+      break;
+
+    memset(&results[nresults], 0, sizeof(results[nresults]));
+    results[nresults].name = task->task_name;
+    fprintf(stderr, "%s...\n", task->task_name);
+    fflush(stderr);
+    bench_run(&results[nresults], warmup, repeat);
+    nresults++;
+  }
+
+  fp = stdout;
+  if (output != NULL) {
+    fp = fopen(output, "w");
+    if (fp == NULL) {
+      fprintf(stderr, "%s: %s\n", output, strerror(errno));
+      return 1;
+    }
+  }
+
+  bench_print(fp, format, results, nresults);
+
+  if (fp != stdout)
+    fclose(fp);
+
+  failed = 0;
+  for (i = 0; i < nresults; i++)
+    if (results[i].status != 0)
+      failed++;
+
+  return failed;
+}
+
+
+/* Extracts the string value of "key" from a line of JSON output. */
+static int json_string(const char* line, const char* key, char* buf, size_t size) {
+  const char* p;
+  const char* q;
+  char pattern[64];
+
+  snprintf(pattern, sizeof(pattern), "\"%s\":\"", key);
+  p = strstr(line, pattern);
+  if (p == NULL)
+    return -1;
+
+  p += strlen(pattern);
+  q = strchr(p, '"');
+  if (q == NULL || (size_t) (q - p) >= size)
+    return -1;
+
+  memcpy(buf, p, q - p);
+  buf[q - p] = '\0';
+  return 0;
+}
+
+
+static int bench_load(const char* path, bench_result_t* results, int max) {
+  static char line[65536];
+  bench_result_t* r;
+  char benchmark[64];
+  char metric[64];
+  char unit[32];
+  const char* p;
+  char* end;
+  double value;
+  int nresults;
+  FILE* fp;
+  int i;
+
+  fp = fopen(path, "r");
+  if (fp == NULL) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return -1;
+  }
+
+  nresults = 0;
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    if (json_string(line, "benchmark", benchmark, sizeof(benchmark)) ||
+        json_string(line, "metric", metric, sizeof(metric)) ||
+        json_string(line, "unit", unit, sizeof(unit)))
+      continue;
+
+    p = strstr(line, "\"samples\":[");
+    if (p == NULL)
+      continue;
+    p += strlen("\"samples\":[");
+
+    r = NULL;
+    for (i = 0; i < nresults; i++)
+      if (strcmp(results[i].name, benchmark) == 0)
+        r = &results[i];
+
+    if (r == NULL) {
+      if (nresults == max)
+        continue;
+      r = &results[nresults++];
+      memset(r, 0, sizeof(*r));
+      r->name = strdup(benchmark);
+    }
+
+    while (*p != ']' && *p != '\0') {
+      value = strtod(p, &end);
+      if (end == p)
+        break;
+      bench_add_sample(r, metric, unit, value);
+      p = end;
+      if (*p == ',')
+        p++;
+    }
+  }
+
+  fclose(fp);
+  return nresults;
+}
+
+
+/* Two-sided 95% critical values of Student's t distribution. */
+static double t_critical(double df) {
+  static const double table[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+  };
+
+  if (df < 1)
+    df = 1;
+
+  if (df <= ARRAY_SIZE(table))
+    return table[(int) df - 1];
+
+  return 1.960;
+}
+
+
+/* Rates ("ops/s") are better when higher, everything else when lower. */
+static int higher_is_better(const char* unit) {
+  size_t len;
+
+  len = strlen(unit);
+  return len >= 2 && strcmp(unit + len - 2, "/s") == 0;
+}
+
+
+int bench_compare_main(int argc, char** argv) {
+  static bench_result_t before[BENCH_MAX_RESULTS];
+  static bench_result_t after[BENCH_MAX_RESULTS];
+  const bench_metric_t* a;
+  const bench_metric_t* b;
+  const char* paths[2];
+  const char* verdict;
+  const char* val;
+  bench_stats_t sa;
+  bench_stats_t sb;
+  double threshold;
+  double change;
+  double va;
+  double vb;
+  double se;
+  double df;
+  double t;
+  int significant;
+  int regressions;
+  int nbefore;
+  int nafter;
+  int npaths;
+  int i;
+  int j;
+  int k;
+  int l;
+
+  threshold = 5;
+  npaths = 0;
+
+  for (i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--compare") == 0)
+      continue;
+    if ((val = bench_option(argv[i], "--threshold")) != NULL)
+      threshold = atof(val);
+    else if (argv[i][0] == '-' || npaths == 2)
+      return bench_usage();
+    else
+      paths[npaths++] = argv[i];
+  }
+
+  if (npaths != 2)
+    return bench_usage();
+
+  nbefore = bench_load(paths[0], before, BENCH_MAX_RESULTS);
+  nafter = bench_load(paths[1], after, BENCH_MAX_RESULTS);
+  if (nbefore < 0 || nafter < 0)
+    return -1;
+
+  regressions = 0;
+  for (i = 0; i < nafter; i++) {
+    for (j = 0; j < nbefore; j++)
+      if (strcmp(before[j].name, after[i].name) == 0)
+        break;
+    if (j == nbefore)
+      continue;
+
+    for (k = 0; k < after[i].nmetrics; k++) {
+      b = &after[i].metrics[k];
+      a = NULL;
+      for (l = 0; l < before[j].nmetrics; l++)
+        if (strcmp(before[j].metrics[l].name, b->name) == 0)
+          a = &before[j].metrics[l];
+      if (a == NULL || a->nsamples == 0 || b->nsamples == 0)
+        continue;
+
+      bench_stats(a->samples, a->nsamples, &sa);
+      bench_stats(b->samples, b->nsamples, &sb);
+
+      change = 0;
+      if (sa.mean != 0)
+        change = 100 * (sb.mean - sa.mean) / sa.mean;
+
+      /* Welch's t-test; needs at least two samples on both sides. */
+      significant = 0;
+      if (a->nsamples > 1 && b->nsamples > 1) {
+        va = sa.stddev * sa.stddev / a->nsamples;
+        vb = sb.stddev * sb.stddev / b->nsamples;
+        se = sqrt(va + vb);
+        if (se == 0) {
+          significant = sa.mean != sb.mean;
+        } else {
+          t = (sb.mean - sa.mean) / se;
+          df = (va + vb) * (va + vb) /
+               (va * va / (a->nsamples - 1) + vb * vb / (b->nsamples - 1));
+          significant = fabs(t) > t_critical(df);
+        }
+      }
+
+      verdict = "";
+      if (significant && fabs(change) >= threshold) {
+        if ((change < 0) == higher_is_better(b->unit)) {
+          verdict = "  REGRESSION";
+          regressions++;
+        } else {
+          verdict = "  improvement";
+        }
+      }
+
+      printf("%-24s %-16s %-10s %12.6g -> %-12.6g %+7.2f%%%s\n",
+             after[i].name, b->name, b->unit, sa.mean, sb.mean, change, verdict);
+    }
+  }
+
+  fflush(stdout);
+  return regressions;
+}
+
+
+#if defined(__linux__)
+static struct {
+  const char* name;
+  uint32_t type;
+  uint64_t config;
+  int fd;
+} bench_counters[] = {
+  { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1 },
+  { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, -1 },
+  { "context_switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, -1 },
+  { "syscalls", PERF_TYPE_TRACEPOINT, 0, -1 },
+};
+
+
+/* The id of the raw_syscalls:sys_enter tracepoint, or -1 if tracefs isn't
+ * accessible.
+ */
+static long bench_syscall_tracepoint(void) {
+  static const char* paths[] = {
+    "/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+    "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"
+  };
+  unsigned int i;
+  FILE* fp;
+  long id;
+
+  for (i = 0; i < ARRAY_SIZE(paths); i++) {
+    fp = fopen(paths[i], "r");
+    if (fp == NULL)
+      continue;
+    if (fscanf(fp, "%ld", &id) != 1)
+      id = -1;
+    fclose(fp);
+    return id;
+  }
+
+  return -1;
+}
+
+
+void bench_perf_start(void) {
+  struct perf_event_attr attr;
+  unsigned int i;
+  long id;
+
+  if (getenv("UV_BENCHMARK_PERF") == NULL)
+    return;
+
+  for (i = 0; i < ARRAY_SIZE(bench_counters); i++) {
+    if (bench_counters[i].type == PERF_TYPE_TRACEPOINT) {
+      id = bench_syscall_tracepoint();
+      if (id < 0)
+        continue;
+      bench_counters[i].config = id;
+    }
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = bench_counters[i].type;
+    attr.config = bench_counters[i].config;
+    attr.inherit = 1;  /* Count the benchmark's threads too. */
+    attr.exclude_hv = 1;
+    if (attr.type == PERF_TYPE_HARDWARE)
+      attr.exclude_kernel = 1;  /* Allowed with perf_event_paranoid=2. */
+
+    /* Counters that the kernel or the hardware don't support are skipped. */
+    bench_counters[i].fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+}
+
+
+void bench_perf_stop(void) {
+  unsigned int i;
+  uint64_t value;
+
+  for (i = 0; i < ARRAY_SIZE(bench_counters); i++) {
+    if (bench_counters[i].fd == -1)
+      continue;
+
+    if (read(bench_counters[i].fd, &value, sizeof(value)) == sizeof(value))
+      benchmark_report(bench_counters[i].name, (double) value, "count");
+
+    close(bench_counters[i].fd);
+    bench_counters[i].fd = -1;
+  }
+}
+#else
+void bench_perf_start(void) {
+}
+
+
+void bench_perf_stop(void) {
+}
+#endif
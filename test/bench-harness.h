@@ -0,0 +1,64 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef BENCH_HARNESS_H_
+#define BENCH_HARNESS_H_
+
+#include <stdint.h>
+
+/*
+ * Repeated benchmark runs with statistics, used by `./run-benchmarks --repeat`
+ * and friends.  Benchmarks publish their numbers with benchmark_report().
+ */
+int bench_harness_main(int argc, char** argv);
+
+/*
+ * Compare two result files written with --format=json.  Returns the number of
+ * significant regressions, or -1 on error.
+ */
+int bench_compare_main(int argc, char** argv);
+
+/*
+ * Hardware and software counters for the benchmark process, enabled by the
+ * harness with --perf.  No-ops where perf_event_open() is not available.
+ */
+void bench_perf_start(void);
+void bench_perf_stop(void);
+
+/*
+ * HDR-style latency histogram: values below 2^BENCH_HISTOGRAM_BITS are
+ * recorded exactly, larger values with a relative error below 1.6%.
+ */
+#define BENCH_HISTOGRAM_BITS 7
+#define BENCH_HISTOGRAM_BUCKETS                                               \
+  ((64 - BENCH_HISTOGRAM_BITS + 2) << (BENCH_HISTOGRAM_BITS - 1))
+
+typedef struct {
+  uint64_t counts[BENCH_HISTOGRAM_BUCKETS];
+  uint64_t total;
+  uint64_t max;
+} bench_histogram_t;
+
+void bench_histogram_reset(bench_histogram_t* h);
+void bench_histogram_record(bench_histogram_t* h, uint64_t value);
+uint64_t bench_histogram_percentile(const bench_histogram_t* h, double p);
+
+#endif  /* BENCH_HARNESS_H_ */
@@ -91,6 +91,7 @@ static int test_async_pummel(int nthreads) {
          fmt(callbacks),
          time / 1e9,
          fmt(callbacks / (time / 1e9)));
+  benchmark_report("callbacks", callbacks / (time / 1e9), "callbacks/s");
 
   free(tids);
 
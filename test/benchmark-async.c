@@ -113,6 +113,7 @@ static int test_async(int nthreads) {
          nthreads,
          time / 1e9,
          fmt(NUM_PINGS / (time / 1e9)));
+  benchmark_report("pings", NUM_PINGS / (time / 1e9), "pings/s");
 
   free(threads);
 
@@ -0,0 +1,330 @@
+/* Copyright libuv project contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* The same workloads written against the C API and against uv/coro.hpp. */
+
+#include "uv/coro.hpp"
+
+extern "C" {
+#include "task.h"
+}
+
+#include <stdio.h>
+#include <string.h>
+
+#define NUM_TIMERS     (1000 * 1000)
+#define NUM_STATS      (20 * 1000)
+#define NUM_PINGS      (20 * 1000)
+
+
+static void report(const char* what,
+                   const char* unit,
+                   unsigned int count,
+                   uint64_t raw,
+                   uint64_t coro) {
+  double raw_rate;
+  double coro_rate;
+
+  raw_rate = count / (raw / 1e9);
+  coro_rate = count / (coro / 1e9);
+  printf("%s: raw %s/s, coro %s/s (%+.1f%%)\n",
+         what,
+         fmt(raw_rate),
+         fmt(coro_rate),
+         (coro_rate / raw_rate - 1) * 100);
+  fflush(stdout);
+  benchmark_report("raw", raw_rate, unit);
+  benchmark_report("coro", coro_rate, unit);
+}
+
+
+static unsigned int raw_count;
+
+
+static void raw_timer_cb(uv_timer_t* handle) {
+  if (++raw_count < NUM_TIMERS)
+    ASSERT(0 == uv_timer_start(handle, raw_timer_cb, 0, 0));
+}
+
+
+static uv::task<> coro_timers(uv_loop_t* loop) {
+  uv::timer timer;
+  unsigned int i;
+
+  ASSERT(0 == timer.init(loop));
+  for (i = 0; i < NUM_TIMERS; i++)
+    ASSERT(0 == co_await timer.sleep(0));
+}
+
+
+extern "C" BENCHMARK_IMPL(coro_timers) {
+  uv_timer_t timer;
+  uv_loop_t* loop;
+  uint64_t raw;
+  uint64_t coro;
+
+  loop = uv_default_loop();
+  raw_count = 0;
+  raw = uv_hrtime();
+  ASSERT(0 == uv_timer_init(loop, &timer));
+  ASSERT(0 == uv_timer_start(&timer, raw_timer_cb, 0, 0));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  raw = uv_hrtime() - raw;
+  ASSERT(raw_count == NUM_TIMERS);
+  uv_close((uv_handle_t*) &timer, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  coro = uv_hrtime();
+  {
+    uv::task<> t = coro_timers(loop);
+    t.start();
+    ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+    ASSERT(t.done());
+  }
+  coro = uv_hrtime() - coro;
+
+  report("timers", "timers/s", NUM_TIMERS, raw, coro);
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void raw_stat_cb(uv_fs_t* req) {
+  ASSERT(req->result == 0);
+  uv_fs_req_cleanup(req);
+  if (++raw_count < NUM_STATS)
+    ASSERT(0 == uv_fs_stat(req->loop, req, ".", raw_stat_cb));
+}
+
+
+static uv::task<> coro_stats(uv_loop_t* loop) {
+  unsigned int i;
+
+  for (i = 0; i < NUM_STATS; i++)
+    ASSERT(0 == (co_await uv::fs_stat(loop, ".")).status);
+}
+
+
+extern "C" BENCHMARK_IMPL(coro_fs_stat) {
+  uv_loop_t* loop;
+  uv_fs_t req;
+  uint64_t raw;
+  uint64_t coro;
+
+  loop = uv_default_loop();
+  raw_count = 0;
+  raw = uv_hrtime();
+  ASSERT(0 == uv_fs_stat(loop, &req, ".", raw_stat_cb));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  raw = uv_hrtime() - raw;
+  ASSERT(raw_count == NUM_STATS);
+
+  coro = uv_hrtime();
+  {
+    uv::task<> t = coro_stats(loop);
+    t.start();
+    ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+    ASSERT(t.done());
+  }
+  coro = uv_hrtime() - coro;
+
+  report("fs_stat", "stats/s", NUM_STATS, raw, coro);
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+/* Ping-pong over loopback TCP: the client sends four bytes and waits for
+ * the server to echo them before sending the next ping.
+ */
+typedef struct {
+  uv_tcp_t tcp;
+  uv_write_t write_req;
+  char buf[64];
+  unsigned int received;
+} raw_conn;
+
+static uv_tcp_t raw_server;
+static raw_conn raw_client;
+static raw_conn raw_peer;
+
+
+static void raw_alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  raw_conn* conn;
+
+  conn = container_of(handle, raw_conn, tcp);
+  *buf = uv_buf_init(conn->buf, sizeof(conn->buf));
+}
+
+
+static void raw_write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+}
+
+
+static void raw_ping(raw_conn* conn) {
+  uv_buf_t buf;
+
+  buf = uv_buf_init((char*) "PING", 4);
+  ASSERT(0 == uv_write(&conn->write_req,
+                       (uv_stream_t*) &conn->tcp,
+                       &buf,
+                       1,
+                       raw_write_cb));
+}
+
+
+static void raw_echo_cb(uv_stream_t* stream,
+                        ssize_t nread,
+                        const uv_buf_t* buf) {
+  raw_conn* conn;
+  uv_buf_t out;
+
+  conn = container_of(stream, raw_conn, tcp);
+  if (nread < 0) {
+    uv_close((uv_handle_t*) stream, NULL);
+    uv_close((uv_handle_t*) &raw_server, NULL);
+    return;
+  }
+
+  if (nread == 0)
+    return;
+
+  out = uv_buf_init(buf->base, nread);
+  ASSERT(0 == uv_write(&conn->write_req, stream, &out, 1, raw_write_cb));
+}
+
+
+static void raw_pong_cb(uv_stream_t* stream,
+                        ssize_t nread,
+                        const uv_buf_t* buf) {
+  raw_conn* conn;
+
+  ASSERT(nread >= 0);
+  conn = container_of(stream, raw_conn, tcp);
+  conn->received += nread;
+  if (conn->received % 4 != 0)
+    return;
+
+  if (++raw_count < NUM_PINGS)
+    raw_ping(conn);
+  else
+    uv_close((uv_handle_t*) stream, NULL);
+}
+
+
+static void raw_connection_cb(uv_stream_t* server, int status) {
+  ASSERT(status == 0);
+  ASSERT(0 == uv_tcp_init(server->loop, &raw_peer.tcp));
+  ASSERT(0 == uv_accept(server, (uv_stream_t*) &raw_peer.tcp));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &raw_peer.tcp,
+                            raw_alloc_cb,
+                            raw_echo_cb));
+}
+
+
+static void raw_connect_cb(uv_connect_t* req, int status) {
+  ASSERT(status == 0);
+  ASSERT(0 == uv_read_start(req->handle, raw_alloc_cb, raw_pong_cb));
+  raw_ping(&raw_client);
+}
+
+
+static uv::task<> coro_echo(uv::tcp& server) {
+  uv::tcp conn;
+  char buf[64];
+  ssize_t nread;
+
+  ASSERT(0 == conn.init(server.loop()));
+  ASSERT(0 == co_await server.accept(conn));
+
+  while ((nread = co_await conn.read(uv_buf_init(buf, sizeof(buf)))) > 0)
+    ASSERT(0 == co_await conn.write(uv_buf_init(buf, nread)));
+
+  server.close();
+}
+
+
+static uv::task<> coro_pings(uv_loop_t* loop, const struct sockaddr* addr) {
+  uv::tcp client;
+  unsigned int received;
+  unsigned int i;
+  char buf[64];
+  ssize_t nread;
+
+  ASSERT(0 == client.init(loop));
+  ASSERT(0 == co_await client.connect(addr));
+
+  for (i = 0; i < NUM_PINGS; i++) {
+    ASSERT(0 == co_await client.write(uv_buf_init((char*) "PING", 4)));
+    for (received = 0; received < 4; received += nread) {
+      nread = co_await client.read(uv_buf_init(buf, sizeof(buf)));
+      ASSERT(nread > 0);
+    }
+  }
+}
+
+
+extern "C" BENCHMARK_IMPL(coro_pingpong) {
+  struct sockaddr_in addr;
+  uv_connect_t connect_req;
+  uv_loop_t* loop;
+  uint64_t raw;
+  uint64_t coro;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+
+  raw_count = 0;
+  raw = uv_hrtime();
+  ASSERT(0 == uv_tcp_init(loop, &raw_server));
+  ASSERT(0 == uv_tcp_bind(&raw_server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &raw_server, 1, raw_connection_cb));
+  ASSERT(0 == uv_tcp_init(loop, &raw_client.tcp));
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &raw_client.tcp,
+                             (const struct sockaddr*) &addr,
+                             raw_connect_cb));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  raw = uv_hrtime() - raw;
+  ASSERT(raw_count == NUM_PINGS);
+
+  coro = uv_hrtime();
+  {
+    uv::tcp server;
+    ASSERT(0 == server.init(loop));
+    ASSERT(0 == server.bind((const struct sockaddr*) &addr));
+    ASSERT(0 == server.listen(1));
+
+    uv::task<> echo = coro_echo(server);
+    uv::task<> pings = coro_pings(loop, (const struct sockaddr*) &addr);
+    echo.start();
+    pings.start();
+    ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+    ASSERT(echo.done());
+    ASSERT(pings.done());
+  }
+  coro = uv_hrtime() - coro;
+
+  report("pingpong", "pings/s", NUM_PINGS, raw, coro);
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
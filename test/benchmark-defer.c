@@ -0,0 +1,118 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "task.h"
+#include "uv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_CALLBACKS (1000 * 1000)
+#define NUM_CHAINS 100
+
+/* Compares uv_defer() with the uv_idle_t idiom for "run this on the next
+ * tick": NUM_CHAINS callbacks that each queue the next one until
+ * NUM_CALLBACKS have run.
+ */
+
+static unsigned int scheduled;
+static unsigned int called;
+
+
+static void defer_cb(uv_loop_t* loop, void* arg) {
+  called++;
+  if (scheduled < NUM_CALLBACKS) {
+    scheduled++;
+    ASSERT(0 == uv_defer(loop, UV_DEFER_NEXT_ITERATION, defer_cb, NULL));
+  }
+}
+
+
+static void idle_close_cb(uv_handle_t* handle) {
+  free(handle);
+}
+
+
+static void idle_schedule(uv_loop_t* loop);
+
+
+static void idle_cb(uv_idle_t* handle) {
+  called++;
+  uv_close((uv_handle_t*) handle, idle_close_cb);
+  if (scheduled < NUM_CALLBACKS) {
+    scheduled++;
+    idle_schedule(handle->loop);
+  }
+}
+
+
+static void idle_schedule(uv_loop_t* loop) {
+  uv_idle_t* handle;
+
+  handle = malloc(sizeof(*handle));
+  ASSERT(handle != NULL);
+  ASSERT(0 == uv_idle_init(loop, handle));
+  ASSERT(0 == uv_idle_start(handle, idle_cb));
+}
+
+
+static int defer_bench(const char* name, int use_idle) {
+  uv_loop_t* loop = uv_default_loop();
+  uint64_t ns;
+  int i;
+
+  ns = uv_hrtime();
+
+  for (i = 0; i < NUM_CHAINS; i++) {
+    scheduled++;
+    if (use_idle)
+      idle_schedule(loop);
+    else
+      ASSERT(0 == uv_defer(loop, UV_DEFER_NEXT_ITERATION, defer_cb, NULL));
+  }
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ns = uv_hrtime() - ns;
+
+  ASSERT(called == NUM_CALLBACKS);
+
+  fprintf(stderr, "%s: %d callbacks in %.2fs (%.0f/s)\n",
+          name,
+          NUM_CALLBACKS,
+          ns / 1e9,
+          NUM_CALLBACKS / (ns / 1e9));
+  fflush(stderr);
+  benchmark_report("callbacks", NUM_CALLBACKS / (ns / 1e9), "callbacks/s");
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(defer_next_tick) {
+  return defer_bench("defer_next_tick", 0);
+}
+
+
+BENCHMARK_IMPL(defer_idle_handle) {
+  return defer_bench("defer_idle_handle", 1);
+}
@@ -78,6 +78,9 @@ static void sync_bench(const char* path) {
          (after - before) / 1e9,
          fmt((1.0 * NUM_SYNC_REQS) / ((after - before) / 1e9)));
   fflush(stdout);
+  benchmark_report("sync",
+                   (1.0 * NUM_SYNC_REQS) / ((after - before) / 1e9),
+                   "stats/s");
 }
 
 
@@ -95,6 +98,7 @@ static void async_bench(const char* path) {
   struct async_req* req;
   uint64_t before;
   uint64_t after;
+  char metric[32];
   int count;
   int i;
 
@@ -117,6 +121,10 @@ static void async_bench(const char* path) {
            (after - before) / 1e9,
            fmt((1.0 * NUM_ASYNC_REQS) / ((after - before) / 1e9)));
     fflush(stdout);
+    snprintf(metric, sizeof(metric), "async%d", i);
+    benchmark_report(metric,
+                     (1.0 * NUM_ASYNC_REQS) / ((after - before) / 1e9),
+                     "stats/s");
   }
 }
 
@@ -0,0 +1,679 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "task.h"
+#include "uv.h"
+#include "bench-harness.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+# include <arpa/inet.h>
+# include <netinet/in.h>
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
+/* Everything happens in a fresh directory under uv_os_tmpdir(), usually /tmp.
+ * Reads are served from the page cache after the first pass, so what's being
+ * measured is the cost of the threadpool and fs.c rather than the disk.
+ */
+#define FILE_SIZE (64 * 1024 * 1024)
+#define MIN_OPS 256
+#define MAX_DEPTH 32
+#define NUM_SMALL_FILES 10000
+#define SMALL_FILE_SIZE 4096
+#define NUM_DIRENTS 100000
+#define NUM_SCANS 5
+#define NUM_SYNCS 1000
+#define SENDFILE_CHUNK (1024 * 1024)
+#define SENDFILE_BYTES (4 * (uint64_t) FILE_SIZE)
+
+static const size_t block_sizes[] = { 4096, 64 * 1024, 1024 * 1024 };
+static const int depths[] = { 1, 8, 32 };
+
+struct io_slot {
+  uv_fs_t req;
+  uint64_t start;
+  uv_os_fd_t fd;
+  char* buf;
+};
+
+static uv_loop_t* loop;
+static char tmpdir[512];
+static bench_histogram_t histogram;
+static struct io_slot slots[MAX_DEPTH];
+static uv_os_fd_t io_fd;
+static size_t io_size;
+static int io_write;
+static int io_random;
+static int io_started;
+static int io_ops;
+
+
+static unsigned fastrand(void) {
+  static unsigned g = 0;
+  g = g * 214013 + 2531011;
+  return g >> 8;
+}
+
+
+static void make_tmpdir(void) {
+  uv_fs_t req;
+  size_t len;
+
+  len = sizeof(tmpdir);
+  ASSERT(0 == uv_os_tmpdir(tmpdir, &len));
+  ASSERT(len + sizeof("/uv-bench-XXXXXX") <= sizeof(tmpdir));
+  strcat(tmpdir, "/uv-bench-XXXXXX");
+
+  ASSERT(0 == uv_fs_mkdtemp(NULL, &req, tmpdir, NULL));
+  strcpy(tmpdir, req.path);
+  uv_fs_req_cleanup(&req);
+}
+
+
+static void remove_tmpdir(void) {
+  uv_fs_t req;
+
+  ASSERT(0 == uv_fs_rmdir(NULL, &req, tmpdir, NULL));
+  uv_fs_req_cleanup(&req);
+}
+
+
+static void tmp_path(char* buf, size_t size, const char* name, int n) {
+  snprintf(buf, size, "%s/%s%d", tmpdir, name, n);
+}
+
+
+static void unlink_path(const char* path) {
+  uv_fs_t req;
+
+  ASSERT(0 == uv_fs_unlink(NULL, &req, path, NULL));
+  uv_fs_req_cleanup(&req);
+}
+
+
+static uv_os_fd_t open_file(const char* path, int flags) {
+  uv_fs_t req;
+  uv_os_fd_t fd;
+
+  ASSERT(0 <= uv_fs_open(NULL, &req, path, flags, S_IRUSR | S_IWUSR, NULL));
+  fd = (uv_os_fd_t) req.result;
+  uv_fs_req_cleanup(&req);
+
+  return fd;
+}
+
+
+static void close_file(uv_os_fd_t fd) {
+  uv_fs_t req;
+
+  ASSERT(0 == uv_fs_close(NULL, &req, fd, NULL));
+  uv_fs_req_cleanup(&req);
+}
+
+
+/* Creates a FILE_SIZE file with data in it and returns an open descriptor. */
+static uv_os_fd_t create_data_file(const char* path) {
+  uv_buf_t buf;
+  uv_fs_t req;
+  uv_os_fd_t fd;
+  int64_t off;
+
+  buf = uv_buf_init(malloc(1024 * 1024), 1024 * 1024);
+  ASSERT(buf.base != NULL);
+  memset(buf.base, 'x', buf.len);
+
+  fd = open_file(path, O_RDWR | O_CREAT | O_TRUNC);
+  for (off = 0; off < FILE_SIZE; off += buf.len) {
+    ASSERT((ssize_t) buf.len == uv_fs_write(NULL, &req, fd, &buf, 1, off, NULL));
+    uv_fs_req_cleanup(&req);
+  }
+
+  ASSERT(0 == uv_fs_fsync(NULL, &req, fd, NULL));
+  uv_fs_req_cleanup(&req);
+  free(buf.base);
+
+  return fd;
+}
+
+
+static void report_latency(const char* name,
+                           const char* metric,
+                           double ops,
+                           double mbs) {
+  char buf[64];
+  double p50;
+  double p99;
+
+  p50 = bench_histogram_percentile(&histogram, 50) / 1e3;
+  p99 = bench_histogram_percentile(&histogram, 99) / 1e3;
+
+  if (mbs > 0)
+    fprintf(stderr,
+            "%s %s: %s ops/s, %.1f MB/s, p50 %.1fus, p99 %.1fus\n",
+            name,
+            metric,
+            fmt(ops),
+            mbs,
+            p50,
+            p99);
+  else
+    fprintf(stderr,
+            "%s %s: %s ops/s, p50 %.1fus, p99 %.1fus\n",
+            name,
+            metric,
+            fmt(ops),
+            p50,
+            p99);
+  fflush(stderr);
+
+  if (mbs > 0)
+    benchmark_report(metric, mbs, "MB/s");
+  else
+    benchmark_report(metric, ops, "ops/s");
+
+  snprintf(buf, sizeof(buf), "%s_p99", metric);
+  benchmark_report(buf, p99, "us");
+}
+
+
+static void io_submit(struct io_slot* slot);
+
+
+static void io_cb(uv_fs_t* req) {
+  struct io_slot* slot;
+
+  slot = container_of(req, struct io_slot, req);
+  ASSERT(req->result == (ssize_t) io_size);
+  bench_histogram_record(&histogram, uv_hrtime() - slot->start);
+  uv_fs_req_cleanup(req);
+
+  if (io_started < io_ops)
+    io_submit(slot);
+}
+
+
+static void io_submit(struct io_slot* slot) {
+  uv_buf_t buf;
+  int64_t block;
+  int64_t nblocks;
+
+  nblocks = FILE_SIZE / io_size;
+  if (io_random)
+    block = fastrand() % nblocks;
+  else
+    block = io_started % nblocks;
+
+  io_started++;
+  buf = uv_buf_init(slot->buf, io_size);
+  slot->start = uv_hrtime();
+
+  if (io_write)
+    ASSERT(0 == uv_fs_write(loop,
+                            &slot->req,
+                            io_fd,
+                            &buf,
+                            1,
+                            block * io_size,
+                            io_cb));
+  else
+    ASSERT(0 == uv_fs_read(loop,
+                           &slot->req,
+                           io_fd,
+                           &buf,
+                           1,
+                           block * io_size,
+                           io_cb));
+}
+
+
+static int io_bench(const char* name, int write, int random) {
+  char metric[32];
+  char path[1024];
+  uint64_t ns;
+  double ops;
+  unsigned int i;
+  unsigned int k;
+  int d;
+
+  loop = uv_default_loop();
+  make_tmpdir();
+  tmp_path(path, sizeof(path), "data", 0);
+  io_fd = create_data_file(path);
+  io_write = write;
+  io_random = random;
+
+  for (d = 0; d < MAX_DEPTH; d++) {
+    slots[d].buf = malloc(block_sizes[ARRAY_SIZE(block_sizes) - 1]);
+    ASSERT(slots[d].buf != NULL);
+    memset(slots[d].buf, 'y', block_sizes[ARRAY_SIZE(block_sizes) - 1]);
+  }
+
+  for (i = 0; i < ARRAY_SIZE(block_sizes); i++) {
+    for (k = 0; k < ARRAY_SIZE(depths); k++) {
+      io_size = block_sizes[i];
+      io_ops = FILE_SIZE / io_size;
+      if (io_ops < MIN_OPS)
+        io_ops = MIN_OPS;
+      io_started = 0;
+      bench_histogram_reset(&histogram);
+
+      ns = uv_hrtime();
+      for (d = 0; d < depths[k]; d++)
+        io_submit(slots + d);
+      ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+      ns = uv_hrtime() - ns;
+
+      ops = io_ops / (ns / 1e9);
+      snprintf(metric,
+               sizeof(metric),
+               "%dk_qd%d",
+               (int) (io_size / 1024),
+               depths[k]);
+      report_latency(name, metric, ops, ops * io_size / (1024 * 1024));
+    }
+  }
+
+  for (d = 0; d < MAX_DEPTH; d++)
+    free(slots[d].buf);
+
+  close_file(io_fd);
+  unlink_path(path);
+  remove_tmpdir();
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(fs_seq_read) {
+  return io_bench("fs_seq_read", 0, 0);
+}
+
+
+BENCHMARK_IMPL(fs_seq_write) {
+  return io_bench("fs_seq_write", 1, 0);
+}
+
+
+BENCHMARK_IMPL(fs_rand_read) {
+  return io_bench("fs_rand_read", 0, 1);
+}
+
+
+BENCHMARK_IMPL(fs_rand_write) {
+  return io_bench("fs_rand_write", 1, 1);
+}
+
+
+/* Small files: open(O_CREAT), write, close, MAX_DEPTH files at a time. */
+static int files_started;
+
+
+static void create_next(struct io_slot* slot);
+
+
+static void create_close_cb(uv_fs_t* req) {
+  struct io_slot* slot;
+
+  slot = container_of(req, struct io_slot, req);
+  ASSERT(req->result == 0);
+  uv_fs_req_cleanup(req);
+  bench_histogram_record(&histogram, uv_hrtime() - slot->start);
+
+  if (files_started < NUM_SMALL_FILES)
+    create_next(slot);
+}
+
+
+static void create_write_cb(uv_fs_t* req) {
+  struct io_slot* slot;
+
+  ASSERT(req->result == SMALL_FILE_SIZE);
+  uv_fs_req_cleanup(req);
+  slot = container_of(req, struct io_slot, req);
+  ASSERT(0 == uv_fs_close(loop, req, slot->fd, create_close_cb));
+}
+
+
+static void create_open_cb(uv_fs_t* req) {
+  struct io_slot* slot;
+  uv_buf_t buf;
+
+  slot = container_of(req, struct io_slot, req);
+  ASSERT(req->result >= 0);
+  slot->fd = (uv_os_fd_t) req->result;
+  uv_fs_req_cleanup(req);
+
+  buf = uv_buf_init(slot->buf, SMALL_FILE_SIZE);
+  ASSERT(0 == uv_fs_write(loop, req, slot->fd, &buf, 1, 0, create_write_cb));
+}
+
+
+static void create_next(struct io_slot* slot) {
+  char path[1024];
+
+  tmp_path(path, sizeof(path), "small", files_started++);
+  slot->start = uv_hrtime();
+  ASSERT(0 == uv_fs_open(loop,
+                         &slot->req,
+                         path,
+                         O_WRONLY | O_CREAT | O_TRUNC,
+                         S_IRUSR | S_IWUSR,
+                         create_open_cb));
+}
+
+
+BENCHMARK_IMPL(fs_create_storm) {
+  char path[1024];
+  uint64_t ns;
+  int i;
+
+  loop = uv_default_loop();
+  make_tmpdir();
+  bench_histogram_reset(&histogram);
+  files_started = 0;
+
+  for (i = 0; i < MAX_DEPTH; i++) {
+    slots[i].buf = calloc(1, SMALL_FILE_SIZE);
+    ASSERT(slots[i].buf != NULL);
+  }
+
+  ns = uv_hrtime();
+  for (i = 0; i < MAX_DEPTH; i++)
+    create_next(slots + i);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ns = uv_hrtime() - ns;
+
+  report_latency("fs_create_storm", "files", NUM_SMALL_FILES / (ns / 1e9), 0);
+
+  for (i = 0; i < MAX_DEPTH; i++)
+    free(slots[i].buf);
+
+  for (i = 0; i < NUM_SMALL_FILES; i++) {
+    tmp_path(path, sizeof(path), "small", i);
+    unlink_path(path);
+  }
+
+  remove_tmpdir();
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static int scan_entries;
+
+
+static void scandir_cb(uv_fs_t* req) {
+  uv_dirent_t dent;
+  struct io_slot* slot;
+
+  slot = container_of(req, struct io_slot, req);
+  ASSERT(req->result == NUM_DIRENTS);
+
+  while (UV_EOF != uv_fs_scandir_next(req, &dent))
+    scan_entries++;
+
+  uv_fs_req_cleanup(req);
+  bench_histogram_record(&histogram, uv_hrtime() - slot->start);
+}
+
+
+BENCHMARK_IMPL(fs_scandir) {
+  char path[1024];
+  uint64_t ns;
+  int i;
+
+  loop = uv_default_loop();
+  make_tmpdir();
+  bench_histogram_reset(&histogram);
+  scan_entries = 0;
+
+  for (i = 0; i < NUM_DIRENTS; i++) {
+    tmp_path(path, sizeof(path), "entry", i);
+    close_file(open_file(path, O_WRONLY | O_CREAT));
+  }
+
+  ns = uv_hrtime();
+  for (i = 0; i < NUM_SCANS; i++) {
+    slots[0].start = uv_hrtime();
+    ASSERT(0 == uv_fs_scandir(loop, &slots[0].req, tmpdir, 0, scandir_cb));
+    ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  }
+  ns = uv_hrtime() - ns;
+
+  ASSERT(scan_entries == NUM_SCANS * NUM_DIRENTS);
+  fprintf(stderr,
+          "fs_scandir: %s entries, %s entries/s\n",
+          fmt(NUM_DIRENTS),
+          fmt(scan_entries / (ns / 1e9)));
+  benchmark_report("entries", scan_entries / (ns / 1e9), "entries/s");
+  report_latency("fs_scandir", "scan", NUM_SCANS / (ns / 1e9), 0);
+
+  for (i = 0; i < NUM_DIRENTS; i++) {
+    tmp_path(path, sizeof(path), "entry", i);
+    unlink_path(path);
+  }
+
+  remove_tmpdir();
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+/* A 4 KB write followed by fsync() or fdatasync(), one at a time. */
+static int syncs_done;
+static int sync_data;
+
+
+static void sync_write(struct io_slot* slot);
+
+
+static void sync_cb(uv_fs_t* req) {
+  struct io_slot* slot;
+
+  slot = container_of(req, struct io_slot, req);
+  ASSERT(req->result == 0);
+  uv_fs_req_cleanup(req);
+  bench_histogram_record(&histogram, uv_hrtime() - slot->start);
+
+  if (++syncs_done < NUM_SYNCS)
+    sync_write(slot);
+}
+
+
+static void sync_write_cb(uv_fs_t* req) {
+  ASSERT(req->result == SMALL_FILE_SIZE);
+  uv_fs_req_cleanup(req);
+  slots[0].start = uv_hrtime();
+
+  if (sync_data)
+    ASSERT(0 == uv_fs_fdatasync(loop, req, io_fd, sync_cb));
+  else
+    ASSERT(0 == uv_fs_fsync(loop, req, io_fd, sync_cb));
+}
+
+
+static void sync_write(struct io_slot* slot) {
+  uv_buf_t buf;
+
+  buf = uv_buf_init(slot->buf, SMALL_FILE_SIZE);
+  ASSERT(0 == uv_fs_write(loop,
+                          &slot->req,
+                          io_fd,
+                          &buf,
+                          1,
+                          (syncs_done % 256) * SMALL_FILE_SIZE,
+                          sync_write_cb));
+}
+
+
+BENCHMARK_IMPL(fs_fsync) {
+  static const char* const names[] = { "fsync", "fdatasync" };
+  char path[1024];
+  uint64_t ns;
+
+  loop = uv_default_loop();
+  make_tmpdir();
+  tmp_path(path, sizeof(path), "sync", 0);
+  io_fd = open_file(path, O_RDWR | O_CREAT | O_TRUNC);
+  slots[0].buf = calloc(1, SMALL_FILE_SIZE);
+  ASSERT(slots[0].buf != NULL);
+
+  for (sync_data = 0; sync_data < 2; sync_data++) {
+    bench_histogram_reset(&histogram);
+    syncs_done = 0;
+
+    ns = uv_hrtime();
+    sync_write(slots + 0);
+    ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+    ns = uv_hrtime() - ns;
+
+    report_latency("fs_fsync", names[sync_data], NUM_SYNCS / (ns / 1e9), 0);
+  }
+
+  free(slots[0].buf);
+  close_file(io_fd);
+  unlink_path(path);
+  remove_tmpdir();
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+#ifndef _WIN32
+static uint64_t sendfile_sent;
+static uint64_t sendfile_received;
+static int sendfile_socket;
+
+
+static void sendfile_next(uv_fs_t* req);
+
+
+static void sendfile_cb(uv_fs_t* req) {
+  struct io_slot* slot;
+
+  slot = container_of(req, struct io_slot, req);
+  ASSERT(req->result > 0);
+  sendfile_sent += req->result;
+  uv_fs_req_cleanup(req);
+  bench_histogram_record(&histogram, uv_hrtime() - slot->start);
+
+  if (sendfile_sent < SENDFILE_BYTES)
+    sendfile_next(req);
+}
+
+
+static void sendfile_next(uv_fs_t* req) {
+  slots[0].start = uv_hrtime();
+  ASSERT(0 == uv_fs_sendfile(loop,
+                             req,
+                             sendfile_socket,
+                             io_fd,
+                             sendfile_sent % FILE_SIZE,
+                             SENDFILE_CHUNK,
+                             sendfile_cb));
+}
+
+
+static void sink_thread_cb(void* arg) {
+  char buf[65536];
+  ssize_t n;
+  int fd;
+
+  fd = accept(*(int*) arg, NULL, NULL);
+  ASSERT(fd >= 0);
+
+  while ((n = read(fd, buf, sizeof(buf))) > 0)
+    sendfile_received += n;
+
+  ASSERT(n == 0);
+  ASSERT(0 == close(fd));
+}
+#endif
+
+
+/* sendfile() from a file to a blocking TCP socket whose other end discards
+ * everything on a thread.
+ */
+BENCHMARK_IMPL(fs_sendfile) {
+#ifdef _WIN32
+  RETURN_SKIP("Not supported on Windows.");
+#else
+  struct sockaddr_in addr;
+  uv_thread_t sink_thread;
+  char path[1024];
+  uint64_t ns;
+  double ops;
+  int listener;
+
+  loop = uv_default_loop();
+  make_tmpdir();
+  tmp_path(path, sizeof(path), "data", 0);
+  io_fd = create_data_file(path);
+  bench_histogram_reset(&histogram);
+  sendfile_sent = 0;
+  sendfile_received = 0;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  listener = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT(listener >= 0);
+  ASSERT(0 == bind(listener, (struct sockaddr*) &addr, sizeof(addr)));
+  ASSERT(0 == listen(listener, 1));
+  ASSERT(0 == uv_thread_create(&sink_thread, sink_thread_cb, &listener));
+
+  sendfile_socket = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT(sendfile_socket >= 0);
+  ASSERT(0 == connect(sendfile_socket, (struct sockaddr*) &addr, sizeof(addr)));
+
+  ns = uv_hrtime();
+  sendfile_next(&slots[0].req);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ns = uv_hrtime() - ns;
+
+  ASSERT(0 == close(sendfile_socket));
+  ASSERT(0 == uv_thread_join(&sink_thread));
+  ASSERT(0 == close(listener));
+  ASSERT(sendfile_received == sendfile_sent);
+
+  ops = histogram.total / (ns / 1e9);
+  report_latency("fs_sendfile",
+                 "sendfile",
+                 ops,
+                 sendfile_sent / (ns / 1e9) / (1024 * 1024));
+
+  close_file(io_fd);
+  unlink_path(path);
+  remove_tmpdir();
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
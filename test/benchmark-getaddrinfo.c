@@ -86,6 +86,9 @@ BENCHMARK_IMPL(getaddrinfo) {
   fprintf(stderr, "getaddrinfo: %.0f req/s\n",
           (double) calls_completed / (double) (end_time - start_time) * 1000.0);
   fflush(stderr);
+  benchmark_report("requests",
+                   calls_completed / ((end_time - start_time) / 1000.0),
+                   "req/s");
 
   MAKE_VALGRIND_HAPPY();
   return 0;
@@ -0,0 +1,589 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+#include "bench-harness.h"
+
+#include <stdio.h>
+
+#define NUM_ROUNDTRIPS 20000
+#define NUM_TIMER_FIRES 1000
+#define MESSAGE_SIZE 64
+
+/* Synchronous work per loop iteration on a loaded loop, in nanoseconds. */
+#define LOAD_NS 50000
+
+static bench_histogram_t histogram;
+static uv_prepare_t load_handle;
+static uint64_t sent_at;
+
+
+static void histogram_report(const char* name) {
+  double p50;
+  double p99;
+  double p999;
+  double max;
+
+  p50 = bench_histogram_percentile(&histogram, 50) / 1e3;
+  p99 = bench_histogram_percentile(&histogram, 99) / 1e3;
+  p999 = bench_histogram_percentile(&histogram, 99.9) / 1e3;
+  max = histogram.max / 1e3;
+
+  fprintf(stderr,
+          "%s: %s samples, p50 %.1fus, p99 %.1fus, p999 %.1fus, max %.1fus\n",
+          name,
+          fmt((double) histogram.total),
+          p50,
+          p99,
+          p999,
+          max);
+  fflush(stderr);
+
+  benchmark_report("p50", p50, "us");
+  benchmark_report("p99", p99, "us");
+  benchmark_report("p999", p999, "us");
+  benchmark_report("max", max, "us");
+}
+
+
+static void load_cb(uv_prepare_t* handle) {
+  uint64_t deadline;
+
+  deadline = uv_hrtime() + LOAD_NS;
+  while (uv_hrtime() < deadline);
+}
+
+
+/* A loaded loop does LOAD_NS of work every iteration before it polls. */
+static void setup(uv_loop_t* loop, int loaded) {
+  bench_histogram_reset(&histogram);
+
+  if (loaded) {
+    ASSERT(0 == uv_prepare_init(loop, &load_handle));
+    ASSERT(0 == uv_prepare_start(&load_handle, load_cb));
+    uv_unref((uv_handle_t*) &load_handle);
+  }
+}
+
+
+static void teardown(uv_loop_t* loop, int loaded) {
+  if (loaded)
+    uv_close((uv_handle_t*) &load_handle, NULL);
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+}
+
+
+/*
+ * Echo server on a thread and loop of its own, so that only the client side
+ * shares the (possibly loaded) loop that is measured.
+ */
+static uv_loop_t server_loop;
+static uv_thread_t server_thread;
+static uv_sem_t server_ready;
+static uv_async_t server_stop;
+static uv_tcp_t server_tcp;
+static uv_pipe_t server_pipe;
+static uv_udp_t server_udp;
+static uv_stream_t* server_conn;
+static stream_type server_type;
+static char server_buf[65536];
+
+
+static void server_alloc_cb(uv_handle_t* handle,
+                            size_t suggested_size,
+                            uv_buf_t* buf) {
+  buf->base = server_buf;
+  buf->len = sizeof(server_buf);
+}
+
+
+static void server_read_cb(uv_stream_t* stream,
+                           ssize_t nread,
+                           const uv_buf_t* buf) {
+  uv_buf_t reply;
+
+  if (nread < 0) {
+    uv_close((uv_handle_t*) stream, NULL);
+    return;
+  }
+
+  reply = uv_buf_init(buf->base, nread);
+  if (nread > 0)
+    ASSERT(nread == uv_try_write(stream, &reply, 1));
+}
+
+
+static void server_connection_cb(uv_stream_t* server, int status) {
+  ASSERT(status == 0);
+
+  if (server_type == TCP) {
+    server_conn = malloc(sizeof(uv_tcp_t));
+    ASSERT(0 == uv_tcp_init(&server_loop, (uv_tcp_t*) server_conn));
+    ASSERT(0 == uv_tcp_nodelay((uv_tcp_t*) server_conn, 1));
+  } else {
+    server_conn = malloc(sizeof(uv_pipe_t));
+    ASSERT(0 == uv_pipe_init(&server_loop, (uv_pipe_t*) server_conn, 0));
+  }
+
+  ASSERT(0 == uv_accept(server, server_conn));
+  ASSERT(0 == uv_read_start(server_conn, server_alloc_cb, server_read_cb));
+}
+
+
+static void server_recv_cb(uv_udp_t* handle,
+                           ssize_t nread,
+                           const uv_buf_t* buf,
+                           const struct sockaddr* addr,
+                           unsigned flags) {
+  uv_buf_t reply;
+
+  if (nread <= 0 || addr == NULL)
+    return;
+
+  reply = uv_buf_init(buf->base, nread);
+  ASSERT(nread == uv_udp_try_send(handle, &reply, 1, addr));
+}
+
+
+static void server_close_walk_cb(uv_handle_t* handle, void* arg) {
+  if (!uv_is_closing(handle))
+    uv_close(handle, NULL);
+}
+
+
+static void server_stop_cb(uv_async_t* handle) {
+  uv_walk(handle->loop, server_close_walk_cb, NULL);
+}
+
+
+static void server_thread_cb(void* arg) {
+  struct sockaddr_in addr;
+
+  ASSERT(0 == uv_loop_init(&server_loop));
+  ASSERT(0 == uv_async_init(&server_loop, &server_stop, server_stop_cb));
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+
+  switch (server_type) {
+    case TCP:
+      ASSERT(0 == uv_tcp_init(&server_loop, &server_tcp));
+      ASSERT(0 == uv_tcp_bind(&server_tcp, (const struct sockaddr*) &addr, 0));
+      ASSERT(0 == uv_listen((uv_stream_t*) &server_tcp,
+                            1,
+                            server_connection_cb));
+      break;
+    case PIPE:
+      ASSERT(0 == uv_pipe_init(&server_loop, &server_pipe, 0));
+      ASSERT(0 == uv_pipe_bind(&server_pipe, TEST_PIPENAME));
+      ASSERT(0 == uv_listen((uv_stream_t*) &server_pipe,
+                            1,
+                            server_connection_cb));
+      break;
+    case UDP:
+      ASSERT(0 == uv_udp_init(&server_loop, &server_udp));
+      ASSERT(0 == uv_udp_bind(&server_udp, (const struct sockaddr*) &addr, 0));
+      ASSERT(0 == uv_udp_recv_start(&server_udp,
+                                    server_alloc_cb,
+                                    server_recv_cb));
+      break;
+  }
+
+  uv_sem_post(&server_ready);
+  ASSERT(0 == uv_run(&server_loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_close(&server_loop));
+  free(server_conn);
+  server_conn = NULL;
+}
+
+
+static void server_start(stream_type type) {
+  server_type = type;
+  ASSERT(0 == uv_sem_init(&server_ready, 0));
+  ASSERT(0 == uv_thread_create(&server_thread, server_thread_cb, NULL));
+  uv_sem_wait(&server_ready);
+  uv_sem_destroy(&server_ready);
+}
+
+
+static void server_join(void) {
+  ASSERT(0 == uv_async_send(&server_stop));
+  ASSERT(0 == uv_thread_join(&server_thread));
+}
+
+
+/*
+ * Request/response over TCP, pipes and UDP: one MESSAGE_SIZE message in
+ * flight at a time, the latency is the time until the whole echo is back.
+ */
+static uv_tcp_t client_tcp;
+static uv_pipe_t client_pipe;
+static uv_udp_t client_udp;
+static uv_stream_t* client_stream;
+static uv_connect_t connect_req;
+static char message[MESSAGE_SIZE];
+static char client_buf[65536];
+static size_t received;
+static int roundtrips;
+
+
+static void client_alloc_cb(uv_handle_t* handle,
+                            size_t suggested_size,
+                            uv_buf_t* buf) {
+  buf->base = client_buf;
+  buf->len = sizeof(client_buf);
+}
+
+
+static void client_send(void) {
+  uv_buf_t buf;
+
+  buf = uv_buf_init(message, sizeof(message));
+  received = 0;
+  sent_at = uv_hrtime();
+  ASSERT(sizeof(message) == uv_try_write(client_stream, &buf, 1));
+}
+
+
+static void client_read_cb(uv_stream_t* stream,
+                           ssize_t nread,
+                           const uv_buf_t* buf) {
+  ASSERT(nread >= 0);
+
+  received += nread;
+  if (received < sizeof(message))
+    return;
+
+  ASSERT(received == sizeof(message));
+  bench_histogram_record(&histogram, uv_hrtime() - sent_at);
+
+  if (++roundtrips == NUM_ROUNDTRIPS)
+    uv_close((uv_handle_t*) stream, NULL);
+  else
+    client_send();
+}
+
+
+static void client_connect_cb(uv_connect_t* req, int status) {
+  ASSERT(status == 0);
+  ASSERT(0 == uv_read_start(req->handle, client_alloc_cb, client_read_cb));
+  client_send();
+}
+
+
+static int stream_latency(stream_type type, int loaded, const char* name) {
+  struct sockaddr_in addr;
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+  setup(loop, loaded);
+  roundtrips = 0;
+
+#ifndef _WIN32
+  remove(TEST_PIPENAME);
+#endif
+  server_start(type);
+
+  if (type == TCP) {
+    ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+    ASSERT(0 == uv_tcp_init(loop, &client_tcp));
+    ASSERT(0 == uv_tcp_nodelay(&client_tcp, 1));
+    ASSERT(0 == uv_tcp_connect(&connect_req,
+                               &client_tcp,
+                               (const struct sockaddr*) &addr,
+                               client_connect_cb));
+    client_stream = (uv_stream_t*) &client_tcp;
+  } else {
+    ASSERT(0 == uv_pipe_init(loop, &client_pipe, 0));
+    uv_pipe_connect(&connect_req,
+                    &client_pipe,
+                    TEST_PIPENAME,
+                    client_connect_cb);
+    client_stream = (uv_stream_t*) &client_pipe;
+  }
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(roundtrips == NUM_ROUNDTRIPS);
+  server_join();
+
+  histogram_report(name);
+  teardown(loop, loaded);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void udp_send(void) {
+  struct sockaddr_in addr;
+  uv_buf_t buf;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  buf = uv_buf_init(message, sizeof(message));
+  sent_at = uv_hrtime();
+  ASSERT(sizeof(message) == uv_udp_try_send(&client_udp,
+                                            &buf,
+                                            1,
+                                            (const struct sockaddr*) &addr));
+}
+
+
+static void udp_recv_cb(uv_udp_t* handle,
+                        ssize_t nread,
+                        const uv_buf_t* buf,
+                        const struct sockaddr* addr,
+                        unsigned flags) {
+  if (nread == 0 && addr == NULL)
+    return;
+
+  ASSERT(nread == sizeof(message));
+  bench_histogram_record(&histogram, uv_hrtime() - sent_at);
+
+  if (++roundtrips == NUM_ROUNDTRIPS)
+    uv_close((uv_handle_t*) handle, NULL);
+  else
+    udp_send();
+}
+
+
+static int udp_latency(int loaded, const char* name) {
+  struct sockaddr_in addr;
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+  setup(loop, loaded);
+  roundtrips = 0;
+  server_start(UDP);
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", 0, &addr));
+  ASSERT(0 == uv_udp_init(loop, &client_udp));
+  ASSERT(0 == uv_udp_bind(&client_udp, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_udp_recv_start(&client_udp, client_alloc_cb, udp_recv_cb));
+  udp_send();
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(roundtrips == NUM_ROUNDTRIPS);
+  server_join();
+
+  histogram_report(name);
+  teardown(loop, loaded);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+/*
+ * Timer jitter: how late a 1 ms timer fires compared to when it was due.
+ */
+static uv_timer_t timer_handle;
+static int timer_fires;
+
+
+static void timer_cb(uv_timer_t* handle) {
+  bench_histogram_record(&histogram, uv_hrtime() - sent_at);
+
+  if (++timer_fires == NUM_TIMER_FIRES)
+    return;
+
+  sent_at = uv_hrtime() + 1000000;
+  ASSERT(0 == uv_timer_start(handle, timer_cb, 1, 0));
+}
+
+
+static int timer_latency(int loaded, const char* name) {
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+  setup(loop, loaded);
+  timer_fires = 0;
+
+  ASSERT(0 == uv_timer_init(loop, &timer_handle));
+  sent_at = uv_hrtime() + 1000000;
+  ASSERT(0 == uv_timer_start(&timer_handle, timer_cb, 1, 0));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(timer_fires == NUM_TIMER_FIRES);
+
+  histogram_report(name);
+  uv_close((uv_handle_t*) &timer_handle, NULL);
+  teardown(loop, loaded);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+/*
+ * uv_async_send() wakeups: a thread sends, the loop acknowledges with a
+ * semaphore so that sends are never coalesced.
+ */
+static uv_async_t async_handle;
+static uv_sem_t async_ack;
+static volatile uint64_t async_sent_at;
+static int async_wakeups;
+
+
+static void async_cb(uv_async_t* handle) {
+  bench_histogram_record(&histogram, uv_hrtime() - async_sent_at);
+
+  if (++async_wakeups == NUM_ROUNDTRIPS)
+    uv_close((uv_handle_t*) handle, NULL);
+
+  uv_sem_post(&async_ack);
+}
+
+
+static void async_thread_cb(void* arg) {
+  int i;
+
+  for (i = 0; i < NUM_ROUNDTRIPS; i++) {
+    async_sent_at = uv_hrtime();
+    ASSERT(0 == uv_async_send(&async_handle));
+    uv_sem_wait(&async_ack);
+  }
+}
+
+
+static int async_latency(int loaded, const char* name) {
+  uv_thread_t thread;
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+  setup(loop, loaded);
+  async_wakeups = 0;
+
+  ASSERT(0 == uv_sem_init(&async_ack, 0));
+  ASSERT(0 == uv_async_init(loop, &async_handle, async_cb));
+  ASSERT(0 == uv_thread_create(&thread, async_thread_cb, NULL));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_thread_join(&thread));
+  ASSERT(async_wakeups == NUM_ROUNDTRIPS);
+  uv_sem_destroy(&async_ack);
+
+  histogram_report(name);
+  teardown(loop, loaded);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+/*
+ * Threadpool round-trip: from uv_queue_work() to the after_work_cb.
+ */
+static uv_work_t work_req;
+static int work_done;
+
+
+static void work_cb(uv_work_t* req) {
+}
+
+
+static void after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  bench_histogram_record(&histogram, uv_hrtime() - sent_at);
+
+  if (++work_done == NUM_ROUNDTRIPS)
+    return;
+
+  sent_at = uv_hrtime();
+  ASSERT(0 == uv_queue_work(req->loop, req, work_cb, after_work_cb));
+}
+
+
+static int queue_work_latency(int loaded, const char* name) {
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+  setup(loop, loaded);
+  work_done = 0;
+
+  sent_at = uv_hrtime();
+  ASSERT(0 == uv_queue_work(loop, &work_req, work_cb, after_work_cb));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(work_done == NUM_ROUNDTRIPS);
+
+  histogram_report(name);
+  teardown(loop, loaded);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(latency_tcp_idle) {
+  return stream_latency(TCP, 0, "latency_tcp_idle");
+}
+
+
+BENCHMARK_IMPL(latency_tcp_loaded) {
+  return stream_latency(TCP, 1, "latency_tcp_loaded");
+}
+
+
+BENCHMARK_IMPL(latency_pipe_idle) {
+  return stream_latency(PIPE, 0, "latency_pipe_idle");
+}
+
+
+BENCHMARK_IMPL(latency_pipe_loaded) {
+  return stream_latency(PIPE, 1, "latency_pipe_loaded");
+}
+
+
+BENCHMARK_IMPL(latency_udp_idle) {
+  return udp_latency(0, "latency_udp_idle");
+}
+
+
+BENCHMARK_IMPL(latency_udp_loaded) {
+  return udp_latency(1, "latency_udp_loaded");
+}
+
+
+BENCHMARK_IMPL(latency_timer_idle) {
+  return timer_latency(0, "latency_timer_idle");
+}
+
+
+BENCHMARK_IMPL(latency_timer_loaded) {
+  return timer_latency(1, "latency_timer_loaded");
+}
+
+
+BENCHMARK_IMPL(latency_async_idle) {
+  return async_latency(0, "latency_async_idle");
+}
+
+
+BENCHMARK_IMPL(latency_async_loaded) {
+  return async_latency(1, "latency_async_loaded");
+}
+
+
+BENCHMARK_IMPL(latency_queue_work_idle) {
+  return queue_work_latency(0, "latency_queue_work_idle");
+}
+
+
+BENCHMARK_IMPL(latency_queue_work_loaded) {
+  return queue_work_latency(1, "latency_queue_work_loaded");
+}
@@ -22,6 +22,11 @@
 BENCHMARK_DECLARE (sizes)
 BENCHMARK_DECLARE (loop_count)
 BENCHMARK_DECLARE (loop_count_timed)
+BENCHMARK_DECLARE (loop_count_coarse)
+BENCHMARK_DECLARE (loop_watchers_10k)
+BENCHMARK_DECLARE (loop_watchers_churn)
+BENCHMARK_DECLARE (defer_next_tick)
+BENCHMARK_DECLARE (defer_idle_handle)
 BENCHMARK_DECLARE (ping_pongs)
 BENCHMARK_DECLARE (tcp_write_batch)
 BENCHMARK_DECLARE (tcp4_pound_100)
@@ -63,6 +68,14 @@ BENCHMARK_DECLARE (udp_timed_pummel_1000v1000)
 
 BENCHMARK_DECLARE (getaddrinfo)
 BENCHMARK_DECLARE (fs_stat)
+BENCHMARK_DECLARE (fs_seq_read)
+BENCHMARK_DECLARE (fs_seq_write)
+BENCHMARK_DECLARE (fs_rand_read)
+BENCHMARK_DECLARE (fs_rand_write)
+BENCHMARK_DECLARE (fs_create_storm)
+BENCHMARK_DECLARE (fs_scandir)
+BENCHMARK_DECLARE (fs_fsync)
+BENCHMARK_DECLARE (fs_sendfile)
 BENCHMARK_DECLARE (async1)
 BENCHMARK_DECLARE (async2)
 BENCHMARK_DECLARE (async4)
@@ -73,8 +86,39 @@ BENCHMARK_DECLARE (async_pummel_4)
 BENCHMARK_DECLARE (async_pummel_8)
 BENCHMARK_DECLARE (spawn)
 BENCHMARK_DECLARE (thread_create)
+BENCHMARK_DECLARE (threadpool_roundtrip)
+BENCHMARK_DECLARE (threadpool_throughput)
+BENCHMARK_DECLARE (threadpool_wakeup)
+BENCHMARK_DECLARE (threadpool_cancel)
+BENCHMARK_DECLARE (threadpool_completion)
 BENCHMARK_DECLARE (million_async)
 BENCHMARK_DECLARE (million_timers)
+BENCHMARK_DECLARE (million_tcp_connections)
+BENCHMARK_DECLARE (watcher_table_high_fd)
+BENCHMARK_DECLARE (latency_tcp_idle)
+BENCHMARK_DECLARE (latency_tcp_loaded)
+BENCHMARK_DECLARE (latency_pipe_idle)
+BENCHMARK_DECLARE (latency_pipe_loaded)
+BENCHMARK_DECLARE (latency_udp_idle)
+BENCHMARK_DECLARE (latency_udp_loaded)
+BENCHMARK_DECLARE (latency_timer_idle)
+BENCHMARK_DECLARE (latency_timer_loaded)
+BENCHMARK_DECLARE (latency_async_idle)
+BENCHMARK_DECLARE (latency_async_loaded)
+BENCHMARK_DECLARE (latency_queue_work_idle)
+BENCHMARK_DECLARE (latency_queue_work_loaded)
+BENCHMARK_DECLARE (scaling_tcp_echo)
+BENCHMARK_DECLARE (scaling_udp_echo)
+BENCHMARK_DECLARE (scaling_timers)
+BENCHMARK_DECLARE (scaling_fs_stat)
+BENCHMARK_DECLARE (scaling_signals)
+BENCHMARK_DECLARE (scaling_spawn)
+BENCHMARK_DECLARE (replay)
+#ifdef UV_CORO_BENCHMARKS
+BENCHMARK_DECLARE (coro_timers)
+BENCHMARK_DECLARE (coro_fs_stat)
+BENCHMARK_DECLARE (coro_pingpong)
+#endif
 HELPER_DECLARE    (tcp4_blackhole_server)
 HELPER_DECLARE    (tcp_pump_server)
 HELPER_DECLARE    (pipe_pump_server)
@@ -86,6 +130,11 @@ TASK_LIST_START
   BENCHMARK_ENTRY  (sizes)
   BENCHMARK_ENTRY  (loop_count)
   BENCHMARK_ENTRY  (loop_count_timed)
+  BENCHMARK_ENTRY  (loop_count_coarse)
+  BENCHMARK_ENTRY  (loop_watchers_10k)
+  BENCHMARK_ENTRY  (loop_watchers_churn)
+  BENCHMARK_ENTRY  (defer_next_tick)
+  BENCHMARK_ENTRY  (defer_idle_handle)
 
   BENCHMARK_ENTRY  (ping_pongs)
   BENCHMARK_HELPER (ping_pongs, tcp4_echo_server)
@@ -146,6 +195,14 @@ TASK_LIST_START
   BENCHMARK_ENTRY  (getaddrinfo)
 
   BENCHMARK_ENTRY  (fs_stat)
+  BENCHMARK_ENTRY  (fs_seq_read)
+  BENCHMARK_ENTRY  (fs_seq_write)
+  BENCHMARK_ENTRY  (fs_rand_read)
+  BENCHMARK_ENTRY  (fs_rand_write)
+  BENCHMARK_ENTRY  (fs_create_storm)
+  BENCHMARK_ENTRY  (fs_scandir)
+  BENCHMARK_ENTRY  (fs_fsync)
+  BENCHMARK_ENTRY  (fs_sendfile)
 
   BENCHMARK_ENTRY  (async1)
   BENCHMARK_ENTRY  (async2)
@@ -158,6 +215,41 @@ TASK_LIST_START
 
   BENCHMARK_ENTRY  (spawn)
   BENCHMARK_ENTRY  (thread_create)
+  BENCHMARK_ENTRY  (threadpool_roundtrip)
+  BENCHMARK_ENTRY  (threadpool_throughput)
+  BENCHMARK_ENTRY  (threadpool_wakeup)
+  BENCHMARK_ENTRY  (threadpool_cancel)
+  BENCHMARK_ENTRY  (threadpool_completion)
   BENCHMARK_ENTRY  (million_async)
   BENCHMARK_ENTRY  (million_timers)
+  BENCHMARK_ENTRY  (million_tcp_connections)
+  BENCHMARK_ENTRY  (watcher_table_high_fd)
+
+  BENCHMARK_ENTRY  (latency_tcp_idle)
+  BENCHMARK_ENTRY  (latency_tcp_loaded)
+  BENCHMARK_ENTRY  (latency_pipe_idle)
+  BENCHMARK_ENTRY  (latency_pipe_loaded)
+  BENCHMARK_ENTRY  (latency_udp_idle)
+  BENCHMARK_ENTRY  (latency_udp_loaded)
+  BENCHMARK_ENTRY  (latency_timer_idle)
+  BENCHMARK_ENTRY  (latency_timer_loaded)
+  BENCHMARK_ENTRY  (latency_async_idle)
+  BENCHMARK_ENTRY  (latency_async_loaded)
+  BENCHMARK_ENTRY  (latency_queue_work_idle)
+  BENCHMARK_ENTRY  (latency_queue_work_loaded)
+
+  BENCHMARK_ENTRY  (scaling_tcp_echo)
+  BENCHMARK_ENTRY  (scaling_udp_echo)
+  BENCHMARK_ENTRY  (scaling_timers)
+  BENCHMARK_ENTRY  (scaling_fs_stat)
+  BENCHMARK_ENTRY  (scaling_signals)
+  BENCHMARK_ENTRY  (scaling_spawn)
+
+  BENCHMARK_ENTRY  (replay)
+
+#ifdef UV_CORO_BENCHMARKS
+  BENCHMARK_ENTRY  (coro_timers)
+  BENCHMARK_ENTRY  (coro_fs_stat)
+  BENCHMARK_ENTRY  (coro_pingpong)
+#endif
 TASK_LIST_END
@@ -0,0 +1,117 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "task.h"
+#include "uv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_WATCHERS 10000
+#define NUM_ITERATIONS 10000
+
+static uv_check_t* watchers;
+static uv_idle_t idle_handle;
+static unsigned long calls;
+static unsigned int iterations;
+static int churn;
+
+
+static void check_cb(uv_check_t* handle) {
+  calls++;
+
+  /* Stop and restart a neighbour every so often to keep the start/stop
+   * paths and compaction busy while the array is walked.
+   */
+  if (churn && calls % 16 == 0) {
+    uv_check_t* other = &watchers[(handle - watchers + 1) % NUM_WATCHERS];
+    uv_check_stop(other);
+    uv_check_start(other, check_cb);
+  }
+}
+
+
+static void idle_cb(uv_idle_t* handle) {
+  unsigned int i;
+
+  if (++iterations < NUM_ITERATIONS)
+    return;
+
+  uv_idle_stop(handle);
+  for (i = 0; i < NUM_WATCHERS; i++)
+    uv_check_stop(&watchers[i]);
+}
+
+
+static int loop_watchers(const char* name, int with_churn) {
+  uv_loop_t* loop = uv_default_loop();
+  unsigned int i;
+  uint64_t ns;
+
+  churn = with_churn;
+  watchers = malloc(NUM_WATCHERS * sizeof(*watchers));
+  ASSERT(watchers != NULL);
+
+  for (i = 0; i < NUM_WATCHERS; i++) {
+    ASSERT(0 == uv_check_init(loop, &watchers[i]));
+    ASSERT(0 == uv_check_start(&watchers[i], check_cb));
+  }
+
+  /* The idle handle keeps the poll phase from blocking. */
+  ASSERT(0 == uv_idle_init(loop, &idle_handle));
+  ASSERT(0 == uv_idle_start(&idle_handle, idle_cb));
+
+  ns = uv_hrtime();
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ns = uv_hrtime() - ns;
+
+  /* Restarted neighbours skip the rest of the iteration they restart in. */
+  if (!churn)
+    ASSERT(calls == (unsigned long) NUM_WATCHERS * (NUM_ITERATIONS - 1));
+
+  fprintf(stderr, "%s: %lu check callbacks in %.2fs (%.0f/s)\n",
+          name,
+          calls,
+          ns / 1e9,
+          calls / (ns / 1e9));
+  fflush(stderr);
+  benchmark_report("callbacks", calls / (ns / 1e9), "callbacks/s");
+
+  for (i = 0; i < NUM_WATCHERS; i++)
+    uv_close((uv_handle_t*) &watchers[i], NULL);
+  uv_close((uv_handle_t*) &idle_handle, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  free(watchers);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(loop_watchers_10k) {
+  return loop_watchers("loop_watchers_10k", 0);
+}
+
+
+BENCHMARK_IMPL(loop_watchers_churn) {
+  return loop_watchers("loop_watchers_churn", 1);
+}
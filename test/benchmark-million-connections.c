@@ -0,0 +1,286 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "task.h"
+#include "uv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+# include <netinet/in.h>
+# include <sys/resource.h>
+# include <sys/socket.h>
+#endif
+
+/* Up to a million mostly idle loopback connections, both ends in one loop.
+ * Every source address (127.0.0.x) gets its own range of ephemeral ports, so
+ * the real limit is the number of file descriptors: two per connection.
+ * IP_BIND_ADDRESS_NO_PORT defers picking the port to connect(), otherwise
+ * every bind() searches the ephemeral range and connecting gets quadratic.
+ */
+#define NUM_CONNECTIONS (1000 * 1000)
+#define CONNECTIONS_PER_SOURCE 25000
+#define MAX_CONCURRENT_CONNECTS 512
+#define NUM_ACTIVE 100
+#define NUM_ROUNDS 100
+#define NUM_IDLE_ITERATIONS 1000
+
+static uv_tcp_t server;
+static uv_tcp_t** clients;
+static uv_connect_t* connect_reqs;
+static int num_connections;
+static int num_started;
+static int num_connected;
+static int num_accepted;
+static size_t bytes_read;
+static char read_buf[64];
+
+
+static void alloc_cb(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf) {
+  buf->base = read_buf;
+  buf->len = sizeof(read_buf);
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  ASSERT(nread >= 0);
+  bytes_read += nread;
+}
+
+
+static void free_cb(uv_handle_t* handle) {
+  free(handle);
+}
+
+
+static void connection_cb(uv_stream_t* s, int status) {
+  uv_tcp_t* conn;
+
+  ASSERT(status == 0);
+
+  conn = malloc(sizeof(*conn));
+  ASSERT(conn != NULL);
+  ASSERT(0 == uv_tcp_init(s->loop, conn));
+  ASSERT(0 == uv_accept(s, (uv_stream_t*) conn));
+  ASSERT(0 == uv_read_start((uv_stream_t*) conn, alloc_cb, read_cb));
+  num_accepted++;
+}
+
+
+static void start_connect(uv_loop_t* loop, uv_connect_t* req);
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  ASSERT(status == 0);
+  num_connected++;
+
+  if (num_started < num_connections)
+    start_connect(req->handle->loop, req);
+}
+
+
+static void bind_address_no_port(uv_tcp_t* handle) {
+#ifdef IP_BIND_ADDRESS_NO_PORT
+  uv_os_fd_t fd;
+  int on;
+
+  on = 1;
+  ASSERT(0 == uv_fileno((uv_handle_t*) handle, &fd));
+  ASSERT(0 == setsockopt(fd,
+                         IPPROTO_IP,
+                         IP_BIND_ADDRESS_NO_PORT,
+                         &on,
+                         sizeof(on)));
+#endif
+}
+
+
+static void start_connect(uv_loop_t* loop, uv_connect_t* req) {
+  struct sockaddr_in source;
+  struct sockaddr_in addr;
+  char ip[16];
+  uv_tcp_t* client;
+  int n;
+
+  n = num_started++;
+  snprintf(ip, sizeof(ip), "127.0.0.%d", 2 + n / CONNECTIONS_PER_SOURCE);
+  ASSERT(0 == uv_ip4_addr(ip, 0, &source));
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+
+  client = malloc(sizeof(*client));
+  ASSERT(client != NULL);
+  clients[n] = client;
+
+  ASSERT(0 == uv_tcp_init_ex(loop, client, AF_INET));
+  bind_address_no_port(client);
+  ASSERT(0 == uv_tcp_bind(client, (const struct sockaddr*) &source, 0));
+  ASSERT(0 == uv_tcp_connect(req,
+                             client,
+                             (const struct sockaddr*) &addr,
+                             connect_cb));
+}
+
+
+static void free_walk_cb(uv_handle_t* handle, void* arg) {
+  if (handle != (uv_handle_t*) &server)
+    uv_close(handle, free_cb);
+}
+
+
+static unsigned fastrand(void) {
+  static unsigned g = 0;
+  g = g * 214013 + 2531011;
+  return g >> 8;
+}
+
+
+BENCHMARK_IMPL(million_tcp_connections) {
+#ifdef _WIN32
+  RETURN_SKIP("Not supported on Windows.");
+#else
+  struct sockaddr_in addr;
+  struct rlimit lim;
+  uv_loop_t* loop;
+  uv_buf_t buf;
+  size_t rss_before;
+  size_t rss_after;
+  uint64_t connect_ns;
+  uint64_t idle_ns;
+  uint64_t active_ns;
+  uint64_t max_ns;
+  uint64_t ns;
+  int round;
+  int i;
+
+  ASSERT(0 == getrlimit(RLIMIT_NOFILE, &lim));
+  if (lim.rlim_cur < lim.rlim_max) {
+    lim.rlim_cur = lim.rlim_max;
+    if (lim.rlim_cur > 4 * NUM_CONNECTIONS)
+      lim.rlim_cur = 4 * NUM_CONNECTIONS;
+    setrlimit(RLIMIT_NOFILE, &lim);
+    ASSERT(0 == getrlimit(RLIMIT_NOFILE, &lim));
+  }
+
+  /* Leave some file descriptors for the loop and the test runner. */
+  num_connections = NUM_CONNECTIONS;
+  if ((rlim_t) num_connections > (lim.rlim_cur - 64) / 2)
+    num_connections = (int) ((lim.rlim_cur - 64) / 2);
+
+  if (num_connections < NUM_ACTIVE)
+    RETURN_SKIP("File descriptor limit too low.");
+
+  clients = malloc(num_connections * sizeof(*clients));
+  connect_reqs = malloc(MAX_CONCURRENT_CONNECTS * sizeof(*connect_reqs));
+  ASSERT(clients != NULL);
+  ASSERT(connect_reqs != NULL);
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(loop, &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server,
+                        2 * MAX_CONCURRENT_CONNECTS,
+                        connection_cb));
+
+  ASSERT(0 == uv_resident_set_memory(&rss_before));
+
+  /* Establish all connections, MAX_CONCURRENT_CONNECTS at a time. */
+  ns = uv_hrtime();
+  for (i = 0; i < MAX_CONCURRENT_CONNECTS && i < num_connections; i++)
+    start_connect(loop, connect_reqs + i);
+
+  while (num_connected < num_connections || num_accepted < num_connections)
+    uv_run(loop, UV_RUN_ONCE);
+  connect_ns = uv_hrtime() - ns;
+
+  ASSERT(0 == uv_resident_set_memory(&rss_after));
+
+  /* Cost of a loop iteration when nothing happens. */
+  ns = uv_hrtime();
+  for (i = 0; i < NUM_IDLE_ITERATIONS; i++)
+    uv_run(loop, UV_RUN_NOWAIT);
+  idle_ns = uv_hrtime() - ns;
+
+  /* Sparse activity: a keepalive byte on NUM_ACTIVE random connections,
+   * measured until the other end has read all of them.
+   */
+  buf = uv_buf_init("!", 1);
+  active_ns = 0;
+  max_ns = 0;
+
+  for (round = 0; round < NUM_ROUNDS; round++) {
+    bytes_read = 0;
+    ns = uv_hrtime();
+
+    for (i = 0; i < NUM_ACTIVE; i++)
+      ASSERT(1 == uv_try_write((uv_stream_t*) clients[fastrand() %
+                                                      num_connections],
+                               &buf,
+                               1));
+
+    while (bytes_read < NUM_ACTIVE)
+      uv_run(loop, UV_RUN_ONCE);
+
+    ns = uv_hrtime() - ns;
+    active_ns += ns;
+    if (ns > max_ns)
+      max_ns = ns;
+  }
+
+  fprintf(stderr,
+          "million_tcp_connections: %s connections from %d source addresses\n",
+          fmt(num_connections),
+          1 + (num_connections - 1) / CONNECTIONS_PER_SOURCE);
+  fprintf(stderr,
+          "  established in %.2fs (%s/s), rss: %s bytes/connection\n",
+          connect_ns / 1e9,
+          fmt(num_connections / (connect_ns / 1e9)),
+          fmt((double) (rss_after - rss_before) / num_connections));
+  fprintf(stderr,
+          "  idle loop iteration: %.1fus\n",
+          idle_ns / 1e3 / NUM_IDLE_ITERATIONS);
+  fprintf(stderr,
+          "  %d active of %s connections: %.1fus mean, %.1fus max\n",
+          NUM_ACTIVE,
+          fmt(num_connections),
+          active_ns / 1e3 / NUM_ROUNDS,
+          max_ns / 1e3);
+  fflush(stderr);
+
+  benchmark_report("connect", num_connections / (connect_ns / 1e9), "conns/s");
+  benchmark_report("rss",
+                   (double) (rss_after - rss_before) / num_connections,
+                   "bytes");
+  benchmark_report("idle_iteration", idle_ns / 1e3 / NUM_IDLE_ITERATIONS, "us");
+  benchmark_report("sparse_activity", active_ns / 1e3 / NUM_ROUNDS, "us");
+
+  uv_walk(loop, free_walk_cb, NULL);
+  uv_close((uv_handle_t*) &server, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  free(connect_reqs);
+  free(clients);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
@@ -414,6 +414,7 @@ static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
          num_servers,
          NUM_CONNECTS / time,
          NUM_CONNECTS);
+  benchmark_report("accepts", NUM_CONNECTS / time, "accepts/s");
 
   for (i = 0; i < num_servers; i++) {
     struct server_ctx* ctx = servers + i;
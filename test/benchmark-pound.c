@@ -305,6 +305,7 @@ static int pound_it(int concurrency,
           closed_streams / secs,
           conns_failed);
   fflush(stderr);
+  benchmark_report("accepts", closed_streams / secs, "accepts/s");
 
   MAKE_VALGRIND_HAPPY();
   return 0;
@@ -107,6 +107,7 @@ static void show_stats(uv_timer_t* handle) {
             write_sockets,
             gbit(nsent_total, diff));
     fflush(stderr);
+    benchmark_report("throughput", gbit(nsent_total, diff), "gbit/s");
 
     for (i = 0; i < write_sockets; i++) {
       if (type == TCP)
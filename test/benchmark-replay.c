@@ -0,0 +1,421 @@
+/* Copyright libuv project contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+/* Replays a recording made with the UV_LOOP_RECORD loop option.  Every file
+ * descriptor in the recording is mapped to a socketpair whose far end is
+ * driven by the benchmark: recorded reads become writes into the loop, timer
+ * callbacks become zero timeouts and request callbacks become threadpool
+ * work.  What's left is the cost of the loop itself for that event sequence.
+ *
+ * Set UV_REPLAY_FILE to replay a file, otherwise a synthetic session is
+ * recorded first.
+ */
+
+#include "task.h"
+#include "uv.h"
+#include "bench-harness.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+# include <fcntl.h>
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
+#define MAX_SLOTS 256
+#define MAX_TIMERS 64
+#define MAX_CHUNK 65536
+
+#define RECORD_PAIRS 8
+#define RECORD_TICKS 1000
+#define RECORD_MSG_SIZE 256
+
+#ifndef _WIN32
+
+struct slot {
+  uv_pipe_t pipe;
+  int fd;        /* As recorded. */
+  int driver;    /* Our end of the socketpair. */
+};
+
+struct record_pair {
+  uv_pipe_t client;
+  uv_pipe_t server;
+  unsigned int nreads;
+};
+
+static struct slot slots[MAX_SLOTS];
+static unsigned int nslots;
+static uv_timer_t timers[MAX_TIMERS];
+static unsigned int next_timer;
+static int64_t pending;
+static bench_histogram_t histogram;
+static char buf[MAX_CHUNK];
+static char sink[MAX_CHUNK];
+
+static struct record_pair pairs[RECORD_PAIRS];
+static uv_timer_t tick_handle;
+static unsigned int ticks;
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* b) {
+  *b = uv_buf_init(sink, sizeof(sink));
+}
+
+
+static void work_cb(uv_work_t* req) {
+}
+
+
+static void after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  free(req);
+  pending--;
+}
+
+
+static void queue_work(uv_loop_t* loop) {
+  uv_work_t* req;
+
+  req = malloc(sizeof(*req));
+  ASSERT(req != NULL);
+  ASSERT(0 == uv_queue_work(loop, req, work_cb, after_work_cb));
+  pending++;
+}
+
+
+static void try_write(uv_pipe_t* handle, size_t len) {
+  uv_buf_t b;
+
+  b = uv_buf_init(buf, len);
+  uv_try_write((uv_stream_t*) handle, &b, 1);
+}
+
+
+/* The synthetic session: clients send a message per tick, servers echo it
+ * and hand every fourth one to the threadpool.
+ */
+static void server_read_cb(uv_stream_t* stream,
+                           ssize_t nread,
+                           const uv_buf_t* b) {
+  struct record_pair* p;
+
+  if (nread <= 0)
+    return;
+
+  p = container_of(stream, struct record_pair, server);
+  try_write(&p->server, nread);
+
+  if (++p->nreads % 4 == 0)
+    queue_work(stream->loop);
+}
+
+
+static void client_read_cb(uv_stream_t* stream,
+                           ssize_t nread,
+                           const uv_buf_t* b) {
+}
+
+
+static void tick_cb(uv_timer_t* handle) {
+  unsigned int i;
+
+  if (++ticks == RECORD_TICKS) {
+    uv_close((uv_handle_t*) handle, NULL);
+    for (i = 0; i < RECORD_PAIRS; i++) {
+      uv_close((uv_handle_t*) &pairs[i].client, NULL);
+      uv_close((uv_handle_t*) &pairs[i].server, NULL);
+    }
+    return;
+  }
+
+  for (i = 0; i < RECORD_PAIRS; i++)
+    try_write(&pairs[i].client, RECORD_MSG_SIZE);
+}
+
+
+static void record_session(FILE* fp) {
+  uv_loop_t loop;
+  unsigned int i;
+  int fds[2];
+
+  ASSERT(0 == uv_loop_init(&loop));
+
+  for (i = 0; i < RECORD_PAIRS; i++) {
+    ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    ASSERT(0 == uv_pipe_init(&loop, &pairs[i].client, 0));
+    ASSERT(0 == uv_pipe_init(&loop, &pairs[i].server, 0));
+    ASSERT(0 == uv_pipe_open(&pairs[i].client, fds[0]));
+    ASSERT(0 == uv_pipe_open(&pairs[i].server, fds[1]));
+    ASSERT(0 == uv_read_start((uv_stream_t*) &pairs[i].client,
+                              alloc_cb,
+                              client_read_cb));
+    ASSERT(0 == uv_read_start((uv_stream_t*) &pairs[i].server,
+                              alloc_cb,
+                              server_read_cb));
+  }
+
+  ASSERT(0 == uv_timer_init(&loop, &tick_handle));
+  ASSERT(0 == uv_timer_start(&tick_handle, tick_cb, 1, 1));
+
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_RECORD, fp));
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_RECORD, NULL));
+  ASSERT(0 == uv_loop_close(&loop));
+
+  pending = 0;
+}
+
+
+static uv_record_t* load(FILE* fp, size_t* count) {
+  uv_record_t* records;
+  char magic[8];
+  long size;
+
+  ASSERT(0 == fseek(fp, 0, SEEK_END));
+  size = ftell(fp);
+  ASSERT(size >= (long) sizeof(magic));
+  rewind(fp);
+
+  ASSERT(1 == fread(magic, sizeof(magic), 1, fp));
+  ASSERT(0 == memcmp(magic, UV_RECORD_MAGIC, sizeof(magic)));
+
+  *count = (size - sizeof(magic)) / sizeof(*records);
+  records = malloc(*count * sizeof(*records) + 1);
+  ASSERT(records != NULL);
+  ASSERT(*count == fread(records, sizeof(*records), *count, fp));
+
+  return records;
+}
+
+
+static void replay_read_cb(uv_stream_t* stream,
+                           ssize_t nread,
+                           const uv_buf_t* b) {
+  if (nread > 0)
+    pending -= nread;
+}
+
+
+static struct slot* slot_get(uv_loop_t* loop, int fd) {
+  struct slot* s;
+  unsigned int i;
+  int fds[2];
+
+  for (i = 0; i < nslots; i++)
+    if (slots[i].fd == fd)
+      return &slots[i];
+
+  /* Events on descriptors past the limit are dropped. */
+  if (nslots == MAX_SLOTS)
+    return NULL;
+
+  s = &slots[nslots++];
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  ASSERT(0 == fcntl(fds[0], F_SETFL, O_NONBLOCK));
+  s->fd = fd;
+  s->driver = fds[0];
+  ASSERT(0 == uv_pipe_init(loop, &s->pipe, 0));
+  ASSERT(0 == uv_pipe_open(&s->pipe, fds[1]));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &s->pipe,
+                            alloc_cb,
+                            replay_read_cb));
+
+  return s;
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  pending--;
+}
+
+
+static void start_timer(void) {
+  uv_timer_t* t;
+
+  t = &timers[next_timer++ % MAX_TIMERS];
+  if (uv_is_active((uv_handle_t*) t))
+    return;
+
+  ASSERT(0 == uv_timer_start(t, timer_cb, 0, 0));
+  pending++;
+}
+
+
+static void replay_event(uv_loop_t* loop, const uv_record_t* r) {
+  struct slot* s;
+  ssize_t n;
+  size_t len;
+
+  len = r->value < MAX_CHUNK ? r->value : MAX_CHUNK;
+
+  switch (r->kind) {
+    case UV_RECORD_READ:
+      s = slot_get(loop, r->fd);
+      if (s == NULL)
+        break;
+      n = write(s->driver, buf, len);
+      if (n > 0)
+        pending += n;
+      break;
+
+    case UV_RECORD_WRITE:
+      s = slot_get(loop, r->fd);
+      if (s == NULL)
+        break;
+      try_write(&s->pipe, len);
+      do
+        n = read(s->driver, sink, sizeof(sink));
+      while (n > 0 || (n == -1 && errno == EINTR));
+      break;
+
+    case UV_RECORD_HANDLE_CB:
+      if (r->type == UV_TIMER)
+        start_timer();
+      break;
+
+    case UV_RECORD_REQ_CB:
+      if (r->type == UV_WORK || r->type == UV_FS)
+        queue_work(loop);
+      break;
+  }
+}
+
+
+/* Replays the recording once.  Returns the number of loop iterations. */
+static unsigned int replay(uv_loop_t* loop,
+                           const uv_record_t* records,
+                           size_t count) {
+  unsigned int iterations;
+  uint64_t start;
+  size_t i;
+
+  iterations = 0;
+
+  /* An iteration record comes after the events that happened during it. */
+  for (i = 0; i < count; i++) {
+    if (records[i].kind != UV_RECORD_ITERATION) {
+      replay_event(loop, &records[i]);
+      continue;
+    }
+
+    /* UV_RUN_ONCE runs due timers before it polls, it would block after
+     * running the last outstanding one.
+     */
+    start = uv_hrtime();
+    uv_run(loop, UV_RUN_NOWAIT);
+    while (pending > 0)
+      uv_run(loop, UV_RUN_ONCE);
+    bench_histogram_record(&histogram, uv_hrtime() - start);
+    iterations++;
+  }
+
+  return iterations;
+}
+
+#endif  /* !_WIN32 */
+
+
+BENCHMARK_IMPL(replay) {
+#ifdef _WIN32
+  RETURN_SKIP("Not supported on Windows.");
+#else
+  uv_record_t* records;
+  const char* path;
+  uv_loop_t* loop;
+  uint64_t iterations;
+  uint64_t events;
+  uint64_t start;
+  uint64_t elapsed;
+  unsigned int i;
+  size_t count;
+  double rate;
+  double p50;
+  double p99;
+  FILE* fp;
+
+  path = getenv("UV_REPLAY_FILE");
+  if (path != NULL) {
+    fp = fopen(path, "rb");
+    ASSERT(fp != NULL);
+  } else {
+    fp = tmpfile();
+    ASSERT(fp != NULL);
+    record_session(fp);
+  }
+
+  records = load(fp, &count);
+  fclose(fp);
+
+  loop = uv_default_loop();
+  for (i = 0; i < MAX_TIMERS; i++)
+    ASSERT(0 == uv_timer_init(loop, &timers[i]));
+
+  bench_histogram_reset(&histogram);
+  iterations = 0;
+  events = 0;
+  start = uv_hrtime();
+
+  /* Go around a few times so short recordings give stable numbers. */
+  do {
+    iterations += replay(loop, records, count);
+    events += count;
+    elapsed = uv_hrtime() - start;
+  } while (elapsed < (uint64_t) 1e9 && iterations > 0);
+
+  rate = iterations / (elapsed / 1e9);
+  p50 = bench_histogram_percentile(&histogram, 50) / 1e3;
+  p99 = bench_histogram_percentile(&histogram, 99) / 1e3;
+
+  fprintf(stderr,
+          "replay %s: %s events, %s iterations/s, p50 %.1fus, p99 %.1fus, "
+          "%u descriptors\n",
+          path != NULL ? path : "(synthetic)",
+          fmt((double) events),
+          fmt(rate),
+          p50,
+          p99,
+          nslots);
+  fflush(stderr);
+
+  benchmark_report("iterations", rate, "iterations/s");
+  benchmark_report("p50", p50, "us");
+  benchmark_report("p99", p99, "us");
+
+  for (i = 0; i < nslots; i++) {
+    uv_close((uv_handle_t*) &slots[i].pipe, NULL);
+    close(slots[i].driver);
+  }
+  for (i = 0; i < MAX_TIMERS; i++)
+    uv_close((uv_handle_t*) &timers[i], NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  free(records);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
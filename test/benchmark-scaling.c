@@ -0,0 +1,550 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DURATION 1000  /* ms per data point */
+#define MAX_LOOPS 64
+#define MESSAGE_SIZE 64
+#define NUM_TIMERS 64
+#define MAX_CONCURRENT_REQS 32
+#define NUM_SIGNALS 16
+
+/*
+ * Runs K independent loops on K threads for K = 1, 2, 4, ... up to the number
+ * of CPUs and reports how the aggregate throughput scales.  The loops share
+ * nothing but libuv's process-wide state, like the threadpool, so any drop in
+ * efficiency is a shared-state bottleneck (or the hardware's).
+ *
+ * SIGNALS churns signal handles, which serializes on the process-wide signal
+ * lock.  SPAWN runs child processes with a stdout pipe back to back; every
+ * spawn write-locks the loop's cloexec_lock and every exit is reported
+ * through the SIGCHLD watcher, so the signal lock shows up there as well.
+ */
+
+typedef enum {
+  TCP_ECHO,
+  UDP_ECHO,
+  TIMERS,
+  FS_STAT,
+  SIGNALS,
+  SPAWN
+} workload_t;
+
+typedef struct {
+  uv_thread_t thread;
+  uv_loop_t loop;
+  uv_timer_t stop_timer;
+  workload_t workload;
+  uint64_t ops;
+  int stopped;
+  /* TCP_ECHO */
+  uv_tcp_t tcp_server;
+  uv_tcp_t tcp_client;
+  uv_tcp_t tcp_conn;
+  uv_connect_t connect_req;
+  /* UDP_ECHO */
+  uv_udp_t udp_server;
+  uv_udp_t udp_client;
+  struct sockaddr_storage server_addr;
+  /* TIMERS */
+  uv_idle_t idle;
+  uv_timer_t timers[NUM_TIMERS];
+  /* FS_STAT */
+  uv_fs_t fs_reqs[MAX_CONCURRENT_REQS];
+  /* SIGNALS */
+  uv_signal_t signals[NUM_SIGNALS];
+  /* SPAWN */
+  uv_process_t process;
+  uv_pipe_t out;
+  int spawn_pending;
+  char buf[65536];
+} worker_t;
+
+static worker_t workers[MAX_LOOPS];
+static uv_barrier_t start_barrier;
+static char message[MESSAGE_SIZE];
+static char exepath[1024];
+
+
+static worker_t* handle_worker(uv_handle_t* handle) {
+  return container_of(handle->loop, worker_t, loop);
+}
+
+
+static void alloc_cb(uv_handle_t* handle,
+                     size_t suggested_size,
+                     uv_buf_t* buf) {
+  worker_t* w;
+
+  w = handle_worker(handle);
+  buf->base = w->buf;
+  buf->len = sizeof(w->buf);
+}
+
+
+static void stop_cb(uv_timer_t* handle) {
+  worker_t* w;
+
+  w = handle_worker((uv_handle_t*) handle);
+  w->stopped = 1;
+  uv_walk(&w->loop, close_walk_cb, NULL);
+}
+
+
+static void echo_read_cb(uv_stream_t* stream,
+                         ssize_t nread,
+                         const uv_buf_t* buf) {
+  uv_buf_t reply;
+
+  if (nread <= 0)
+    return;
+
+  reply = uv_buf_init(buf->base, nread);
+  ASSERT(nread == uv_try_write(stream, &reply, 1));
+}
+
+
+static void client_read_cb(uv_stream_t* stream,
+                           ssize_t nread,
+                           const uv_buf_t* buf) {
+  uv_buf_t msg;
+  worker_t* w;
+
+  if (nread <= 0)
+    return;
+
+  /* Requests and replies are a single small segment on loopback. */
+  ASSERT(nread == sizeof(message));
+  w = handle_worker((uv_handle_t*) stream);
+  w->ops++;
+
+  msg = uv_buf_init(message, sizeof(message));
+  ASSERT(sizeof(message) == uv_try_write(stream, &msg, 1));
+}
+
+
+static void connection_cb(uv_stream_t* server, int status) {
+  worker_t* w;
+
+  ASSERT(status == 0);
+  w = handle_worker((uv_handle_t*) server);
+  ASSERT(0 == uv_tcp_init(&w->loop, &w->tcp_conn));
+  ASSERT(0 == uv_tcp_nodelay(&w->tcp_conn, 1));
+  ASSERT(0 == uv_accept(server, (uv_stream_t*) &w->tcp_conn));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &w->tcp_conn,
+                            alloc_cb,
+                            echo_read_cb));
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  uv_buf_t msg;
+
+  ASSERT(status == 0);
+  ASSERT(0 == uv_read_start(req->handle, alloc_cb, client_read_cb));
+  msg = uv_buf_init(message, sizeof(message));
+  ASSERT(sizeof(message) == uv_try_write(req->handle, &msg, 1));
+}
+
+
+static void tcp_echo_start(worker_t* w) {
+  struct sockaddr_in addr;
+  int len;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", 0, &addr));
+  ASSERT(0 == uv_tcp_init(&w->loop, &w->tcp_server));
+  ASSERT(0 == uv_tcp_bind(&w->tcp_server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &w->tcp_server, 1, connection_cb));
+
+  len = sizeof(w->server_addr);
+  ASSERT(0 == uv_tcp_getsockname(&w->tcp_server,
+                                 (struct sockaddr*) &w->server_addr,
+                                 &len));
+
+  ASSERT(0 == uv_tcp_init(&w->loop, &w->tcp_client));
+  ASSERT(0 == uv_tcp_nodelay(&w->tcp_client, 1));
+  ASSERT(0 == uv_tcp_connect(&w->connect_req,
+                             &w->tcp_client,
+                             (const struct sockaddr*) &w->server_addr,
+                             connect_cb));
+}
+
+
+static void udp_server_recv_cb(uv_udp_t* handle,
+                               ssize_t nread,
+                               const uv_buf_t* buf,
+                               const struct sockaddr* addr,
+                               unsigned flags) {
+  uv_buf_t reply;
+
+  if (nread <= 0 || addr == NULL)
+    return;
+
+  reply = uv_buf_init(buf->base, nread);
+  ASSERT(nread == uv_udp_try_send(handle, &reply, 1, addr));
+}
+
+
+static void udp_client_send(worker_t* w) {
+  uv_buf_t msg;
+
+  msg = uv_buf_init(message, sizeof(message));
+  ASSERT(sizeof(message) ==
+         uv_udp_try_send(&w->udp_client,
+                         &msg,
+                         1,
+                         (const struct sockaddr*) &w->server_addr));
+}
+
+
+static void udp_client_recv_cb(uv_udp_t* handle,
+                               ssize_t nread,
+                               const uv_buf_t* buf,
+                               const struct sockaddr* addr,
+                               unsigned flags) {
+  worker_t* w;
+
+  if (nread <= 0 || addr == NULL)
+    return;
+
+  w = handle_worker((uv_handle_t*) handle);
+  w->ops++;
+
+  if (!w->stopped)
+    udp_client_send(w);
+}
+
+
+static void udp_echo_start(worker_t* w) {
+  struct sockaddr_in addr;
+  int len;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", 0, &addr));
+
+  ASSERT(0 == uv_udp_init(&w->loop, &w->udp_server));
+  ASSERT(0 == uv_udp_bind(&w->udp_server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_udp_recv_start(&w->udp_server, alloc_cb, udp_server_recv_cb));
+
+  len = sizeof(w->server_addr);
+  ASSERT(0 == uv_udp_getsockname(&w->udp_server,
+                                 (struct sockaddr*) &w->server_addr,
+                                 &len));
+
+  ASSERT(0 == uv_udp_init(&w->loop, &w->udp_client));
+  ASSERT(0 == uv_udp_bind(&w->udp_client, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_udp_recv_start(&w->udp_client, alloc_cb, udp_client_recv_cb));
+  udp_client_send(w);
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+}
+
+
+/* Every iteration (re)arms and cancels NUM_TIMERS timers, a heap workout. */
+static void timers_idle_cb(uv_idle_t* handle) {
+  worker_t* w;
+  int i;
+
+  w = handle_worker((uv_handle_t*) handle);
+
+  for (i = 0; i < NUM_TIMERS; i++)
+    ASSERT(0 == uv_timer_start(w->timers + i, timer_cb, 1000 + i * 7, 0));
+
+  for (i = 0; i < NUM_TIMERS; i += 2)
+    ASSERT(0 == uv_timer_stop(w->timers + i));
+
+  w->ops += NUM_TIMERS;
+}
+
+
+static void timers_start(worker_t* w) {
+  int i;
+
+  for (i = 0; i < NUM_TIMERS; i++)
+    ASSERT(0 == uv_timer_init(&w->loop, w->timers + i));
+
+  ASSERT(0 == uv_idle_init(&w->loop, &w->idle));
+  ASSERT(0 == uv_idle_start(&w->idle, timers_idle_cb));
+}
+
+
+static void fs_stat_cb(uv_fs_t* req) {
+  worker_t* w;
+
+  ASSERT(req->result == 0);
+  uv_fs_req_cleanup(req);
+
+  w = container_of(req->loop, worker_t, loop);
+  w->ops++;
+
+  if (!w->stopped)
+    ASSERT(0 == uv_fs_stat(req->loop, req, ".", fs_stat_cb));
+}
+
+
+static void fs_stat_start(worker_t* w) {
+  int i;
+
+  for (i = 0; i < MAX_CONCURRENT_REQS; i++)
+    ASSERT(0 == uv_fs_stat(&w->loop, w->fs_reqs + i, ".", fs_stat_cb));
+}
+
+
+static void signal_cb(uv_signal_t* handle, int signum) {
+}
+
+
+/* Every iteration starts and stops NUM_SIGNALS signal handles. */
+static void signals_idle_cb(uv_idle_t* handle) {
+  worker_t* w;
+  int i;
+
+  w = handle_worker((uv_handle_t*) handle);
+
+  for (i = 0; i < NUM_SIGNALS; i++)
+    ASSERT(0 == uv_signal_start(w->signals + i,
+                                signal_cb,
+                                i % 2 ? SIGHUP : SIGWINCH));
+
+  for (i = 0; i < NUM_SIGNALS; i++)
+    ASSERT(0 == uv_signal_stop(w->signals + i));
+
+  w->ops += NUM_SIGNALS;
+}
+
+
+static void signals_start(worker_t* w) {
+  int i;
+
+  for (i = 0; i < NUM_SIGNALS; i++)
+    ASSERT(0 == uv_signal_init(&w->loop, w->signals + i));
+
+  ASSERT(0 == uv_idle_init(&w->loop, &w->idle));
+  ASSERT(0 == uv_idle_start(&w->idle, signals_idle_cb));
+}
+
+
+static void spawn_next(worker_t* w);
+
+
+static void spawn_close_cb(uv_handle_t* handle) {
+  worker_t* w;
+
+  w = handle_worker(handle);
+  if (--w->spawn_pending > 0)
+    return;
+
+  w->ops++;
+  if (!w->stopped)
+    spawn_next(w);
+}
+
+
+static void spawn_exit_cb(uv_process_t* process,
+                          int64_t exit_status,
+                          int term_signal) {
+  ASSERT(exit_status == 42);
+  if (!uv_is_closing((uv_handle_t*) process))
+    uv_close((uv_handle_t*) process, spawn_close_cb);
+}
+
+
+static void spawn_read_cb(uv_stream_t* stream,
+                          ssize_t nread,
+                          const uv_buf_t* buf) {
+  if (nread < 0 && !uv_is_closing((uv_handle_t*) stream))
+    uv_close((uv_handle_t*) stream, spawn_close_cb);
+}
+
+
+static void spawn_next(worker_t* w) {
+  uv_process_options_t options;
+  uv_stdio_container_t stdio[2];
+  char* args[3];
+
+  args[0] = exepath;
+  args[1] = "spawn_helper";
+  args[2] = NULL;
+
+  memset(&options, 0, sizeof(options));
+  options.file = exepath;
+  options.args = args;
+  options.exit_cb = spawn_exit_cb;
+  options.stdio = stdio;
+  options.stdio_count = 2;
+  stdio[0].flags = UV_IGNORE;
+  stdio[1].flags = UV_CREATE_PIPE | UV_WRITABLE_PIPE;
+  stdio[1].data.stream = (uv_stream_t*) &w->out;
+
+  ASSERT(0 == uv_pipe_init(&w->loop, &w->out, 0));
+  ASSERT(0 == uv_spawn(&w->loop, &w->process, &options));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &w->out, alloc_cb, spawn_read_cb));
+  w->spawn_pending = 2;
+}
+
+
+static void worker_cb(void* arg) {
+  worker_t* w;
+
+  w = arg;
+  ASSERT(0 == uv_loop_init(&w->loop));
+  ASSERT(0 == uv_timer_init(&w->loop, &w->stop_timer));
+
+  switch (w->workload) {
+    case TCP_ECHO:
+      tcp_echo_start(w);
+      break;
+    case UDP_ECHO:
+      udp_echo_start(w);
+      break;
+    case TIMERS:
+      timers_start(w);
+      break;
+    case FS_STAT:
+      fs_stat_start(w);
+      break;
+    case SIGNALS:
+      signals_start(w);
+      break;
+    case SPAWN:
+      spawn_next(w);
+      break;
+  }
+
+  uv_barrier_wait(&start_barrier);
+  uv_update_time(&w->loop);
+  ASSERT(0 == uv_timer_start(&w->stop_timer, stop_cb, DURATION, 0));
+  ASSERT(0 == uv_run(&w->loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_close(&w->loop));
+}
+
+
+static double run_loops(workload_t workload, int nloops) {
+  uint64_t ops;
+  int i;
+
+  memset(workers, 0, sizeof(workers));
+  ASSERT(0 == uv_barrier_init(&start_barrier, nloops));
+
+  for (i = 0; i < nloops; i++) {
+    workers[i].workload = workload;
+    ASSERT(0 == uv_thread_create(&workers[i].thread, worker_cb, workers + i));
+  }
+
+  ops = 0;
+  for (i = 0; i < nloops; i++) {
+    ASSERT(0 == uv_thread_join(&workers[i].thread));
+    ops += workers[i].ops;
+  }
+
+  uv_barrier_destroy(&start_barrier);
+  return ops / (DURATION / 1000.);
+}
+
+
+static int scaling(workload_t workload, const char* name) {
+  uv_cpu_info_t* cpus;
+  char metric[32];
+  double per_loop;
+  double single;
+  double total;
+  size_t size;
+  int ncpus;
+  int nloops;
+
+  size = sizeof(exepath);
+  ASSERT(0 == uv_exepath(exepath, &size));
+  exepath[size] = '\0';
+
+  ASSERT(0 == uv_cpu_info(&cpus, &ncpus));
+  uv_free_cpu_info(cpus, ncpus);
+  if (ncpus > MAX_LOOPS)
+    ncpus = MAX_LOOPS;
+
+  single = 0;
+  nloops = 1;
+
+  for (;;) {
+    total = run_loops(workload, nloops);
+    per_loop = total / nloops;
+    if (nloops == 1)
+      single = per_loop;
+
+    fprintf(stderr,
+            "%s: %2d loops, %s ops/s, %s ops/s per loop, %.0f%% efficiency\n",
+            name,
+            nloops,
+            fmt(total),
+            fmt(per_loop),
+            100 * per_loop / single);
+    fflush(stderr);
+
+    snprintf(metric, sizeof(metric), "per_loop_%d", nloops);
+    benchmark_report(metric, per_loop, "ops/s");
+
+    if (nloops == ncpus)
+      break;
+
+    nloops *= 2;
+    if (nloops > ncpus)
+      nloops = ncpus;
+  }
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(scaling_tcp_echo) {
+  return scaling(TCP_ECHO, "scaling_tcp_echo");
+}
+
+
+BENCHMARK_IMPL(scaling_udp_echo) {
+  return scaling(UDP_ECHO, "scaling_udp_echo");
+}
+
+
+BENCHMARK_IMPL(scaling_timers) {
+  return scaling(TIMERS, "scaling_timers");
+}
+
+
+BENCHMARK_IMPL(scaling_fs_stat) {
+  return scaling(FS_STAT, "scaling_fs_stat");
+}
+
+
+BENCHMARK_IMPL(scaling_signals) {
+  return scaling(SIGNALS, "scaling_signals");
+}
+
+
+BENCHMARK_IMPL(scaling_spawn) {
+  return scaling(SPAWN, "scaling_spawn");
+}
@@ -158,6 +158,9 @@ BENCHMARK_IMPL(spawn) {
   fprintf(stderr, "spawn: %.0f spawns/s\n",
           (double) N / (double) (end_time - start_time) * 1000.0);
   fflush(stderr);
+  benchmark_report("spawns",
+                   (double) N / (double) (end_time - start_time) * 1000.0,
+                   "spawns/s");
 
   MAKE_VALGRIND_HAPPY();
   return 0;
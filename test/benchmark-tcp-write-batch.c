@@ -138,6 +138,7 @@ BENCHMARK_IMPL(tcp_write_batch) {
   printf("%ld write requests in %.2fs.\n",
          (long)NUM_WRITE_REQS,
          (stop - start) / 1e9);
+  benchmark_report("time", (stop - start) / 1e6, "ms");
 
   MAKE_VALGRIND_HAPPY();
   return 0;
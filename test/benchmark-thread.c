@@ -59,6 +59,7 @@ BENCHMARK_IMPL(thread_create) {
 
   printf("%d threads created in %.2f seconds (%.0f/s)\n",
       NUM_THREADS, duration, NUM_THREADS / duration);
+  benchmark_report("threads", NUM_THREADS / duration, "threads/s");
 
   return 0;
 }
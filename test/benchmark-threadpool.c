@@ -0,0 +1,417 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "task.h"
+#include "uv.h"
+#include "bench-harness.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_WORK_REQS 100000
+#define MAX_CONCURRENT_REQS 64
+#define MAX_LOOPS 8
+#define NUM_WAKEUPS 200
+#define NUM_QUEUED 10000
+
+struct work_req {
+  uv_work_t req;
+  uint64_t submitted;
+  uint64_t worked;
+};
+
+struct submitter {
+  uv_thread_t thread;
+  uv_loop_t loop;
+  struct work_req reqs[MAX_CONCURRENT_REQS];
+  int started;
+  int done;
+};
+
+static bench_histogram_t histogram;
+static struct work_req reqs[NUM_QUEUED];
+static uv_timer_t timer_handle;
+static uv_sem_t blocker_sem;
+static int work_done;
+
+
+/* Mirrors the sizing in src/threadpool.c. */
+static int pool_size(void) {
+  const char* val;
+  int n;
+
+  n = 4;
+  val = getenv("UV_THREADPOOL_SIZE");
+  if (val != NULL)
+    n = atoi(val);
+  if (n < 1)
+    n = 1;
+  if (n > 128)
+    n = 128;
+
+  return n;
+}
+
+
+static void report_histogram(const char* name, const char* what) {
+  double p50;
+  double p99;
+  double max;
+
+  p50 = bench_histogram_percentile(&histogram, 50) / 1e3;
+  p99 = bench_histogram_percentile(&histogram, 99) / 1e3;
+  max = histogram.max / 1e3;
+
+  fprintf(stderr,
+          "%s: %s %s, p50 %.1fus, p99 %.1fus, max %.1fus\n",
+          name,
+          fmt((double) histogram.total),
+          what,
+          p50,
+          p99,
+          max);
+  fflush(stderr);
+
+  benchmark_report("p50", p50, "us");
+  benchmark_report("p99", p99, "us");
+  benchmark_report("max", max, "us");
+}
+
+
+static void empty_work_cb(uv_work_t* req) {
+}
+
+
+static void stamp_work_cb(uv_work_t* req) {
+  struct work_req* w;
+
+  w = container_of(req, struct work_req, req);
+  w->worked = uv_hrtime();
+}
+
+
+/* uv_queue_work() to after_work_cb, one request at a time. */
+static void roundtrip_after_cb(uv_work_t* req, int status) {
+  struct work_req* w;
+
+  ASSERT(status == 0);
+  w = container_of(req, struct work_req, req);
+  bench_histogram_record(&histogram, uv_hrtime() - w->submitted);
+
+  if (++work_done == NUM_WORK_REQS)
+    return;
+
+  w->submitted = uv_hrtime();
+  ASSERT(0 == uv_queue_work(req->loop, req, empty_work_cb, roundtrip_after_cb));
+}
+
+
+BENCHMARK_IMPL(threadpool_roundtrip) {
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+  bench_histogram_reset(&histogram);
+  work_done = 0;
+
+  reqs[0].submitted = uv_hrtime();
+  ASSERT(0 == uv_queue_work(loop,
+                            &reqs[0].req,
+                            empty_work_cb,
+                            roundtrip_after_cb));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  report_histogram("threadpool_roundtrip", "round-trips");
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+/* 1..MAX_LOOPS loops on their own threads, each keeping MAX_CONCURRENT_REQS
+ * empty requests in flight.  All of them funnel through the global queue.
+ */
+static void throughput_after_cb(uv_work_t* req, int status) {
+  struct submitter* s;
+
+  ASSERT(status == 0);
+  s = container_of(req->loop, struct submitter, loop);
+  s->done++;
+
+  if (s->started < NUM_WORK_REQS) {
+    s->started++;
+    ASSERT(0 == uv_queue_work(req->loop,
+                              req,
+                              empty_work_cb,
+                              throughput_after_cb));
+  }
+}
+
+
+static void submitter_cb(void* arg) {
+  struct submitter* s;
+  int i;
+
+  s = arg;
+  ASSERT(0 == uv_loop_init(&s->loop));
+
+  for (i = 0; i < MAX_CONCURRENT_REQS; i++) {
+    s->started++;
+    ASSERT(0 == uv_queue_work(&s->loop,
+                              &s->reqs[i].req,
+                              empty_work_cb,
+                              throughput_after_cb));
+  }
+
+  ASSERT(0 == uv_run(&s->loop, UV_RUN_DEFAULT));
+  ASSERT(s->done == NUM_WORK_REQS);
+  ASSERT(0 == uv_loop_close(&s->loop));
+}
+
+
+BENCHMARK_IMPL(threadpool_throughput) {
+  struct submitter* submitters;
+  char metric[32];
+  uint64_t ns;
+  double rate;
+  int nloops;
+  int i;
+
+  submitters = malloc(MAX_LOOPS * sizeof(*submitters));
+  ASSERT(submitters != NULL);
+
+  for (nloops = 1; nloops <= MAX_LOOPS; nloops *= 2) {
+    memset(submitters, 0, MAX_LOOPS * sizeof(*submitters));
+
+    ns = uv_hrtime();
+    for (i = 0; i < nloops; i++)
+      ASSERT(0 == uv_thread_create(&submitters[i].thread,
+                                   submitter_cb,
+                                   submitters + i));
+    for (i = 0; i < nloops; i++)
+      ASSERT(0 == uv_thread_join(&submitters[i].thread));
+    ns = uv_hrtime() - ns;
+
+    rate = (double) nloops * NUM_WORK_REQS / (ns / 1e9);
+    fprintf(stderr,
+            "threadpool_throughput: %d loops, %s requests/s\n",
+            nloops,
+            fmt(rate));
+    fflush(stderr);
+
+    snprintf(metric, sizeof(metric), "loops_%d", nloops);
+    benchmark_report(metric, rate, "reqs/s");
+  }
+
+  free(submitters);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+/* Time from uv_queue_work() until a worker that has been idle for a while
+ * starts running the request.
+ */
+static void wakeup_timer_cb(uv_timer_t* handle);
+
+
+static void wakeup_after_cb(uv_work_t* req, int status) {
+  struct work_req* w;
+
+  ASSERT(status == 0);
+  w = container_of(req, struct work_req, req);
+  bench_histogram_record(&histogram, w->worked - w->submitted);
+
+  if (++work_done < NUM_WAKEUPS)
+    ASSERT(0 == uv_timer_start(&timer_handle, wakeup_timer_cb, 5, 0));
+}
+
+
+static void wakeup_timer_cb(uv_timer_t* handle) {
+  reqs[0].submitted = uv_hrtime();
+  ASSERT(0 == uv_queue_work(handle->loop,
+                            &reqs[0].req,
+                            stamp_work_cb,
+                            wakeup_after_cb));
+}
+
+
+BENCHMARK_IMPL(threadpool_wakeup) {
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+  bench_histogram_reset(&histogram);
+  work_done = 0;
+
+  ASSERT(0 == uv_timer_init(loop, &timer_handle));
+  ASSERT(0 == uv_timer_start(&timer_handle, wakeup_timer_cb, 5, 0));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(work_done == NUM_WAKEUPS);
+
+  report_histogram("threadpool_wakeup", "wakeups");
+
+  uv_close((uv_handle_t*) &timer_handle, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+/* uv_cancel() on requests queued behind a pool whose workers are all busy. */
+static void blocker_work_cb(uv_work_t* req) {
+  uv_sem_wait(&blocker_sem);
+}
+
+
+static void counting_after_cb(uv_work_t* req, int status) {
+  work_done++;
+}
+
+
+BENCHMARK_IMPL(threadpool_cancel) {
+  uv_work_t* blockers;
+  uv_loop_t* loop;
+  uint64_t ns;
+  int nthreads;
+  int i;
+
+  loop = uv_default_loop();
+  nthreads = pool_size();
+  work_done = 0;
+
+  blockers = malloc(nthreads * sizeof(*blockers));
+  ASSERT(blockers != NULL);
+  ASSERT(0 == uv_sem_init(&blocker_sem, 0));
+
+  for (i = 0; i < nthreads; i++)
+    ASSERT(0 == uv_queue_work(loop,
+                              blockers + i,
+                              blocker_work_cb,
+                              counting_after_cb));
+
+  for (i = 0; i < NUM_QUEUED; i++)
+    ASSERT(0 == uv_queue_work(loop,
+                              &reqs[i].req,
+                              empty_work_cb,
+                              counting_after_cb));
+
+  /* Newest first: the worst case when the request is far from the head. */
+  ns = uv_hrtime();
+  for (i = NUM_QUEUED - 1; i >= 0; i--)
+    ASSERT(0 == uv_cancel((uv_req_t*) &reqs[i].req));
+  ns = uv_hrtime() - ns;
+
+  for (i = 0; i < nthreads; i++)
+    uv_sem_post(&blocker_sem);
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(work_done == nthreads + NUM_QUEUED);
+
+  fprintf(stderr,
+          "threadpool_cancel: %s cancellations behind %d busy workers, "
+          "%.0fns each\n",
+          fmt(NUM_QUEUED),
+          nthreads,
+          (double) ns / NUM_QUEUED);
+  fflush(stderr);
+  benchmark_report("cancel", (double) ns / NUM_QUEUED, "ns");
+
+  uv_sem_destroy(&blocker_sem);
+  free(blockers);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+/* Completions coming back through the loop's wq_async: how long a finished
+ * request waits for its after_work_cb, and how many are delivered per wakeup.
+ * MAX_CONCURRENT_REQS requests are kept in flight, like threadpool_throughput
+ * does, so the numbers aren't those of draining one big burst.
+ */
+static unsigned int iterations;
+static int work_started;
+
+
+static void completion_after_cb(uv_work_t* req, int status) {
+  struct work_req* w;
+
+  ASSERT(status == 0);
+  w = container_of(req, struct work_req, req);
+  bench_histogram_record(&histogram, uv_hrtime() - w->worked);
+  work_done++;
+
+  if (work_started < NUM_WORK_REQS) {
+    work_started++;
+    ASSERT(0 == uv_queue_work(req->loop,
+                              req,
+                              stamp_work_cb,
+                              completion_after_cb));
+  }
+}
+
+
+static void count_iterations_cb(uv_check_t* handle) {
+  iterations++;
+}
+
+
+BENCHMARK_IMPL(threadpool_completion) {
+  uv_check_t check_handle;
+  uv_loop_t* loop;
+  int i;
+
+  loop = uv_default_loop();
+  bench_histogram_reset(&histogram);
+  work_done = 0;
+  work_started = 0;
+  iterations = 0;
+
+  ASSERT(0 == uv_check_init(loop, &check_handle));
+  ASSERT(0 == uv_check_start(&check_handle, count_iterations_cb));
+  uv_unref((uv_handle_t*) &check_handle);
+
+  for (i = 0; i < MAX_CONCURRENT_REQS; i++) {
+    work_started++;
+    ASSERT(0 == uv_queue_work(loop,
+                              &reqs[i].req,
+                              stamp_work_cb,
+                              completion_after_cb));
+  }
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(work_done == NUM_WORK_REQS);
+
+  report_histogram("threadpool_completion", "completions");
+  fprintf(stderr,
+          "threadpool_completion: %.1f completions per loop iteration\n",
+          (double) work_done / iterations);
+  fflush(stderr);
+  benchmark_report("batch", (double) work_done / iterations, "reqs");
+
+  uv_close((uv_handle_t*) &check_handle, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
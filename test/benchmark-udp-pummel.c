@@ -214,6 +214,8 @@ static int pummel(unsigned int n_senders,
          recv_cb_called,
          send_cb_called,
          duration / 1000.0);
+  benchmark_report("received", recv_cb_called / (duration / 1000.0), "dgrams/s");
+  benchmark_report("sent", send_cb_called / (duration / 1000.0), "dgrams/s");
 
   MAKE_VALGRIND_HAPPY();
   return 0;
@@ -0,0 +1,161 @@
+/* Copyright libuv project contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "task.h"
+#include "uv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+# include <sys/resource.h>
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
+/* Many loops that each watch a few file descriptors with high numbers.  With a
+ * flat watcher table every loop pays for a slot per file descriptor below the
+ * highest one it watches.
+ */
+#define NUM_LOOPS 64
+#define FDS_PER_LOOP 16
+#define NUM_ROUNDS 2000
+
+struct loop_ctx {
+  uv_loop_t loop;
+  uv_poll_t polls[FDS_PER_LOOP];
+  int fds[FDS_PER_LOOP];
+};
+
+static unsigned long events;
+
+
+static void poll_cb(uv_poll_t* handle, int status, int revents) {
+  ASSERT(status == 0);
+  ASSERT(revents & UV_READABLE);
+  events++;
+}
+
+
+BENCHMARK_IMPL(watcher_table_high_fd) {
+#ifdef _WIN32
+  RETURN_SKIP("Not supported on Windows.");
+#else
+  struct loop_ctx* ctxs;
+  struct loop_ctx* ctx;
+  uv_mem_stats_t stats;
+  struct rlimit lim;
+  uint64_t table_bytes;
+  size_t rss_before;
+  size_t rss_after;
+  uint64_t ns;
+  int round;
+  int top;
+  int sv[2];
+  int i;
+  int k;
+
+  /* Use the highest file descriptors the process is allowed to open. */
+  ASSERT(0 == getrlimit(RLIMIT_NOFILE, &lim));
+  if (lim.rlim_cur < lim.rlim_max) {
+    lim.rlim_cur = lim.rlim_max;
+    if (lim.rlim_cur > 1024 * 1024)
+      lim.rlim_cur = 1024 * 1024;
+    setrlimit(RLIMIT_NOFILE, &lim);
+    ASSERT(0 == getrlimit(RLIMIT_NOFILE, &lim));
+  }
+
+  if (lim.rlim_cur < 4 * NUM_LOOPS * FDS_PER_LOOP)
+    RETURN_SKIP("File descriptor limit too low.");
+
+  top = (int) lim.rlim_cur - 1;
+
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+  ASSERT(1 == write(sv[1], "x", 1));  /* Keep sv[0] readable. */
+
+  ctxs = calloc(NUM_LOOPS, sizeof(*ctxs));
+  ASSERT(ctxs != NULL);
+
+  ASSERT(0 == uv_resident_set_memory(&rss_before));
+
+  table_bytes = 0;
+  for (i = 0; i < NUM_LOOPS; i++) {
+    ctx = ctxs + i;
+    ASSERT(0 == uv_loop_init(&ctx->loop));
+    ASSERT(0 == uv_loop_configure(&ctx->loop, UV_LOOP_MEMORY_STATS));
+
+    for (k = 0; k < FDS_PER_LOOP; k++) {
+      ctx->fds[k] = top - (i * FDS_PER_LOOP + k);
+      ASSERT(ctx->fds[k] == dup2(sv[0], ctx->fds[k]));
+      ASSERT(0 == uv_poll_init(&ctx->loop, ctx->polls + k, ctx->fds[k]));
+      ASSERT(0 == uv_poll_start(ctx->polls + k, UV_READABLE, poll_cb));
+    }
+
+    ASSERT(0 == uv_loop_mem_stats(&ctx->loop, UV_MEM_WATCHERS, &stats));
+    table_bytes += stats.bytes;
+  }
+
+  ASSERT(0 == uv_resident_set_memory(&rss_after));
+
+  ns = uv_hrtime();
+  for (round = 0; round < NUM_ROUNDS; round++)
+    for (i = 0; i < NUM_LOOPS; i++)
+      uv_run(&ctxs[i].loop, UV_RUN_NOWAIT);
+  ns = uv_hrtime() - ns;
+
+  ASSERT(events > 0);
+
+  fprintf(stderr,
+          "watcher_table_high_fd: %d loops, %d fds each, highest fd %d\n",
+          NUM_LOOPS,
+          FDS_PER_LOOP,
+          top);
+  fprintf(stderr,
+          "  watcher table: %s bytes/loop, rss: %s bytes/loop\n",
+          fmt((double) (table_bytes / NUM_LOOPS)),
+          fmt((double) ((rss_after - rss_before) / NUM_LOOPS)));
+  fprintf(stderr,
+          "  %s poll events in %.2fs (%s/s)\n",
+          fmt((double) events),
+          ns / 1e9,
+          fmt(events / (ns / 1e9)));
+  fflush(stderr);
+  benchmark_report("table", (double) (table_bytes / NUM_LOOPS), "bytes");
+  benchmark_report("events", events / (ns / 1e9), "events/s");
+
+  for (i = 0; i < NUM_LOOPS; i++) {
+    ctx = ctxs + i;
+    for (k = 0; k < FDS_PER_LOOP; k++)
+      uv_close((uv_handle_t*) (ctx->polls + k), NULL);
+    ASSERT(0 == uv_run(&ctx->loop, UV_RUN_DEFAULT));
+    ASSERT(0 == uv_loop_close(&ctx->loop));
+    for (k = 0; k < FDS_PER_LOOP; k++)
+      ASSERT(0 == close(ctx->fds[k]));
+  }
+
+  free(ctxs);
+  ASSERT(0 == close(sv[0]));
+  ASSERT(0 == close(sv[1]));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "bench-harness.h"
 #include "runner.h"
 #include "task.h"
 
@@ -32,14 +33,32 @@
 static int maybe_run_test(int argc, char **argv);
 
 
+static int run_benchmark_part(const char* test, const char* part) {
+  int r;
+
+  bench_perf_start();
+  r = run_test_part(test, part);
+  bench_perf_stop();
+
+  return r;
+}
+
+
 int main(int argc, char **argv) {
   if (platform_init(argc, argv))
     return EXIT_FAILURE;
 
+  if (argc > 1 && strcmp(argv[1], "--compare") == 0)
+    return bench_compare_main(argc, argv);
+
+  if (argc > 1 && strncmp(argv[1], "--", 2) == 0 &&
+      strcmp(argv[1], "--list") != 0)
+    return bench_harness_main(argc, argv);
+
   switch (argc) {
   case 1: return run_tests(1);
   case 2: return maybe_run_test(argc, argv);
-  case 3: return run_test_part(argv[1], argv[2]);
+  case 3: return run_benchmark_part(argv[1], argv[2]);
   default:
     fprintf(stderr, "Too many arguments.\n");
     fflush(stderr);
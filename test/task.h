@@ -123,6 +123,12 @@ void uv_sleep(int msec);
 /* Format big numbers nicely. WARNING: leaks memory. */
 const char* fmt(double d);
 
+/* Publish a benchmark result for `./run-benchmarks --repeat=N` and friends.
+ * Units that end in "/s" are rates, higher is better; for everything else
+ * lower is better.  Prints nothing when not running under the harness.
+ */
+void benchmark_report(const char* metric, double value, const char* unit);
+
 /* Reserved test exit codes. */
 enum test_status {
   TEST_OK = 0,
@@ -0,0 +1,99 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "task.h"
+
+#ifndef _WIN32
+# include <poll.h>
+#endif
+
+static uv_async_t async_handle;
+static uv_timer_t timer_handle;
+static uv_check_t check_handle;
+static int async_cb_called;
+static int check_cb_called;
+
+
+static void async_cb(uv_async_t* handle) {
+  async_cb_called++;
+  uv_unref((uv_handle_t*) handle);
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  /* The loop is awake, the send is noticed without a wakeup.  The loop has
+   * nothing else to do and would block forever if it didn't check.
+   */
+  ASSERT(0 == uv_async_send(&async_handle));
+}
+
+
+static void check_cb(uv_check_t* handle) {
+  /* Sent after the poll phase, the send is still pending when uv_run()
+   * returns.
+   */
+  ASSERT(0 == uv_async_send(&async_handle));
+  uv_check_stop(handle);
+  check_cb_called++;
+}
+
+
+TEST_IMPL(async_wakeup) {
+  uv_loop_t* loop;
+#ifndef _WIN32
+  struct pollfd pfd;
+#endif
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_async_init(loop, &async_handle, async_cb));
+  ASSERT(0 == uv_timer_init(loop, &timer_handle));
+  ASSERT(0 == uv_timer_start(&timer_handle, timer_cb, 0, 0));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(1 == async_cb_called);
+
+  uv_ref((uv_handle_t*) &async_handle);
+  ASSERT(0 == uv_check_init(loop, &check_handle));
+  ASSERT(0 == uv_check_start(&check_handle, check_cb));
+  ASSERT(0 != uv_run(loop, UV_RUN_NOWAIT));
+  ASSERT(1 == check_cb_called);
+  ASSERT(1 == async_cb_called);
+
+#ifndef _WIN32
+  /* An embedder that polls the backend fd must see the pending send. */
+  pfd.fd = uv_backend_fd(loop);
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  ASSERT(1 == poll(&pfd, 1, 0));
+#endif
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(2 == async_cb_called);
+
+  uv_close((uv_handle_t*) &async_handle, NULL);
+  uv_close((uv_handle_t*) &timer_handle, NULL);
+  uv_close((uv_handle_t*) &check_handle, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -0,0 +1,117 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+static char order[64];
+static unsigned int norder;
+static uv_timer_t timer_handle;
+static uv_check_t check_handle;
+static int nested_calls;
+
+
+static void record(char c) {
+  ASSERT(norder < sizeof(order) - 1);
+  order[norder++] = c;
+}
+
+
+static void defer_cb(uv_loop_t* loop, void* arg) {
+  record(*(char*) arg);
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  record('T');
+}
+
+
+static void check_cb(uv_check_t* handle) {
+  record('C');
+  uv_check_stop(handle);
+}
+
+
+static void nested_cb(uv_loop_t* loop, void* arg) {
+  /* Deferring into the running phase queues for its next occurrence. */
+  if (++nested_calls < 3)
+    ASSERT(0 == uv_defer(loop, UV_DEFER_NEXT_ITERATION, nested_cb, arg));
+  record('0' + nested_calls);
+}
+
+
+TEST_IMPL(defer_phases) {
+#ifdef _WIN32
+  RETURN_SKIP("Not implemented on Windows.");
+#else
+  static char n = 'n';
+  static char t = 't';
+  static char p = 'p';
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+
+  ASSERT(UV_EINVAL == uv_defer(loop, UV_DEFER_AFTER_POLL, NULL, NULL));
+  ASSERT(UV_EINVAL == uv_defer(loop, (uv_defer_phase) 42, defer_cb, &n));
+
+  ASSERT(0 == uv_timer_init(loop, &timer_handle));
+  ASSERT(0 == uv_timer_start(&timer_handle, timer_cb, 0, 0));
+  ASSERT(0 == uv_check_init(loop, &check_handle));
+  ASSERT(0 == uv_check_start(&check_handle, check_cb));
+
+  ASSERT(0 == uv_defer(loop, UV_DEFER_AFTER_POLL, defer_cb, &p));
+  ASSERT(0 == uv_defer(loop, UV_DEFER_AFTER_TIMERS, defer_cb, &t));
+  ASSERT(0 == uv_defer(loop, UV_DEFER_NEXT_ITERATION, defer_cb, &n));
+  ASSERT(0 == uv_defer(loop, UV_DEFER_AFTER_TIMERS, defer_cb, &t));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(0 == strcmp(order, "nTttpC"));
+
+  /* Deferred callbacks keep the loop alive on their own, one iteration per
+   * deferral from the callback.
+   */
+  norder = 0;
+  memset(order, 0, sizeof(order));
+  ASSERT(0 == uv_defer(loop, UV_DEFER_NEXT_ITERATION, nested_cb, NULL));
+  ASSERT(0 != uv_run(loop, UV_RUN_NOWAIT));
+  ASSERT(0 == strcmp(order, "1"));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(0 == strcmp(order, "123"));
+  ASSERT(0 == uv_loop_alive(loop));
+
+  uv_close((uv_handle_t*) &timer_handle, NULL);
+  uv_close((uv_handle_t*) &check_handle, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  /* The loop can't be closed while callbacks are queued. */
+  ASSERT(0 == uv_defer(loop, UV_DEFER_AFTER_POLL, defer_cb, &p));
+  ASSERT(UV_EBUSY == uv_loop_close(loop));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(0 == strcmp(order, "123p"));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
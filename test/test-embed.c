@@ -135,6 +135,34 @@ static void embed_timer_cb(uv_timer_t* timer) {
 
   uv_close((uv_handle_t*) &embed_async, NULL);
 }
+
+
+static uv_work_t inline_work_req;
+static int inline_work_called;
+
+
+static void inline_work_cb(uv_work_t* req) {
+}
+
+
+static void inline_after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  inline_work_called++;
+}
+
+
+static void inline_timer_cb(uv_timer_t* timer) {
+  embed_timer_called++;
+
+  if (embed_timer_called == 1)
+    ASSERT(0 == uv_queue_work(timer->loop,
+                              &inline_work_req,
+                              inline_work_cb,
+                              inline_after_work_cb));
+
+  if (embed_timer_called == 3)
+    uv_close((uv_handle_t*) timer, NULL);
+}
 #endif
 
 
@@ -170,3 +198,40 @@ TEST_IMPL(embed) {
   RETURN_SKIP("Not supported in the current platform.");
 #endif
 }
+
+
+TEST_IMPL(embed_inline) {
+#if defined(HAVE_KQUEUE) || defined(HAVE_EPOLL) || defined(_WIN32)
+  uv_loop_t* loop;
+  uv_os_fd_t fd;
+  int timeout;
+  int alive;
+
+  loop = uv_default_loop();
+  embed_timer_called = 0;
+  inline_work_called = 0;
+
+  ASSERT(0 == uv_timer_init(loop, &embed_timer));
+  ASSERT(0 == uv_timer_start(&embed_timer, inline_timer_cb, 10, 10));
+
+  /* The host loop waits on the backend fd itself, no helper thread. */
+  fd = uv_backend_fd(loop);
+  do {
+    timeout = uv_loop_prepare(loop);
+#if defined(_WIN32)
+    embed_thread_poll_win(fd, timeout);
+#else
+    embed_thread_poll_unix(fd, timeout);
+#endif
+    alive = uv_loop_dispatch(loop);
+  } while (alive);
+
+  ASSERT(embed_timer_called == 3);
+  ASSERT(inline_work_called == 1);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#else
+  RETURN_SKIP("Not supported in the current platform.");
+#endif
+}
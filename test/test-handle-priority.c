@@ -0,0 +1,150 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "task.h"
+
+#ifndef _WIN32
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
+#define NPOLLS 4
+
+static uv_poll_t polls[NPOLLS];
+static int fds[NPOLLS][2];
+static int order[NPOLLS];
+static int poll_cb_called;
+
+
+static void poll_cb(uv_poll_t* handle, int status, int events) {
+  ASSERT(status == 0);
+  ASSERT(events == UV_READABLE);
+
+  order[poll_cb_called++] = (int) (handle - polls);
+  ASSERT(0 == uv_poll_stop(handle));
+}
+
+
+TEST_IMPL(handle_priority) {
+#ifndef __linux__
+  RETURN_SKIP("Priorities are only honored by the epoll backend.");
+#else
+  uv_timer_t timer;
+  uv_loop_t* loop;
+  int i;
+
+  loop = uv_default_loop();
+
+  for (i = 0; i < NPOLLS; i++) {
+    ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds[i]));
+    ASSERT(1 == write(fds[i][1], "x", 1));
+    ASSERT(0 == uv_poll_init(loop, &polls[i], fds[i][0]));
+    ASSERT(0 == uv_poll_start(&polls[i], UV_READABLE, poll_cb));
+  }
+
+  ASSERT(UV_PRIORITY_NORMAL ==
+         uv_handle_get_priority((uv_handle_t*) &polls[0]));
+  ASSERT(UV_EINVAL == uv_handle_set_priority((uv_handle_t*) &polls[0],
+                                             UV_PRIORITY_HIGH + 1));
+  ASSERT(0 == uv_timer_init(loop, &timer));
+  ASSERT(UV_EINVAL ==
+         uv_handle_set_priority((uv_handle_t*) &timer, UV_PRIORITY_HIGH));
+  uv_close((uv_handle_t*) &timer, NULL);
+
+  ASSERT(0 == uv_handle_set_priority((uv_handle_t*) &polls[0],
+                                     UV_PRIORITY_LOW));
+  ASSERT(0 == uv_handle_set_priority((uv_handle_t*) &polls[3],
+                                     UV_PRIORITY_HIGH));
+  ASSERT(UV_PRIORITY_HIGH ==
+         uv_handle_get_priority((uv_handle_t*) &polls[3]));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(poll_cb_called == NPOLLS);
+
+  /* All four are ready in the same poll, the normal ones go in between. */
+  ASSERT(order[0] == 3);
+  ASSERT(order[1] == 1 || order[1] == 2);
+  ASSERT(order[2] == 3 - order[1]);
+  ASSERT(order[3] == 0);
+
+  for (i = 0; i < NPOLLS; i++)
+    uv_close((uv_handle_t*) &polls[i], NULL);
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  for (i = 0; i < NPOLLS; i++) {
+    ASSERT(0 == close(fds[i][0]));
+    ASSERT(0 == close(fds[i][1]));
+  }
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
+
+
+TEST_IMPL(loop_poll_budget) {
+#ifndef __linux__
+  RETURN_SKIP("UV_LOOP_POLL_BUDGET is only implemented on Linux.");
+#else
+  uv_loop_t loop;
+  int i;
+
+  ASSERT(0 == uv_loop_init(&loop));
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_POLL_BUDGET, 1u));
+
+  for (i = 0; i < NPOLLS; i++) {
+    ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds[i]));
+    ASSERT(1 == write(fds[i][1], "x", 1));
+    ASSERT(0 == uv_poll_init(&loop, &polls[i], fds[i][0]));
+    ASSERT(0 == uv_poll_start(&polls[i], UV_READABLE, poll_cb));
+  }
+
+  ASSERT(0 == uv_handle_set_priority((uv_handle_t*) &polls[3],
+                                     UV_PRIORITY_HIGH));
+
+  /* The high priority handle doesn't count against the budget. */
+  ASSERT(0 != uv_run(&loop, UV_RUN_NOWAIT));
+  ASSERT(poll_cb_called == 2);
+  ASSERT(order[0] == 3);
+
+  /* The rest is picked up one per iteration. */
+  ASSERT(0 != uv_run(&loop, UV_RUN_NOWAIT));
+  ASSERT(poll_cb_called == 3);
+  ASSERT(0 == uv_run(&loop, UV_RUN_NOWAIT));
+  ASSERT(poll_cb_called == 4);
+
+  for (i = 0; i < NPOLLS; i++)
+    uv_close((uv_handle_t*) &polls[i], NULL);
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+
+  for (i = 0; i < NPOLLS; i++) {
+    ASSERT(0 == close(fds[i][0]));
+    ASSERT(0 == close(fds[i][1]));
+  }
+
+  ASSERT(0 == uv_loop_close(&loop));
+  return 0;
+#endif
+}
@@ -0,0 +1,161 @@
+/* Copyright libuv project contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#ifndef _WIN32
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
+static uv_timer_t timer_handle;
+static uv_idle_t idle_handle;
+static uv_pipe_t pipe_handle;
+static uv_handle_t* walked[8];
+static int nwalked;
+static char slab[64];
+static int walk_arg;
+
+
+static void busy_wait(uint64_t ms) {
+  uint64_t deadline;
+
+  deadline = uv_hrtime() + ms * 1000000;
+  while (uv_hrtime() < deadline);
+}
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  if (nread > 0)
+    uv_read_stop(stream);
+}
+
+
+static void idle_cb(uv_idle_t* handle) {
+  uv_idle_stop(handle);
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  busy_wait(20);
+}
+
+
+static void walk_cb(uv_handle_t* handle, void* arg) {
+  ASSERT(arg == &walk_arg);
+  ASSERT(nwalked < (int) ARRAY_SIZE(walked));
+  walked[nwalked++] = handle;
+}
+
+
+TEST_IMPL(handle_stats) {
+#ifdef _WIN32
+  uv_handle_stats_t stats;
+
+  ASSERT(0 == uv_timer_init(uv_default_loop(), &timer_handle));
+  ASSERT(UV_ENOSYS == uv_loop_configure(uv_default_loop(),
+                                        UV_LOOP_HANDLE_STATS,
+                                        1));
+  ASSERT(UV_ENOSYS == uv_handle_get_stats((uv_handle_t*) &timer_handle,
+                                          &stats));
+  uv_close((uv_handle_t*) &timer_handle, NULL);
+#else
+  uv_handle_stats_t stats;
+  uint64_t timer_calls;
+  uv_loop_t* loop;
+  int fds[2];
+
+  loop = uv_default_loop();
+
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  ASSERT(0 == uv_pipe_init(loop, &pipe_handle, 0));
+  ASSERT(0 == uv_pipe_open(&pipe_handle, fds[0]));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &pipe_handle, alloc_cb, read_cb));
+
+  ASSERT(0 == uv_timer_init(loop, &timer_handle));
+  ASSERT(0 == uv_timer_start(&timer_handle, timer_cb, 1, 1));
+  ASSERT(0 == uv_idle_init(loop, &idle_handle));
+  ASSERT(0 == uv_idle_start(&idle_handle, idle_cb));
+
+  /* Nothing is recorded until sampling is switched on. */
+  uv_run(loop, UV_RUN_NOWAIT);
+  ASSERT(0 == uv_handle_get_stats((uv_handle_t*) &idle_handle, &stats));
+  ASSERT(stats.calls == 0);
+
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_HANDLE_STATS, 1));
+  ASSERT(0 == uv_idle_start(&idle_handle, idle_cb));
+  ASSERT(5 == write(fds[1], "hello", 5));
+  while (uv_run(loop, UV_RUN_ONCE)) {
+    ASSERT(0 == uv_handle_get_stats((uv_handle_t*) &timer_handle, &stats));
+    if (stats.calls >= 3)
+      break;
+  }
+
+  /* UV_RUN_ONCE runs due timers twice per iteration, the busy timer can be
+   * called once more than asked for.
+   */
+  ASSERT(0 == uv_handle_get_stats((uv_handle_t*) &timer_handle, &stats));
+  ASSERT(stats.calls >= 3);
+  ASSERT(stats.time >= stats.calls * 20 * 1000000);
+  timer_calls = stats.calls;
+
+  ASSERT(0 == uv_handle_get_stats((uv_handle_t*) &idle_handle, &stats));
+  ASSERT(stats.calls == 1);
+  ASSERT(stats.time < 20 * 1000000);
+
+  ASSERT(0 == uv_handle_get_stats((uv_handle_t*) &pipe_handle, &stats));
+  ASSERT(stats.calls >= 1);
+  ASSERT(stats.bytes_read == 5);
+  ASSERT(stats.bytes_written == 0);
+
+  /* Most expensive handle first, handles without samples are skipped. */
+  ASSERT(0 == uv_walk_by_cost(loop, walk_cb, &walk_arg));
+  ASSERT(nwalked == 3);
+  ASSERT(walked[0] == (uv_handle_t*) &timer_handle);
+
+  /* Turning sampling off keeps the numbers, turning it on resets them. */
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_HANDLE_STATS, 0));
+  uv_run(loop, UV_RUN_ONCE);
+  ASSERT(0 == uv_handle_get_stats((uv_handle_t*) &timer_handle, &stats));
+  ASSERT(stats.calls == timer_calls);
+
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_HANDLE_STATS, 1));
+  ASSERT(0 == uv_handle_get_stats((uv_handle_t*) &timer_handle, &stats));
+  ASSERT(stats.calls == 0);
+  ASSERT(stats.time == 0);
+
+  uv_close((uv_handle_t*) &timer_handle, NULL);
+  uv_close((uv_handle_t*) &idle_handle, NULL);
+  uv_close((uv_handle_t*) &pipe_handle, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(0 == close(fds[1]));
+#endif
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
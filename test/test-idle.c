@@ -97,3 +97,84 @@ TEST_IMPL(idle_starvation) {
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+static uv_idle_t mutate_handles[40];
+static uv_idle_t mutate_extra;
+static int mutate_calls[40];
+static int mutate_extra_calls;
+
+
+static void mutate_extra_cb(uv_idle_t* handle) {
+  mutate_extra_calls++;
+}
+
+
+static void mutate_cb(uv_idle_t* handle) {
+  unsigned int i;
+
+  mutate_calls[handle - mutate_handles]++;
+
+  /* The first handle to run stops and restarts itself, stops or closes all
+   * others and starts a new one.  None of them may run again in this
+   * iteration.
+   */
+  for (i = 0; i < ARRAY_SIZE(mutate_handles); i++) {
+    if (&mutate_handles[i] == handle)
+      continue;
+    if (i % 2 == 0)
+      ASSERT(0 == uv_idle_stop(&mutate_handles[i]));
+    else if (!uv_is_closing((uv_handle_t*) &mutate_handles[i]))
+      uv_close((uv_handle_t*) &mutate_handles[i], NULL);
+  }
+
+  ASSERT(0 == uv_idle_stop(handle));
+  ASSERT(0 == uv_idle_start(handle, mutate_cb));
+  ASSERT(0 == uv_idle_start(&mutate_extra, mutate_extra_cb));
+}
+
+
+TEST_IMPL(idle_mutate_during_run) {
+  uv_loop_t* loop;
+  unsigned int i;
+  int total;
+
+  loop = uv_default_loop();
+
+  for (i = 0; i < ARRAY_SIZE(mutate_handles); i++) {
+    ASSERT(0 == uv_idle_init(loop, &mutate_handles[i]));
+    ASSERT(0 == uv_idle_start(&mutate_handles[i], mutate_cb));
+  }
+  ASSERT(0 == uv_idle_init(loop, &mutate_extra));
+
+  /* Stop and restart a few to leave holes behind. */
+  for (i = 0; i < ARRAY_SIZE(mutate_handles); i += 3)
+    ASSERT(0 == uv_idle_stop(&mutate_handles[i]));
+  for (i = 0; i < ARRAY_SIZE(mutate_handles); i += 3)
+    ASSERT(0 == uv_idle_start(&mutate_handles[i], mutate_cb));
+
+  ASSERT(0 != uv_run(loop, UV_RUN_NOWAIT));
+
+  total = 0;
+  for (i = 0; i < ARRAY_SIZE(mutate_handles); i++)
+    total += mutate_calls[i];
+  ASSERT(total == 1);
+  ASSERT(mutate_extra_calls == 0);
+
+  ASSERT(0 != uv_run(loop, UV_RUN_NOWAIT));
+
+  total = 0;
+  for (i = 0; i < ARRAY_SIZE(mutate_handles); i++)
+    total += mutate_calls[i];
+  ASSERT(total == 2);
+  ASSERT(mutate_extra_calls == 1);
+
+  for (i = 0; i < ARRAY_SIZE(mutate_handles); i++)
+    if (!uv_is_closing((uv_handle_t*) &mutate_handles[i]))
+      uv_close((uv_handle_t*) &mutate_handles[i], NULL);
+  uv_close((uv_handle_t*) &mutate_extra, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
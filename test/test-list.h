@@ -26,12 +26,26 @@ TEST_DECLARE   (callback_order)
 TEST_DECLARE   (close_order)
 TEST_DECLARE   (run_once)
 TEST_DECLARE   (run_nowait)
+TEST_DECLARE   (run_budget)
 TEST_DECLARE   (loop_alive)
 TEST_DECLARE   (loop_close)
 TEST_DECLARE   (loop_stop)
 TEST_DECLARE   (loop_update_time)
 TEST_DECLARE   (loop_backend_timeout)
+TEST_DECLARE   (loop_coarse_clock)
 TEST_DECLARE   (loop_configure)
+TEST_DECLARE   (loop_mem_stats)
+TEST_DECLARE   (loop_watchdog)
+TEST_DECLARE   (loop_trace)
+TEST_DECLARE   (loop_record)
+TEST_DECLARE   (loop_completion_queue)
+TEST_DECLARE   (loop_completion_queue_close)
+TEST_DECLARE   (loop_poll_budget)
+TEST_DECLARE   (loop_io_budget)
+TEST_DECLARE   (loop_io_budget_reads)
+TEST_DECLARE   (loop_io_budget_spent)
+TEST_DECLARE   (handle_stats)
+TEST_DECLARE   (handle_priority)
 TEST_DECLARE   (default_loop_close)
 TEST_DECLARE   (barrier_1)
 TEST_DECLARE   (barrier_2)
@@ -53,6 +67,7 @@ TEST_DECLARE   (tty_large_write)
 TEST_DECLARE   (tty_file)
 TEST_DECLARE   (tty_pty)
 TEST_DECLARE   (stdio_over_pipes)
+TEST_DECLARE   (stream_idle_timeout)
 TEST_DECLARE   (ip6_pton)
 #ifndef _WIN32
 TEST_DECLARE   (ip6_invalid_interface)
@@ -181,6 +196,8 @@ TEST_DECLARE   (timer_from_check)
 TEST_DECLARE   (timer_null_callback)
 TEST_DECLARE   (timer_early_check)
 TEST_DECLARE   (idle_starvation)
+TEST_DECLARE   (idle_mutate_during_run)
+TEST_DECLARE   (defer_phases)
 TEST_DECLARE   (loop_handles)
 TEST_DECLARE   (get_loadavg)
 TEST_DECLARE   (walk_handles)
@@ -215,8 +232,10 @@ TEST_DECLARE   (process_ref)
 TEST_DECLARE   (has_ref)
 TEST_DECLARE   (active)
 TEST_DECLARE   (embed)
+TEST_DECLARE   (embed_inline)
 TEST_DECLARE   (async)
 TEST_DECLARE   (async_null_cb)
+TEST_DECLARE   (async_wakeup)
 TEST_DECLARE   (eintr_handling)
 TEST_DECLARE   (get_currentexe)
 TEST_DECLARE   (process_title)
@@ -391,6 +410,10 @@ HELPER_DECLARE (udp4_echo_server)
 HELPER_DECLARE (pipe_echo_server)
 
 TEST_DECLARE   (queue_foreach_delete)
+TEST_DECLARE   (rate_limit_stream)
+TEST_DECLARE   (rate_limit_ipc)
+TEST_DECLARE   (rate_limit_udp)
+TEST_DECLARE   (rate_limit_read_stop)
 
 TASK_LIST_START
   TEST_ENTRY_CUSTOM (platform_output, 0, 1, 5000)
@@ -401,12 +424,26 @@ TASK_LIST_START
   TEST_ENTRY  (close_order)
   TEST_ENTRY  (run_once)
   TEST_ENTRY  (run_nowait)
+  TEST_ENTRY  (run_budget)
   TEST_ENTRY  (loop_alive)
   TEST_ENTRY  (loop_close)
   TEST_ENTRY  (loop_stop)
   TEST_ENTRY  (loop_update_time)
   TEST_ENTRY  (loop_backend_timeout)
+  TEST_ENTRY  (loop_coarse_clock)
   TEST_ENTRY  (loop_configure)
+  TEST_ENTRY  (loop_mem_stats)
+  TEST_ENTRY  (loop_watchdog)
+  TEST_ENTRY  (loop_trace)
+  TEST_ENTRY  (loop_record)
+  TEST_ENTRY  (loop_completion_queue)
+  TEST_ENTRY  (loop_completion_queue_close)
+  TEST_ENTRY  (loop_poll_budget)
+  TEST_ENTRY  (loop_io_budget)
+  TEST_ENTRY  (loop_io_budget_reads)
+  TEST_ENTRY  (loop_io_budget_spent)
+  TEST_ENTRY  (handle_stats)
+  TEST_ENTRY  (handle_priority)
   TEST_ENTRY  (default_loop_close)
   TEST_ENTRY  (barrier_1)
   TEST_ENTRY  (barrier_2)
@@ -441,6 +478,7 @@ TASK_LIST_START
   TEST_ENTRY  (tty_file)
   TEST_ENTRY  (tty_pty)
   TEST_ENTRY  (stdio_over_pipes)
+  TEST_ENTRY  (stream_idle_timeout)
   TEST_ENTRY  (ip6_pton)
 #ifndef _WIN32
   TEST_ENTRY  (ip6_invalid_interface)
@@ -613,6 +651,8 @@ TASK_LIST_START
   TEST_ENTRY  (timer_early_check)
 
   TEST_ENTRY  (idle_starvation)
+  TEST_ENTRY  (idle_mutate_during_run)
+  TEST_ENTRY  (defer_phases)
 
   TEST_ENTRY  (ref)
   TEST_ENTRY  (idle_ref)
@@ -652,9 +692,11 @@ TASK_LIST_START
   TEST_ENTRY  (active)
 
   TEST_ENTRY  (embed)
+  TEST_ENTRY  (embed_inline)
 
   TEST_ENTRY  (async)
   TEST_ENTRY  (async_null_cb)
+  TEST_ENTRY  (async_wakeup)
   TEST_ENTRY  (eintr_handling)
 
   TEST_ENTRY  (get_currentexe)
@@ -849,6 +891,10 @@ TASK_LIST_START
   TEST_ENTRY  (ip6_addr_link_local)
 
   TEST_ENTRY  (queue_foreach_delete)
+  TEST_ENTRY  (rate_limit_stream)
+  TEST_ENTRY  (rate_limit_ipc)
+  TEST_ENTRY  (rate_limit_udp)
+  TEST_ENTRY  (rate_limit_read_stop)
 
 #if 0
   /* These are for testing the test runner. */
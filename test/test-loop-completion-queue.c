@@ -0,0 +1,267 @@
+/* Copyright libuv project contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#ifndef _WIN32
+# include <sys/socket.h>
+#endif
+
+#ifndef _WIN32
+static uv_timer_t timer_handle;
+static uv_pipe_t pipe_handles[2];
+static uv_fs_poll_t poll_handle;
+static uv_write_t write_req;
+static uv_fs_t fs_req;
+static char slab[16];
+static int close_cb_called;
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  *buf = uv_buf_init(slab, sizeof(slab));
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  ASSERT(0 && "read_cb must not be called");
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(0 && "write_cb must not be called");
+}
+
+
+static void fs_cb(uv_fs_t* req) {
+  ASSERT(0 && "fs_cb must not be called");
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  ASSERT(0 && "timer_cb must not be called");
+}
+
+
+static void poll_cb(uv_fs_poll_t* handle,
+                    int status,
+                    const uv_stat_t* prev,
+                    const uv_stat_t* curr) {
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+  /* As if the handle were freed. */
+  memset(handle, 0xff, sizeof(*handle));
+  close_cb_called++;
+}
+#endif
+
+
+TEST_IMPL(loop_completion_queue) {
+#ifdef _WIN32
+  uv_completion_t c;
+
+  ASSERT(UV_ENOSYS == uv_loop_configure(uv_default_loop(),
+                                        UV_LOOP_COMPLETION_QUEUE,
+                                        16u));
+  ASSERT(UV_ENOSYS == uv_loop_drain(uv_default_loop(), &c, 1));
+#else
+  uv_completion_t out[2];
+  uv_loop_t* loop;
+  uv_buf_t buf;
+  int timers;
+  int reads;
+  int writes;
+  int stats;
+  int fds[2];
+  int n;
+  int i;
+
+  loop = uv_default_loop();
+  ASSERT(UV_EINVAL == uv_loop_drain(loop, out, 2));
+
+  /* Smaller than what gets queued, the ring has to grow. */
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_COMPLETION_QUEUE, 2u));
+
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  ASSERT(0 == uv_pipe_init(loop, &pipe_handles[0], 0));
+  ASSERT(0 == uv_pipe_init(loop, &pipe_handles[1], 0));
+  ASSERT(0 == uv_pipe_open(&pipe_handles[0], fds[0]));
+  ASSERT(0 == uv_pipe_open(&pipe_handles[1], fds[1]));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &pipe_handles[0],
+                            alloc_cb,
+                            read_cb));
+
+  buf = uv_buf_init("hello", 5);
+  ASSERT(0 == uv_write(&write_req,
+                       (uv_stream_t*) &pipe_handles[1],
+                       &buf,
+                       1,
+                       write_cb));
+  ASSERT(0 == uv_fs_stat(loop, &fs_req, ".", fs_cb));
+  ASSERT(0 == uv_timer_init(loop, &timer_handle));
+  ASSERT(0 == uv_timer_start(&timer_handle, timer_cb, 1, 1));
+
+  /* fs-poll's internal requests still get their callbacks. */
+  ASSERT(0 == uv_fs_poll_init(loop, &poll_handle));
+  ASSERT(0 == uv_fs_poll_start(&poll_handle, poll_cb, ".", 1));
+
+  timers = 0;
+  reads = 0;
+  writes = 0;
+  stats = 0;
+
+  while (timers < 3 || reads < 1 || writes < 1 || stats < 1) {
+    uv_run(loop, UV_RUN_ONCE);
+
+    while ((n = uv_loop_drain(loop, out, ARRAY_SIZE(out))) > 0) {
+      for (i = 0; i < n; i++) {
+        switch (out[i].kind) {
+          case UV_COMPLETION_TIMER:
+            ASSERT(out[i].object == &timer_handle);
+            timers++;
+            break;
+          case UV_COMPLETION_READ:
+            ASSERT(out[i].object == &pipe_handles[0]);
+            ASSERT(out[i].base == slab);
+            if (out[i].result != 0) {
+              ASSERT(out[i].result == 5);
+              ASSERT(0 == memcmp(slab, "hello", 5));
+              reads++;
+            }
+            break;
+          case UV_COMPLETION_WRITE:
+            ASSERT(out[i].object == &write_req);
+            ASSERT(out[i].result == 0);
+            writes++;
+            break;
+          case UV_COMPLETION_FS:
+            ASSERT(out[i].object == &fs_req);
+            ASSERT(out[i].result == 0);
+            ASSERT(fs_req.statbuf.st_mode != 0);
+            uv_fs_req_cleanup(&fs_req);
+            stats++;
+            break;
+          default:
+            ASSERT(0 && "unexpected completion");
+        }
+      }
+    }
+
+    ASSERT(n == 0);
+  }
+
+  ASSERT(reads == 1);
+  ASSERT(writes == 1);
+  ASSERT(stats == 1);
+
+  /* The mode can't be turned off while completions are pending. */
+  ASSERT(0 == uv_timer_start(&timer_handle, timer_cb, 0, 0));
+  uv_run(loop, UV_RUN_NOWAIT);
+  ASSERT(UV_EBUSY == uv_loop_configure(loop, UV_LOOP_COMPLETION_QUEUE, 0u));
+  ASSERT(1 == uv_loop_drain(loop, out, ARRAY_SIZE(out)));
+  ASSERT(out[0].kind == UV_COMPLETION_TIMER);
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_COMPLETION_QUEUE, 0u));
+  ASSERT(UV_EINVAL == uv_loop_drain(loop, out, 2));
+
+  uv_close((uv_handle_t*) &timer_handle, NULL);
+  uv_close((uv_handle_t*) &poll_handle, NULL);
+  uv_close((uv_handle_t*) &pipe_handles[0], NULL);
+  uv_close((uv_handle_t*) &pipe_handles[1], NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+#endif
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(loop_completion_queue_close) {
+#ifdef _WIN32
+  RETURN_SKIP("Not implemented on Windows.");
+#else
+  uv_completion_t out[4];
+  uv_loop_t* loop;
+  uv_buf_t buf;
+  int timers;
+  int reads;
+  int fds[2];
+  int n;
+  int i;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_COMPLETION_QUEUE, 4u));
+
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  ASSERT(0 == uv_pipe_init(loop, &pipe_handles[0], 0));
+  ASSERT(0 == uv_pipe_init(loop, &pipe_handles[1], 0));
+  ASSERT(0 == uv_pipe_open(&pipe_handles[0], fds[0]));
+  ASSERT(0 == uv_pipe_open(&pipe_handles[1], fds[1]));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &pipe_handles[0],
+                            alloc_cb,
+                            read_cb));
+  buf = uv_buf_init("hello", 5);
+  ASSERT(5 == uv_try_write((uv_stream_t*) &pipe_handles[1], &buf, 1));
+  ASSERT(0 == uv_timer_init(loop, &timer_handle));
+  ASSERT(0 == uv_timer_start(&timer_handle, timer_cb, 0, 0));
+
+  /* Leave the timer and read completions queued. */
+  uv_run(loop, UV_RUN_NOWAIT);
+
+  uv_close((uv_handle_t*) &timer_handle, close_cb);
+  uv_close((uv_handle_t*) &pipe_handles[0], close_cb);
+  uv_close((uv_handle_t*) &pipe_handles[1], NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(2 == close_cb_called);
+
+  timers = 0;
+  reads = 0;
+  n = uv_loop_drain(loop, out, ARRAY_SIZE(out));
+  for (i = 0; i < n; i++) {
+    ASSERT(out[i].object == NULL);
+    switch (out[i].kind) {
+      case UV_COMPLETION_TIMER:
+        timers++;
+        break;
+      case UV_COMPLETION_READ:
+        /* The buffer can still be released. */
+        ASSERT(out[i].base == slab);
+        ASSERT(out[i].result == 5);
+        reads++;
+        break;
+      default:
+        ASSERT(0 && "unexpected completion");
+    }
+  }
+
+  ASSERT(timers == 1);
+  ASSERT(reads == 1);
+  ASSERT(0 == uv_loop_drain(loop, out, ARRAY_SIZE(out)));
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_COMPLETION_QUEUE, 0u));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
@@ -0,0 +1,218 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#ifndef _WIN32
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
+#define DATA_SIZE 5000
+
+static uv_pipe_t readers[2];
+static int fds[2][2];
+static char storage[DATA_SIZE];
+static size_t small_buffers;
+static size_t nread_total[2];
+static uv_udp_t sender;
+static int idle_cb_called;
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  buf->base = storage;
+  buf->len = small_buffers ? small_buffers : sizeof(storage);
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  if (nread == 0)
+    return;
+
+  ASSERT(nread > 0);
+  nread_total[stream == (uv_stream_t*) &readers[1]] += nread;
+}
+
+
+static void idle_cb(uv_idle_t* handle) {
+  struct sockaddr_in addr;
+  uv_buf_t buf;
+
+  /* Uses up the byte budget before the loop polls. */
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  buf = uv_buf_init(storage, 1500);
+  ASSERT(1500 == uv_udp_try_send(&sender,
+                                 &buf,
+                                 1,
+                                 (const struct sockaddr*) &addr));
+  idle_cb_called++;
+}
+
+
+TEST_IMPL(loop_io_budget) {
+#ifdef _WIN32
+  RETURN_SKIP("Not implemented on Windows.");
+#else
+  uv_io_budget_t budget;
+  uv_loop_t loop;
+  char data[DATA_SIZE];
+  int i;
+
+  ASSERT(0 == uv_loop_init(&loop));
+
+  memset(&budget, 0, sizeof(budget));
+  budget.events_per_poll = 1025;
+  ASSERT(UV_EINVAL == uv_loop_configure(&loop, UV_LOOP_IO_BUDGET, &budget));
+  ASSERT(UV_EINVAL == uv_loop_configure(&loop,
+                                        UV_LOOP_IO_BUDGET,
+                                        (uv_io_budget_t*) NULL));
+
+  /* The first reader uses up the byte budget, the second one has to wait
+   * for the next iteration.
+   */
+  memset(&budget, 0, sizeof(budget));
+  budget.bytes = 1000;
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_IO_BUDGET, &budget));
+
+  memset(data, 'x', sizeof(data));
+  for (i = 0; i < 2; i++) {
+    ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds[i]));
+    ASSERT(sizeof(data) == write(fds[i][1], data, sizeof(data)));
+    ASSERT(0 == uv_pipe_init(&loop, &readers[i], 0));
+    ASSERT(0 == uv_pipe_open(&readers[i], fds[i][0]));
+    ASSERT(0 == uv_read_start((uv_stream_t*) &readers[i], alloc_cb, read_cb));
+  }
+
+  ASSERT(0 != uv_run(&loop, UV_RUN_NOWAIT));
+  ASSERT(nread_total[0] + nread_total[1] == DATA_SIZE);
+  ASSERT(0 != uv_run(&loop, UV_RUN_NOWAIT));
+  ASSERT(nread_total[0] == DATA_SIZE);
+  ASSERT(nread_total[1] == DATA_SIZE);
+
+  for (i = 0; i < 2; i++) {
+    uv_close((uv_handle_t*) &readers[i], NULL);
+    ASSERT(0 == close(fds[i][1]));
+  }
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_close(&loop));
+  return 0;
+#endif
+}
+
+
+TEST_IMPL(loop_io_budget_reads) {
+#ifdef _WIN32
+  RETURN_SKIP("Not implemented on Windows.");
+#else
+  uv_io_budget_t budget;
+  uv_loop_t loop;
+  char data[DATA_SIZE];
+  int i;
+
+  ASSERT(0 == uv_loop_init(&loop));
+
+  /* One read of 100 bytes per iteration for the first reader.  The second
+   * one uses the loop's default and drains its socket in one go.
+   */
+  memset(&budget, 0, sizeof(budget));
+  budget.reads_per_event = 32;
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_IO_BUDGET, &budget));
+  small_buffers = 100;
+
+  memset(data, 'x', sizeof(data));
+  for (i = 0; i < 2; i++) {
+    ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds[i]));
+    ASSERT(sizeof(data) == write(fds[i][1], data, sizeof(data)));
+    ASSERT(0 == uv_pipe_init(&loop, &readers[i], 0));
+    ASSERT(0 == uv_pipe_open(&readers[i], fds[i][0]));
+    ASSERT(0 == uv_read_start((uv_stream_t*) &readers[i], alloc_cb, read_cb));
+  }
+  ASSERT(0 == uv_handle_set_read_budget((uv_handle_t*) &readers[0], 1));
+
+  ASSERT(0 != uv_run(&loop, UV_RUN_NOWAIT));
+  ASSERT(nread_total[0] == 100);
+  ASSERT(nread_total[1] == 32 * 100);
+  ASSERT(0 != uv_run(&loop, UV_RUN_NOWAIT));
+  ASSERT(nread_total[0] == 200);
+  ASSERT(nread_total[1] == DATA_SIZE);
+
+  for (i = 0; i < 2; i++) {
+    uv_close((uv_handle_t*) &readers[i], NULL);
+    ASSERT(0 == close(fds[i][1]));
+  }
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_close(&loop));
+  return 0;
+#endif
+}
+
+
+TEST_IMPL(loop_io_budget_spent) {
+#ifdef _WIN32
+  RETURN_SKIP("Not implemented on Windows.");
+#else
+  uv_io_budget_t budget;
+  uv_idle_t idle;
+  uv_loop_t loop;
+  char data[DATA_SIZE];
+
+  ASSERT(0 == uv_loop_init(&loop));
+
+  memset(&budget, 0, sizeof(budget));
+  budget.bytes = 1000;
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_IO_BUDGET, &budget));
+  small_buffers = 100;
+
+  ASSERT(0 == uv_udp_init(&loop, &sender));
+  ASSERT(0 == uv_idle_init(&loop, &idle));
+  ASSERT(0 == uv_idle_start(&idle, idle_cb));
+
+  memset(data, 'x', sizeof(data));
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds[0]));
+  ASSERT(sizeof(data) == write(fds[0][1], data, sizeof(data)));
+  ASSERT(0 == uv_pipe_init(&loop, &readers[0], 0));
+  ASSERT(0 == uv_pipe_open(&readers[0], fds[0][0]));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &readers[0], alloc_cb, read_cb));
+
+  /* The budget is spent before every poll, the pipe still gets one read. */
+  ASSERT(0 != uv_run(&loop, UV_RUN_NOWAIT));
+  ASSERT(idle_cb_called == 1);
+  ASSERT(nread_total[0] == 100);
+  ASSERT(0 != uv_run(&loop, UV_RUN_NOWAIT));
+  ASSERT(idle_cb_called == 2);
+  ASSERT(nread_total[0] == 200);
+
+  uv_close((uv_handle_t*) &idle, NULL);
+  uv_close((uv_handle_t*) &sender, NULL);
+  uv_close((uv_handle_t*) &readers[0], NULL);
+  ASSERT(0 == close(fds[0][1]));
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_close(&loop));
+  return 0;
+#endif
+}
@@ -0,0 +1,130 @@
+/* Copyright libuv project contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#ifndef _WIN32
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
+static uv_pipe_t pipe_handle;
+static uv_write_t write_req;
+static uv_fs_t fs_req;
+static int write_cb_called;
+static int stat_cb_called;
+
+
+static void write_cb(uv_write_t* req, int status) {
+  uv_mem_stats_t stats;
+
+  ASSERT(req == &write_req);
+  ASSERT(status == 0);
+
+  /* The buffer list is released before the callback runs. */
+  ASSERT(0 == uv_loop_mem_stats(req->handle->loop,
+                                UV_MEM_WRITE_QUEUE,
+                                &stats));
+  ASSERT(stats.bytes == 0);
+  ASSERT(stats.count == 0);
+  ASSERT(stats.total_count == 1);
+  ASSERT(stats.peak_bytes == 8 * sizeof(uv_buf_t));
+
+  uv_close((uv_handle_t*) req->handle, NULL);
+  write_cb_called++;
+}
+
+
+static void stat_cb(uv_fs_t* req) {
+  uv_mem_stats_t stats;
+
+  ASSERT(req == &fs_req);
+  ASSERT(0 == uv_loop_mem_stats(NULL, UV_MEM_FS_PATHS, &stats));
+  ASSERT(stats.count >= 1);
+  ASSERT(stats.bytes >= sizeof("."));
+
+  uv_fs_req_cleanup(req);
+  stat_cb_called++;
+}
+
+
+TEST_IMPL(loop_mem_stats) {
+#ifdef _WIN32
+  uv_mem_stats_t stats;
+
+  ASSERT(UV_ENOSYS == uv_loop_configure(uv_default_loop(),
+                                        UV_LOOP_MEMORY_STATS));
+  ASSERT(UV_ENOSYS == uv_loop_mem_stats(uv_default_loop(),
+                                        UV_MEM_WATCHERS,
+                                        &stats));
+#else
+  uv_mem_stats_t stats;
+  uv_buf_t bufs[8];
+  uv_loop_t* loop;
+  char data[8];
+  int fds[2];
+  int i;
+
+  loop = uv_default_loop();
+
+  /* Accounting is opt-in. */
+  ASSERT(UV_EINVAL == uv_loop_mem_stats(loop, UV_MEM_WATCHERS, &stats));
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_MEMORY_STATS));
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_MEMORY_STATS));
+  ASSERT(UV_EINVAL == uv_loop_mem_stats(loop, UV_MEM_CATEGORY_MAX, &stats));
+  ASSERT(UV_EINVAL == uv_loop_mem_stats(NULL, UV_MEM_WATCHERS, &stats));
+
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  ASSERT(0 == uv_pipe_init(loop, &pipe_handle, 0));
+  ASSERT(0 == uv_pipe_open(&pipe_handle, fds[0]));
+
+  for (i = 0; i < (int) ARRAY_SIZE(bufs); i++)
+    bufs[i] = uv_buf_init(data + i, 1);
+
+  ASSERT(0 == uv_write(&write_req,
+                       (uv_stream_t*) &pipe_handle,
+                       bufs,
+                       ARRAY_SIZE(bufs),
+                       write_cb));
+
+  ASSERT(0 == uv_fs_stat(loop, &fs_req, ".", stat_cb));
+  ASSERT(0 == uv_loop_mem_stats(NULL, UV_MEM_FS_PATHS, &stats));
+  ASSERT(stats.total_count >= 1);
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(write_cb_called == 1);
+  ASSERT(stat_cb_called == 1);
+
+  /* The directory and the chunk with the low file descriptors. */
+  ASSERT(0 == uv_loop_mem_stats(loop, UV_MEM_WATCHERS, &stats));
+  ASSERT(stats.bytes > 0);
+  ASSERT(stats.count == 2);
+
+  ASSERT(0 == uv_loop_mem_stats(loop, UV_MEM_UDP_SEND_QUEUE, &stats));
+  ASSERT(stats.total_count == 0);
+
+  ASSERT(0 == close(fds[1]));
+#endif
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -0,0 +1,156 @@
+/* Copyright libuv project contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+# include <sys/socket.h>
+#endif
+
+#ifndef _WIN32
+static uv_timer_t timer_handle;
+static uv_pipe_t pipe_handles[2];
+static uv_write_t write_req;
+static uv_work_t work_req;
+static char read_buf[16];
+
+
+static void work_cb(uv_work_t* req) {
+}
+
+
+static void after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+}
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  *buf = uv_buf_init(read_buf, sizeof(read_buf));
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  ASSERT(nread == 5);
+  uv_close((uv_handle_t*) &pipe_handles[0], NULL);
+  uv_close((uv_handle_t*) &pipe_handles[1], NULL);
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  uv_buf_t buf;
+
+  buf = uv_buf_init("hello", 5);
+  ASSERT(0 == uv_write(&write_req,
+                       (uv_stream_t*) &pipe_handles[1],
+                       &buf,
+                       1,
+                       write_cb));
+  ASSERT(0 == uv_queue_work(handle->loop, &work_req, work_cb, after_work_cb));
+}
+#endif
+
+
+TEST_IMPL(loop_record) {
+#ifdef _WIN32
+  ASSERT(UV_ENOSYS == uv_loop_configure(uv_default_loop(),
+                                        UV_LOOP_RECORD,
+                                        stdout));
+#else
+  uv_record_t r;
+  uv_loop_t* loop;
+  uv_os_fd_t fd;
+  char magic[8];
+  int seen[UV_RECORD_REQ_CB + 1];
+  int fds[2];
+  FILE* fp;
+
+  loop = uv_default_loop();
+  fp = tmpfile();
+  ASSERT(fp != NULL);
+
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  ASSERT(0 == uv_pipe_init(loop, &pipe_handles[0], 0));
+  ASSERT(0 == uv_pipe_init(loop, &pipe_handles[1], 0));
+  ASSERT(0 == uv_pipe_open(&pipe_handles[0], fds[0]));
+  ASSERT(0 == uv_pipe_open(&pipe_handles[1], fds[1]));
+  ASSERT(0 == uv_fileno((uv_handle_t*) &pipe_handles[0], &fd));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &pipe_handles[0],
+                            alloc_cb,
+                            read_cb));
+
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_RECORD, fp));
+  ASSERT(0 == uv_timer_init(loop, &timer_handle));
+  ASSERT(0 == uv_timer_start(&timer_handle, timer_cb, 10, 0));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_RECORD, NULL));
+  ASSERT(0 == ferror(fp));
+
+  rewind(fp);
+  ASSERT(1 == fread(magic, sizeof(magic), 1, fp));
+  ASSERT(0 == memcmp(magic, UV_RECORD_MAGIC, sizeof(magic)));
+
+  memset(seen, 0, sizeof(seen));
+  while (1 == fread(&r, sizeof(r), 1, fp)) {
+    ASSERT(r.kind >= UV_RECORD_ITERATION && r.kind <= UV_RECORD_REQ_CB);
+    seen[r.kind]++;
+
+    if (r.kind == UV_RECORD_READ) {
+      ASSERT(r.fd == fd);
+      ASSERT(r.type == UV_NAMED_PIPE);
+      ASSERT(r.value == 5);
+    }
+
+    if (r.kind == UV_RECORD_WRITE)
+      ASSERT(r.value == 5);
+
+    if (r.kind == UV_RECORD_IO && r.fd == fd)
+      ASSERT(r.value & UV_READABLE);
+
+    if (r.kind == UV_RECORD_HANDLE_CB && r.type == UV_TIMER)
+      ASSERT(r.fd == -1);
+  }
+
+  ASSERT(seen[UV_RECORD_ITERATION] > 0);
+  ASSERT(seen[UV_RECORD_POLL] > 0);
+  ASSERT(seen[UV_RECORD_IO] > 0);
+  ASSERT(seen[UV_RECORD_READ] == 1);
+  ASSERT(seen[UV_RECORD_WRITE] == 1);
+  ASSERT(seen[UV_RECORD_HANDLE_CB] > 0);
+  ASSERT(seen[UV_RECORD_REQ_CB] > 0);
+  fclose(fp);
+
+  uv_close((uv_handle_t*) &timer_handle, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+#endif
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
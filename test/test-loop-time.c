@@ -61,3 +61,44 @@ TEST_IMPL(loop_backend_timeout) {
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+TEST_IMPL(loop_coarse_clock) {
+  uv_loop_t* loop;
+  uv_timer_t timer;
+  uint64_t before;
+  uint64_t start;
+  int r;
+
+  loop = uv_default_loop();
+  uv_update_time(loop);
+  before = uv_now(loop);
+
+  r = uv_loop_configure(loop, UV_LOOP_COARSE_CLOCK, 1);
+#if defined(__linux__)
+  ASSERT(r == 0);
+#endif
+  if (r == UV_ENOSYS)
+    RETURN_SKIP("No coarse clock on this platform.");
+  ASSERT(r == 0);
+
+  /* Switching clocks doesn't make the loop time go backwards. */
+  ASSERT(uv_now(loop) >= before);
+
+  ASSERT(0 == uv_timer_init(loop, &timer));
+  ASSERT(0 == uv_timer_start(&timer, cb, 50, 0));
+  start = uv_hrtime();
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  /* The timer can't fire early by more than the clock's granularity. */
+  ASSERT(uv_hrtime() - start >= 25 * 1000000);
+  ASSERT(uv_now(loop) - before >= 50);
+
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_COARSE_CLOCK, 0));
+  before = uv_now(loop);
+  uv_update_time(loop);
+  ASSERT(uv_now(loop) >= before);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
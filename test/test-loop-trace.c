@@ -0,0 +1,111 @@
+/* Copyright libuv project contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static uv_timer_t timer_handle;
+static uv_work_t work_req;
+static char dump[65536];
+
+
+static void work_cb(uv_work_t* req) {
+}
+
+
+static void after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  ASSERT(0 == uv_queue_work(handle->loop, &work_req, work_cb, after_work_cb));
+}
+
+
+static int count(const char* haystack, const char* needle) {
+  int n;
+
+  for (n = 0; (haystack = strstr(haystack, needle)) != NULL; n++)
+    haystack += strlen(needle);
+
+  return n;
+}
+
+
+static void read_dump(uv_loop_t* loop) {
+  size_t n;
+  FILE* fp;
+
+  fp = tmpfile();
+  ASSERT(fp != NULL);
+  ASSERT(0 == uv_loop_trace_dump(loop, fp));
+  rewind(fp);
+  n = fread(dump, 1, sizeof(dump) - 1, fp);
+  ASSERT(n > 0);
+  dump[n] = '\0';
+  fclose(fp);
+}
+
+
+TEST_IMPL(loop_trace) {
+#ifdef _WIN32
+  ASSERT(UV_ENOSYS == uv_loop_configure(uv_default_loop(), UV_LOOP_TRACE, 64u));
+  ASSERT(UV_ENOSYS == uv_loop_trace_dump(uv_default_loop(), stdout));
+#else
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+  ASSERT(UV_EINVAL == uv_loop_trace_dump(loop, stdout));
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_TRACE, 256u));
+
+  ASSERT(0 == uv_timer_init(loop, &timer_handle));
+  ASSERT(0 == uv_timer_start(&timer_handle, timer_cb, 10, 0));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  read_dump(loop);
+  ASSERT(strncmp(dump, "{\"traceEvents\":[", 16) == 0);
+  ASSERT(count(dump, "\"name\":\"iteration\"") > 0);
+  ASSERT(count(dump, "\"name\":\"poll\"") > 0);
+  ASSERT(count(dump, "\"name\":\"timer\"") == 1);
+  ASSERT(count(dump, "\"name\":\"work\"") == 1);
+
+  /* The ring buffer keeps only the most recent events. */
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_TRACE, 3u));
+  ASSERT(0 == uv_timer_start(&timer_handle, timer_cb, 10, 0));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  read_dump(loop);
+  ASSERT(count(dump, "\"ph\":\"X\"") == 4);
+
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_TRACE, 0u));
+  ASSERT(UV_EINVAL == uv_loop_trace_dump(loop, stdout));
+
+  uv_close((uv_handle_t*) &timer_handle, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+#endif
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
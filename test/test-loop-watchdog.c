@@ -0,0 +1,103 @@
+/* Copyright libuv project contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+static uv_timer_t timer_handle;
+static uv_work_t work_req;
+static uv_stall_info_t stalls[4];
+static int nstalls;
+
+
+static void stall_cb(uv_loop_t* loop, const uv_stall_info_t* info) {
+  /* Runs on the watchdog thread; uv_loop_watchdog_stop() joins it before
+   * the main thread looks at the results.
+   */
+  if (nstalls < (int) ARRAY_SIZE(stalls))
+    stalls[nstalls] = *info;
+  nstalls++;
+}
+
+
+static void work_cb(uv_work_t* req) {
+}
+
+
+static void after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  uv_sleep(200);
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  uv_sleep(200);
+  ASSERT(0 == uv_queue_work(handle->loop, &work_req, work_cb, after_work_cb));
+}
+
+
+TEST_IMPL(loop_watchdog) {
+#ifdef _WIN32
+  ASSERT(UV_ENOSYS == uv_loop_watchdog_start(uv_default_loop(),
+                                             50,
+                                             0,
+                                             stall_cb));
+  ASSERT(UV_ENOSYS == uv_loop_watchdog_stop(uv_default_loop()));
+#else
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+
+  ASSERT(UV_EINVAL == uv_loop_watchdog_start(loop, 0, 0, stall_cb));
+  ASSERT(UV_EINVAL == uv_loop_watchdog_start(loop, 50, 0, NULL));
+  ASSERT(UV_EINVAL == uv_loop_watchdog_start(loop, 50, -1, stall_cb));
+  ASSERT(0 == uv_loop_watchdog_stop(loop));
+
+  ASSERT(0 == uv_loop_watchdog_start(loop, 50, 0, stall_cb));
+  ASSERT(UV_EBUSY == uv_loop_watchdog_start(loop, 50, 0, stall_cb));
+
+  /* Waiting for the timer blocks in the backend and doesn't count. */
+  ASSERT(0 == uv_timer_init(loop, &timer_handle));
+  ASSERT(0 == uv_timer_start(&timer_handle, timer_cb, 150, 0));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  ASSERT(0 == uv_loop_watchdog_stop(loop));
+  ASSERT(nstalls == 2);
+
+  ASSERT(stalls[0].elapsed >= 50 * 1000000);
+  ASSERT(stalls[0].handle_type == UV_TIMER);
+  ASSERT(stalls[0].req_type == UV_UNKNOWN_REQ);
+  ASSERT(stalls[0].object == &timer_handle);
+  ASSERT(stalls[0].cb == (void (*)(void)) timer_cb);
+
+  ASSERT(stalls[1].elapsed >= 50 * 1000000);
+  ASSERT(stalls[1].handle_type == UV_UNKNOWN_HANDLE);
+  ASSERT(stalls[1].req_type == UV_WORK);
+  ASSERT(stalls[1].object == &work_req);
+  ASSERT(stalls[1].cb == (void (*)(void)) after_work_cb);
+
+  uv_close((uv_handle_t*) &timer_handle, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+#endif
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -0,0 +1,443 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#ifndef _WIN32
+# include <sys/socket.h>
+#endif
+
+#define WRITE_SIZE 20000
+#define DATAGRAMS 10
+#define DATAGRAM_SIZE 1000
+
+static uv_rate_limit_t write_limit;
+static uv_rate_limit_t read_limit;
+static uv_pipe_t readers[2];
+static uv_pipe_t writers[2];
+static uv_write_t write_reqs[2];
+static char write_data[WRITE_SIZE];
+static char storage[65536];
+static size_t nread_total[2];
+static int write_cb_called;
+static uint64_t start_time;
+static uint64_t write_done_time;
+static uint64_t read_done_time;
+
+static uv_udp_t client;
+static uv_udp_t server;
+static uv_udp_send_t send_reqs[DATAGRAMS];
+static int recv_cb_called;
+static int send_cb_called;
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  buf->base = storage;
+  buf->len = sizeof(storage);
+}
+
+
+static void close_all(void) {
+  int i;
+
+  for (i = 0; i < 2; i++) {
+    uv_close((uv_handle_t*) &readers[i], NULL);
+    uv_close((uv_handle_t*) &writers[i], NULL);
+  }
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  int i;
+
+  if (nread == 0)
+    return;
+
+  ASSERT(nread > 0);
+  i = stream == (uv_stream_t*) &readers[1];
+  nread_total[i] += nread;
+  ASSERT(nread_total[i] <= WRITE_SIZE);
+
+  /* The read limit doesn't hand out more than a bucketful at a time. */
+  if (i == 0)
+    ASSERT(nread <= 5000);
+
+  if (i == 0 && nread_total[i] == WRITE_SIZE)
+    read_done_time = uv_now(stream->loop);
+
+  if (nread_total[0] == WRITE_SIZE &&
+      nread_total[1] == WRITE_SIZE &&
+      write_cb_called == 2) {
+    close_all();
+  }
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+
+  write_cb_called++;
+  write_done_time = uv_now(req->handle->loop);
+}
+
+
+TEST_IMPL(rate_limit_stream) {
+#ifdef _WIN32
+  RETURN_SKIP("Not implemented on Windows.");
+#else
+  uv_loop_t* loop;
+  uv_buf_t buf;
+  int fds[2];
+  int i;
+
+  loop = uv_default_loop();
+
+  ASSERT(UV_EINVAL == uv_rate_limit_init(loop, &write_limit, 0, 10000));
+  ASSERT(UV_EINVAL == uv_rate_limit_init(loop, &write_limit, 100000, 0));
+
+  /* Both writers share one bucket: 40 kB at 100 kB/s with 10 kB up front. */
+  ASSERT(0 == uv_rate_limit_init(loop, &write_limit, 100000, 10000));
+  /* One reader gets 20 kB at 50 kB/s with 5 kB up front. */
+  ASSERT(0 == uv_rate_limit_init(loop, &read_limit, 50000, 5000));
+
+  memset(write_data, 'x', sizeof(write_data));
+  start_time = uv_now(loop);
+
+  for (i = 0; i < 2; i++) {
+    ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    ASSERT(0 == uv_pipe_init(loop, &readers[i], 0));
+    ASSERT(0 == uv_pipe_init(loop, &writers[i], 0));
+    ASSERT(0 == uv_pipe_open(&readers[i], fds[0]));
+    ASSERT(0 == uv_pipe_open(&writers[i], fds[1]));
+    ASSERT(0 == uv_stream_set_rate_limit((uv_stream_t*) &writers[i],
+                                         NULL,
+                                         &write_limit));
+    ASSERT(0 == uv_read_start((uv_stream_t*) &readers[i], alloc_cb, read_cb));
+
+    buf = uv_buf_init(write_data, sizeof(write_data));
+    ASSERT(0 == uv_write(&write_reqs[i],
+                         (uv_stream_t*) &writers[i],
+                         &buf,
+                         1,
+                         write_cb));
+  }
+
+  ASSERT(0 == uv_stream_set_rate_limit((uv_stream_t*) &readers[0],
+                                       &read_limit,
+                                       NULL));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  ASSERT(write_cb_called == 2);
+  ASSERT(nread_total[0] == WRITE_SIZE);
+  ASSERT(nread_total[1] == WRITE_SIZE);
+  ASSERT(write_done_time - start_time >= 250);
+  ASSERT(read_done_time - start_time >= 250);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
+
+
+static uv_tcp_t ipc_send_handle;
+static uv_tcp_t ipc_recv_handle;
+static int ipc_handles_received;
+
+
+static void ipc_read_cb(uv_stream_t* stream,
+                        ssize_t nread,
+                        const uv_buf_t* buf) {
+  uv_pipe_t* pipe;
+
+  if (nread == 0)
+    return;
+
+  ASSERT(nread > 0);
+  nread_total[0] += nread;
+  ASSERT(nread_total[0] <= WRITE_SIZE);
+
+  /* The handle is passed once, not with every chunk the limiter allows. */
+  pipe = (uv_pipe_t*) stream;
+  while (uv_pipe_pending_count(pipe) > 0) {
+    ASSERT(++ipc_handles_received == 1);
+    ASSERT(UV_TCP == uv_pipe_pending_type(pipe));
+    ASSERT(0 == uv_tcp_init(stream->loop, &ipc_recv_handle));
+    ASSERT(0 == uv_accept(stream, (uv_stream_t*) &ipc_recv_handle));
+  }
+
+  if (nread_total[0] == WRITE_SIZE && write_cb_called == 1) {
+    uv_close((uv_handle_t*) &readers[0], NULL);
+    uv_close((uv_handle_t*) &writers[0], NULL);
+    uv_close((uv_handle_t*) &ipc_send_handle, NULL);
+    uv_close((uv_handle_t*) &ipc_recv_handle, NULL);
+  }
+}
+
+
+TEST_IMPL(rate_limit_ipc) {
+#ifdef _WIN32
+  RETURN_SKIP("Not implemented on Windows.");
+#else
+  struct sockaddr_in addr;
+  uv_loop_t* loop;
+  uv_buf_t buf;
+  int fds[2];
+
+  loop = uv_default_loop();
+
+  /* 20 kB and a handle at 40 kB/s with 10 kB up front. */
+  ASSERT(0 == uv_rate_limit_init(loop, &write_limit, 40000, 10000));
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", 0, &addr));
+  ASSERT(0 == uv_tcp_init(loop, &ipc_send_handle));
+  ASSERT(0 == uv_tcp_bind(&ipc_send_handle,
+                          (const struct sockaddr*) &addr,
+                          0));
+
+  memset(write_data, 'x', sizeof(write_data));
+  start_time = uv_now(loop);
+
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  ASSERT(0 == uv_pipe_init(loop, &readers[0], 1));
+  ASSERT(0 == uv_pipe_init(loop, &writers[0], 1));
+  ASSERT(0 == uv_pipe_open(&readers[0], fds[0]));
+  ASSERT(0 == uv_pipe_open(&writers[0], fds[1]));
+  ASSERT(0 == uv_stream_set_rate_limit((uv_stream_t*) &writers[0],
+                                       NULL,
+                                       &write_limit));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &readers[0],
+                            alloc_cb,
+                            ipc_read_cb));
+
+  buf = uv_buf_init(write_data, sizeof(write_data));
+  ASSERT(0 == uv_write2(&write_reqs[0],
+                        (uv_stream_t*) &writers[0],
+                        &buf,
+                        1,
+                        (uv_stream_t*) &ipc_send_handle,
+                        write_cb));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  ASSERT(write_cb_called == 1);
+  ASSERT(nread_total[0] == WRITE_SIZE);
+  ASSERT(ipc_handles_received == 1);
+  ASSERT(write_done_time - start_time >= 250);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
+
+
+static void send_cb(uv_udp_send_t* req, int status) {
+  ASSERT(status == 0);
+  send_cb_called++;
+}
+
+
+static void recv_cb(uv_udp_t* handle,
+                    ssize_t nread,
+                    const uv_buf_t* buf,
+                    const struct sockaddr* addr,
+                    unsigned int flags) {
+  if (nread == 0)
+    return;
+
+  ASSERT(nread == DATAGRAM_SIZE);
+
+  if (++recv_cb_called == DATAGRAMS) {
+    uv_close((uv_handle_t*) &client, NULL);
+    uv_close((uv_handle_t*) &server, NULL);
+  }
+}
+
+
+TEST_IMPL(rate_limit_udp) {
+#ifdef _WIN32
+  RETURN_SKIP("Not implemented on Windows.");
+#else
+  struct sockaddr_in addr;
+  uv_loop_t* loop;
+  uv_buf_t buf;
+  int i;
+
+  loop = uv_default_loop();
+
+  /* 10 kB each way at 20 kB/s with 2 kB up front. */
+  ASSERT(0 == uv_rate_limit_init(loop, &write_limit, 20000, 2000));
+  ASSERT(0 == uv_rate_limit_init(loop, &read_limit, 20000, 2000));
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_udp_init(loop, &server));
+  ASSERT(0 == uv_udp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_udp_set_rate_limit(&server, &read_limit, NULL));
+  ASSERT(0 == uv_udp_recv_start(&server, alloc_cb, recv_cb));
+
+  ASSERT(0 == uv_udp_init(loop, &client));
+  ASSERT(0 == uv_udp_set_rate_limit(&client, NULL, &write_limit));
+
+  memset(write_data, 'x', DATAGRAM_SIZE);
+  buf = uv_buf_init(write_data, DATAGRAM_SIZE);
+  start_time = uv_now(loop);
+
+  for (i = 0; i < DATAGRAMS; i++)
+    ASSERT(0 == uv_udp_send(&send_reqs[i],
+                            &client,
+                            &buf,
+                            1,
+                            (const struct sockaddr*) &addr,
+                            send_cb));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  ASSERT(send_cb_called == DATAGRAMS);
+  ASSERT(recv_cb_called == DATAGRAMS);
+  ASSERT(uv_now(loop) - start_time >= 300);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
+
+
+static void stop_read_cb(uv_stream_t* stream,
+                         ssize_t nread,
+                         const uv_buf_t* buf) {
+  if (nread == 0)
+    return;
+
+  ASSERT(nread > 0);
+  nread_total[0] += nread;
+  ASSERT(nread_total[0] <= WRITE_SIZE);
+
+  if (nread_total[0] == WRITE_SIZE) {
+    uv_close((uv_handle_t*) &readers[0], NULL);
+    uv_close((uv_handle_t*) &writers[0], NULL);
+  }
+}
+
+
+static void unused_read_cb(uv_stream_t* stream,
+                           ssize_t nread,
+                           const uv_buf_t* buf) {
+  ASSERT(0 && "unused_read_cb must not be called");
+}
+
+
+static void unused_recv_cb(uv_udp_t* handle,
+                           ssize_t nread,
+                           const uv_buf_t* buf,
+                           const struct sockaddr* addr,
+                           unsigned int flags) {
+  ASSERT(0 && "unused_recv_cb must not be called");
+}
+
+
+TEST_IMPL(rate_limit_read_stop) {
+#ifdef _WIN32
+  RETURN_SKIP("Not implemented on Windows.");
+#else
+  struct sockaddr_in addr;
+  uv_loop_t* loop;
+  uv_buf_t buf;
+  int fds[2];
+
+  loop = uv_default_loop();
+
+  /* Half of the write goes out up front, the rest is parked. */
+  ASSERT(0 == uv_rate_limit_init(loop, &write_limit, 100000, 10000));
+
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  ASSERT(0 == uv_pipe_init(loop, &readers[0], 0));
+  ASSERT(0 == uv_pipe_init(loop, &writers[0], 0));
+  ASSERT(0 == uv_pipe_open(&readers[0], fds[0]));
+  ASSERT(0 == uv_pipe_open(&writers[0], fds[1]));
+  ASSERT(0 == uv_stream_set_rate_limit((uv_stream_t*) &writers[0],
+                                       NULL,
+                                       &write_limit));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &writers[0],
+                            alloc_cb,
+                            unused_read_cb));
+
+  memset(write_data, 'x', sizeof(write_data));
+  buf = uv_buf_init(write_data, sizeof(write_data));
+  ASSERT(0 == uv_write(&write_reqs[0],
+                       (uv_stream_t*) &writers[0],
+                       &buf,
+                       1,
+                       write_cb));
+  uv_run(loop, UV_RUN_NOWAIT);
+  ASSERT(write_cb_called == 0);
+
+  /* Not reading anymore, but the parked write keeps the handle active. */
+  ASSERT(0 == uv_read_stop((uv_stream_t*) &writers[0]));
+  ASSERT(uv_is_active((uv_handle_t*) &writers[0]));
+
+  ASSERT(0 == uv_read_start((uv_stream_t*) &readers[0],
+                            alloc_cb,
+                            stop_read_cb));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(write_cb_called == 1);
+  ASSERT(nread_total[0] == WRITE_SIZE);
+
+  /* Same for a datagram send parked behind the limit. */
+  ASSERT(0 == uv_rate_limit_init(loop, &write_limit, 20000, 1));
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_udp_init(loop, &client));
+  ASSERT(0 == uv_udp_set_rate_limit(&client, NULL, &write_limit));
+  ASSERT(0 == uv_udp_recv_start(&client, alloc_cb, unused_recv_cb));
+
+  memset(write_data, 'x', DATAGRAM_SIZE);
+  buf = uv_buf_init(write_data, DATAGRAM_SIZE);
+  ASSERT(0 == uv_udp_send(&send_reqs[0],
+                          &client,
+                          &buf,
+                          1,
+                          (const struct sockaddr*) &addr,
+                          send_cb));
+  ASSERT(0 == uv_udp_send(&send_reqs[1],
+                          &client,
+                          &buf,
+                          1,
+                          (const struct sockaddr*) &addr,
+                          send_cb));
+  uv_run(loop, UV_RUN_NOWAIT);
+  ASSERT(send_cb_called == 1);
+
+  ASSERT(0 == uv_udp_recv_stop(&client));
+  ASSERT(uv_is_active((uv_handle_t*) &client));
+
+  while (send_cb_called < 2)
+    uv_run(loop, UV_RUN_ONCE);
+
+  uv_close((uv_handle_t*) &client, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
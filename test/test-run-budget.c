@@ -0,0 +1,135 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#ifndef _WIN32
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
+#if defined(__linux__) ||                                                     \
+    defined(__APPLE__) ||                                                     \
+    defined(__DragonFly__) ||                                                 \
+    defined(__FreeBSD__) ||                                                   \
+    defined(__FreeBSD_kernel__) ||                                            \
+    defined(__OpenBSD__) ||                                                   \
+    defined(__NetBSD__)
+# define HAVE_BUDGET 1
+#endif
+
+#define NUM_PIPES 8
+
+#ifdef HAVE_BUDGET
+static uv_pipe_t pipes[NUM_PIPES];
+static int peers[NUM_PIPES];
+static int read_counts[NUM_PIPES];
+static int read_cb_called;
+static int last_read;
+static char slab[64];
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  *buf = uv_buf_init(slab, sizeof(slab));
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  uint64_t start;
+
+  if (nread <= 0)
+    return;
+
+  ASSERT(nread == 1);
+  last_read = (uv_pipe_t*) stream - pipes;
+  read_counts[last_read]++;
+  read_cb_called++;
+
+  /* Expensive callback, a single one exceeds the budget. */
+  start = uv_hrtime();
+  while (uv_hrtime() - start < 1000000);
+}
+
+
+static void feed(int i) {
+  ASSERT(1 == write(peers[i], "x", 1));
+}
+#endif
+
+
+TEST_IMPL(run_budget) {
+#if defined(_WIN32)
+  ASSERT(UV_ENOSYS == uv_run_budget(uv_default_loop(), 1000000));
+  return 0;
+#elif defined(HAVE_BUDGET)
+  uv_loop_t* loop;
+  int fds[2];
+  int i;
+
+  loop = uv_default_loop();
+
+  for (i = 0; i < NUM_PIPES; i++) {
+    ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    ASSERT(0 == uv_pipe_init(loop, &pipes[i], 0));
+    ASSERT(0 == uv_pipe_open(&pipes[i], fds[0]));
+    ASSERT(0 == uv_read_start((uv_stream_t*) &pipes[i], alloc_cb, read_cb));
+    peers[i] = fds[1];
+  }
+
+  /* Nothing to do, the budget doesn't make the loop wait. */
+  ASSERT(0 != uv_run_budget(loop, 100000000));
+  ASSERT(read_cb_called == 0);
+
+  for (i = 0; i < NUM_PIPES; i++)
+    feed(i);
+
+  /* One callback per call, and a pipe that is ready again right away doesn't
+   * get ahead of the ones that are still waiting.
+   */
+  for (i = 0; i < NUM_PIPES; i++) {
+    ASSERT(0 != uv_run_budget(loop, 100000));
+    ASSERT(read_cb_called == i + 1);
+    ASSERT(read_counts[last_read] == 1);
+    feed(last_read);
+  }
+
+  /* A big budget drains everything that's ready. */
+  ASSERT(0 != uv_run_budget(loop, 10000000000ull));
+  ASSERT(read_cb_called == 2 * NUM_PIPES);
+  for (i = 0; i < NUM_PIPES; i++)
+    ASSERT(read_counts[i] == 2);
+
+  for (i = 0; i < NUM_PIPES; i++) {
+    uv_close((uv_handle_t*) &pipes[i], NULL);
+    close(peers[i]);
+  }
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#else
+  RETURN_SKIP("Not supported on this platform.");
+#endif
+}
@@ -0,0 +1,148 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "task.h"
+
+#ifndef _WIN32
+# include <sys/socket.h>
+#endif
+
+#define IDLE_TIMEOUT 200
+#define WRITES 12
+
+static uv_pipe_t reader;
+static uv_pipe_t writer;
+static uv_timer_t write_timer;
+static uv_write_t write_req;
+static char storage[64];
+static uint64_t last_read;
+static uint64_t first_idle;
+static int writes;
+static int idle_cb_called;
+static int writer_idle_cb_called;
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  buf->base = storage;
+  buf->len = sizeof(storage);
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  ASSERT(nread > 0);
+  last_read = uv_now(stream->loop);
+}
+
+
+static void write_timer_cb(uv_timer_t* handle) {
+  uv_buf_t buf;
+
+  buf = uv_buf_init("x", 1);
+  ASSERT(0 == uv_write(&write_req, (uv_stream_t*) &writer, &buf, 1, NULL));
+
+  if (++writes == WRITES)
+    uv_timer_stop(handle);
+}
+
+
+static void writer_idle_cb(uv_stream_t* stream) {
+  ASSERT(stream == (uv_stream_t*) &writer);
+
+  /* Fires while the writes are still going on: they don't reset it. */
+  ASSERT(writes < WRITES);
+  writer_idle_cb_called++;
+  ASSERT(0 == uv_stream_set_idle_timeout(stream, 0, 0, NULL));
+}
+
+
+static void idle_cb(uv_stream_t* stream) {
+  uint64_t now;
+
+  ASSERT(stream == (uv_stream_t*) &reader);
+  ASSERT(writes == WRITES);
+
+  now = uv_now(stream->loop);
+  ASSERT(now - last_read >= IDLE_TIMEOUT);
+
+  if (++idle_cb_called == 1) {
+    first_idle = now;
+    return;
+  }
+
+  /* Called again one timeout later while the stream stays idle. */
+  ASSERT(now - first_idle >= IDLE_TIMEOUT);
+  ASSERT(0 == uv_stream_set_idle_timeout(stream, 0, 0, NULL));
+  uv_close((uv_handle_t*) &reader, NULL);
+  uv_close((uv_handle_t*) &writer, NULL);
+  uv_close((uv_handle_t*) &write_timer, NULL);
+}
+
+
+TEST_IMPL(stream_idle_timeout) {
+#ifdef _WIN32
+  RETURN_SKIP("Not implemented on Windows.");
+#else
+  uv_loop_t* loop;
+  int fds[2];
+
+  loop = uv_default_loop();
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  ASSERT(0 == uv_pipe_init(loop, &reader, 0));
+  ASSERT(0 == uv_pipe_init(loop, &writer, 0));
+  ASSERT(0 == uv_pipe_open(&reader, fds[0]));
+  ASSERT(0 == uv_pipe_open(&writer, fds[1]));
+
+  ASSERT(UV_EINVAL == uv_stream_set_idle_timeout((uv_stream_t*) &reader,
+                                                 4,
+                                                 IDLE_TIMEOUT,
+                                                 idle_cb));
+  ASSERT(UV_EINVAL == uv_stream_set_idle_timeout((uv_stream_t*) &reader,
+                                                 UV_IDLE_TIMEOUT_READ,
+                                                 IDLE_TIMEOUT,
+                                                 NULL));
+
+  /* Writes on the writer don't count for it: it's watched for reads only. */
+  ASSERT(0 == uv_stream_set_idle_timeout((uv_stream_t*) &writer,
+                                         UV_IDLE_TIMEOUT_READ,
+                                         IDLE_TIMEOUT,
+                                         writer_idle_cb));
+
+  ASSERT(0 == uv_stream_set_idle_timeout((uv_stream_t*) &reader,
+                                         UV_IDLE_TIMEOUT_READ,
+                                         IDLE_TIMEOUT,
+                                         idle_cb));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &reader, alloc_cb, read_cb));
+
+  /* Keep the reader busy for longer than the timeout. */
+  ASSERT(0 == uv_timer_init(loop, &write_timer));
+  ASSERT(0 == uv_timer_start(&write_timer, write_timer_cb, 50, 50));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(writes == WRITES);
+  ASSERT(idle_cb_called == 2);
+  ASSERT(writer_idle_cb_called == 1);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
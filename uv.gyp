@@ -73,6 +73,7 @@
         'include/uv/errno.h',
         'include/uv/threadpool.h',
         'include/uv/version.h',
+        'include/uv/coro.hpp',
         'src/fs-poll.c',
         'src/heap-inl.h',
         'src/inet.c',
@@ -144,19 +145,24 @@
             'include/uv/aix.h',
             'src/unix/async.c',
             'src/unix/atomic-ops.h',
+            'src/unix/completion.c',
             'src/unix/core.c',
+            'src/unix/defer.c',
             'src/unix/dl.c',
             'src/unix/fs.c',
             'src/unix/getaddrinfo.c',
             'src/unix/getnameinfo.c',
+            'src/unix/instrument.c',
             'src/unix/internal.h',
             'src/unix/loop.c',
             'src/unix/pipe.c',
             'src/unix/poll.c',
             'src/unix/process.c',
+            'src/unix/rate-limit.c',
             'src/unix/signal.c',
             'src/unix/spinlock.h',
             'src/unix/stream.c',
+            'src/unix/stream-idle.c',
             'src/unix/tcp.c',
             'src/unix/thread.c',
             'src/unix/tty.c',
@@ -324,6 +330,30 @@
             'src/unix/os390-syscalls.c'
           ]
         }],
+        # Profile-guided optimization, see "Optimized builds" in README.md.
+        ['uv_pgo=="generate"', {
+          'cflags': [
+            '-fprofile-generate=<(uv_pgo_dir)',
+            '-fprofile-update=atomic',
+          ],
+          'ldflags': [ '-fprofile-generate=<(uv_pgo_dir)' ],
+          'link_settings': {
+            'ldflags': [ '-fprofile-generate=<(uv_pgo_dir)' ],
+          },
+        }],
+        ['uv_pgo=="use"', {
+          'cflags': [
+            '-fprofile-use=<(uv_pgo_dir)',
+            '-fprofile-correction',
+            '-Wno-missing-profile',
+            '-flto',
+            '-ffat-lto-objects',
+          ],
+          'ldflags': [ '-flto' ],
+          'link_settings': {
+            'ldflags': [ '-flto' ],
+          },
+        }],
       ]
     },
 
@@ -342,6 +372,7 @@
         'test/test-active.c',
         'test/test-async.c',
         'test/test-async-null-cb.c',
+        'test/test-async-wakeup.c',
         'test/test-callback-stack.c',
         'test/test-callback-order.c',
         'test/test-close-fd.c',
@@ -349,6 +380,7 @@
         'test/test-connection-fail.c',
         'test/test-cwd-and-chdir.c',
         'test/test-default-loop-close.c',
+        'test/test-defer.c',
         'test/test-delayed-accept.c',
         'test/test-eintr-handling.c',
         'test/test-error.c',
@@ -366,6 +398,8 @@
         'test/test-getnameinfo.c',
         'test/test-getsockname.c',
         'test/test-handle-fileno.c',
+        'test/test-handle-priority.c',
+        'test/test-handle-stats.c',
         'test/test-homedir.c',
         'test/test-hrtime.c',
         'test/test-idle.c',
@@ -376,9 +410,15 @@
         'test/test-loop-handles.c',
         'test/test-loop-alive.c',
         'test/test-loop-close.c',
+        'test/test-loop-completion-queue.c',
+        'test/test-loop-io-budget.c',
         'test/test-loop-stop.c',
+        'test/test-loop-record.c',
+        'test/test-loop-trace.c',
         'test/test-loop-time.c',
         'test/test-loop-configure.c',
+        'test/test-loop-mem-stats.c',
+        'test/test-loop-watchdog.c',
         'test/test-walk-handles.c',
         'test/test-watcher-cross-stop.c',
         'test/test-multiple-listen.c',
@@ -402,7 +442,9 @@
         'test/test-poll-closesocket.c',
         'test/test-process-title.c',
         'test/test-queue-foreach-delete.c',
+        'test/test-rate-limit.c',
         'test/test-ref.c',
+        'test/test-run-budget.c',
         'test/test-run-nowait.c',
         'test/test-run-once.c',
         'test/test-semaphore.c',
@@ -413,6 +455,7 @@
         'test/test-signal-multiple-loops.c',
         'test/test-socket-buffer-size.c',
         'test/test-spawn.c',
+        'test/test-stream-idle-timeout.c',
         'test/test-fs-poll.c',
         'test/test-stdio-over-pipes.c',
         'test/test-tcp-alloc-cb-fail.c',
@@ -534,23 +577,34 @@
       'type': 'executable',
       'dependencies': [ 'libuv' ],
       'sources': [
+        'test/bench-harness.c',
+        'test/bench-harness.h',
         'test/benchmark-async.c',
         'test/benchmark-async-pummel.c',
+        'test/benchmark-defer.c',
         'test/benchmark-fs-stat.c',
+        'test/benchmark-fs-throughput.c',
         'test/benchmark-getaddrinfo.c',
+        'test/benchmark-latency.c',
         'test/benchmark-list.h',
         'test/benchmark-loop-count.c',
+        'test/benchmark-loop-watchers.c',
         'test/benchmark-million-async.c',
+        'test/benchmark-million-connections.c',
         'test/benchmark-million-timers.c',
         'test/benchmark-multi-accept.c',
         'test/benchmark-ping-pongs.c',
         'test/benchmark-pound.c',
         'test/benchmark-pump.c',
+        'test/benchmark-replay.c',
+        'test/benchmark-scaling.c',
         'test/benchmark-sizes.c',
         'test/benchmark-spawn.c',
         'test/benchmark-thread.c',
+        'test/benchmark-threadpool.c',
         'test/benchmark-tcp-write-batch.c',
         'test/benchmark-udp-pummel.c',
+        'test/benchmark-watcher-table.c',
         'test/dns-server.c',
         'test/echo-server.c',
         'test/blackhole-server.c',